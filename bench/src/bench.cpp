@@ -0,0 +1,1037 @@
+#include <cstdio>  // std::remove
+#include <cstdlib> // EXIT_SUCCESS, std::strtod, std::strtoul
+#include <random>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h> // getrusage
+#endif // __unix__ || __APPLE__
+
+#include "materialist.hpp"
+
+// headless scenarios for catching performance regressions; run it on a
+// fixed driver (e.g. lavapipe through VK_ICD_FILENAMES) and diff the JSON
+// between versions
+
+namespace /* anonymous */ {
+
+constexpr auto BENCH_PIPELINE_CACHE_PATH = "materialist_bench.pipeline_cache";
+constexpr auto BENCH_MESH_PATH           = "materialist_bench.mesh";
+constexpr auto BENCH_GLTF_PATH           = "materialist_bench.gltf";
+constexpr auto BENCH_GLTF_BUFFER_PATH    = "materialist_bench.bin";
+constexpr auto BENCH_BC7_PATH            = "materialist_bench_bc7.ktx2";
+constexpr auto BENCH_RGBA8_PATH          = "materialist_bench_rgba8.ktx2";
+
+struct options {
+    uint32_t    runs   = 5;
+    uint32_t    frames = 300;
+    uint32_t    width  = 800;
+    uint32_t    height = 600;
+    std::string output = "materialist_bench.json";
+};
+
+struct measurement {
+    std::string   name;
+    std::string   unit;
+    sample_window samples;
+};
+
+std::optional<unsigned long>
+option_value(std::string_view arg, std::string_view name) noexcept
+{
+    if (arg.substr(0, name.size()) != name) { return std::nullopt; }
+
+    return std::strtoul(arg.data() + name.size(), nullptr, 10);
+}
+
+options
+parse_options(int argc, char** argv) noexcept
+{
+    options opts;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+
+        if (auto runs = option_value(arg, "--runs=")) {
+            opts.runs = std::max(gsl::narrow<uint32_t>(*runs), 2u);
+        } else if (auto frames = option_value(arg, "--frames=")) {
+            opts.frames = gsl::narrow<uint32_t>(*frames);
+        } else if (auto width = option_value(arg, "--width=")) {
+            opts.width = gsl::narrow<uint32_t>(*width);
+        } else if (auto height = option_value(arg, "--height=")) {
+            opts.height = gsl::narrow<uint32_t>(*height);
+        } else if (arg.substr(0, 9) == "--output=") {
+            opts.output = std::string(arg.substr(9));
+        } else {
+            spdlog::warn("unknown option {}", arg);
+        }
+    }
+
+    return opts;
+}
+
+double
+elapsed_ms(std::chrono::steady_clock::time_point start) noexcept
+{
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void
+initialize_headless(vulkan::context& ctx, const options& opts) noexcept
+{
+    ctx.headless            = true;
+    ctx.pipeline_cache_path = BENCH_PIPELINE_CACHE_PATH;
+    vulkan::initialize(
+        ctx, gsl::narrow<int>(opts.width), gsl::narrow<int>(opts.height));
+}
+
+// the first run starts without a pipeline cache on disk, the others reuse
+// the one saved by their predecessor; driver-internal caches may still make
+// the "cold" run warmer than a first launch
+void
+bench_startup(const options& opts, std::vector<measurement>& results) noexcept
+{
+    measurement cold{"startup_cold", "ms", sample_window()};
+    measurement warm{"startup_warm", "ms", sample_window()};
+
+    std::remove(BENCH_PIPELINE_CACHE_PATH);
+
+    for (uint32_t run = 0; run != opts.runs; ++run) {
+        vulkan::context ctx;
+
+        const auto start = std::chrono::steady_clock::now();
+        initialize_headless(ctx, opts);
+        (run == 0 ? cold : warm).samples.add(elapsed_ms(start));
+
+        ctx.device->waitIdle();
+        vulkan::save_pipeline_cache(ctx);
+    }
+
+    results.push_back(std::move(cold));
+    results.push_back(std::move(warm));
+}
+
+// pointer-chasing baseline for bench_scene_graph: a heap node per scene
+// node with glm matrices, updated recursively from the root
+struct aos_node {
+    glm::mat4 local;
+    glm::mat4 world;
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+    glm::vec3 world_min;
+    glm::vec3 world_max;
+
+    std::vector<std::unique_ptr<aos_node>> children;
+};
+
+glm::mat4
+to_glm(const scene::affine& m) noexcept
+{
+    // scene::affine is row-major, glm column-major
+    glm::mat4 result(1.f);
+    for (int r = 0; r != 3; ++r) {
+        for (int c = 0; c != 4; ++c) { result[c][r] = m[size_t(r * 4 + c)]; }
+    }
+    return result;
+}
+
+std::unique_ptr<aos_node>
+make_aos_node(const scene::affine& local) noexcept
+{
+    auto n        = std::make_unique<aos_node>();
+    n->local      = to_glm(local);
+    n->bounds_min = glm::vec3(-.5f);
+    n->bounds_max = glm::vec3(.5f);
+
+    return n;
+}
+
+void
+update_aos(aos_node& n, const glm::mat4& parent) noexcept
+{
+    n.world = parent * n.local;
+
+    n.world_min = glm::vec3(std::numeric_limits<float>::max());
+    n.world_max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (int corner = 0; corner != 8; ++corner) {
+        const glm::vec3 p(
+            corner & 1 ? n.bounds_max.x : n.bounds_min.x,
+            corner & 2 ? n.bounds_max.y : n.bounds_min.y,
+            corner & 4 ? n.bounds_max.z : n.bounds_min.z);
+        const auto w = glm::vec3(n.world * glm::vec4(p, 1.f));
+        n.world_min  = glm::min(n.world_min, w);
+        n.world_max  = glm::max(n.world_max, w);
+    }
+
+    for (auto& child : n.children) { update_aos(*child, n.world); }
+}
+
+// a root with GROUP_COUNT groups of LEAF_COUNT leaves each; "full" moves the
+// root, so every node is recomputed, "incremental" moves one group
+void
+bench_scene_graph(
+    const options& opts, std::vector<measurement>& results) noexcept
+{
+    constexpr uint32_t GROUP_COUNT = 100;
+    constexpr uint32_t LEAF_COUNT  = 1'000;
+    constexpr uint32_t NODE_COUNT  = 1 + GROUP_COUNT * (1 + LEAF_COUNT);
+
+    const scene::aabb box  = {{-.5f, -.5f, -.5f}, {.5f, .5f, .5f}};
+    const auto        spin = [](float angle) {
+        const auto c = std::cos(angle);
+        const auto s = std::sin(angle);
+        return scene::affine{
+            c, -s, 0.f, 1.f, s, c, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+    };
+
+    scene::hierarchy soa;
+    soa.reserve(NODE_COUNT);
+    const auto root = soa.add(scene::NO_PARENT, spin(0.f), box);
+    auto       aos  = make_aos_node(spin(0.f));
+
+    std::vector<uint32_t> groups;
+    for (uint32_t g = 0; g != GROUP_COUNT; ++g) {
+        const auto local = spin(float(g));
+        groups.push_back(soa.add(root, local, box));
+        auto& group = *aos->children.emplace_back(make_aos_node(local));
+
+        for (uint32_t l = 0; l != LEAF_COUNT; ++l) {
+            const auto leaf = spin(float(l) * .01f);
+            soa.add(groups.back(), leaf, box);
+            group.children.push_back(make_aos_node(leaf));
+        }
+    }
+    soa.update();
+
+    const auto name = fmt::format("scene_graph_{}_nodes", NODE_COUNT);
+    measurement full{name + "_full", "ms", sample_window()};
+    measurement full_aos{name + "_full_aos", "ms", sample_window()};
+    measurement incremental{name + "_incremental", "ms", sample_window()};
+
+    for (uint32_t run = 0; run != opts.runs * 10; ++run) {
+        const auto angle = float(run) * .1f;
+
+        auto start = std::chrono::steady_clock::now();
+        soa.set_local(root, spin(angle));
+        soa.update();
+        full.samples.add(elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        aos->local = to_glm(spin(angle));
+        update_aos(*aos, glm::mat4(1.f));
+        full_aos.samples.add(elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        soa.set_local(groups[run % GROUP_COUNT], spin(angle));
+        soa.update();
+        incremental.samples.add(elapsed_ms(start));
+    }
+
+    results.push_back(std::move(full));
+    results.push_back(std::move(full_aos));
+    results.push_back(std::move(incremental));
+}
+
+void
+bench_resize(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    measurement resize{"offscreen_resize", "ms", sample_window()};
+
+    for (uint32_t run = 0; run != opts.runs * 4; ++run) {
+        const auto scale = run % 2 == 0 ? 2u : 1u;
+
+        const auto start = std::chrono::steady_clock::now();
+        vulkan::resize_offscreen(
+            ctx, opts.width * scale / 2, opts.height * scale / 2);
+        resize.samples.add(elapsed_ms(start));
+    }
+
+    vulkan::resize_offscreen(ctx, opts.width, opts.height);
+
+    results.push_back(std::move(resize));
+}
+
+void
+bench_frames(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    const auto draw = ctx.draws.front();
+
+    for (size_t draw_count : std::array<size_t, 3>{1, 1'000, 10'000}) {
+        ctx.draws.assign(draw_count, draw);
+
+        for (uint32_t frame = 0; frame != 10; ++frame) {
+            application::draw_offscreen_frame(ctx);
+        }
+        ctx.device->waitIdle();
+
+        measurement fps{
+            fmt::format("frames_{}_draws", draw_count), "fps", sample_window()};
+
+        for (uint32_t run = 0; run != opts.runs; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            for (uint32_t frame = 0; frame != opts.frames; ++frame) {
+                application::draw_offscreen_frame(ctx);
+            }
+            ctx.device->waitIdle();
+
+            fps.samples.add(opts.frames / (elapsed_ms(start) / 1000.0));
+        }
+
+        results.push_back(std::move(fps));
+    }
+
+    ctx.draws.assign(1, draw);
+}
+
+void
+bench_upload(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    constexpr vk::DeviceSize UPLOAD_SIZE = 1 << 20;
+    constexpr vk::DeviceSize TOTAL_SIZE  = 256 << 20;
+
+    measurement bandwidth{"upload_bandwidth", "MiB/s", sample_window()};
+
+    const std::vector<std::byte> data(UPLOAD_SIZE, std::byte{0x5a});
+    const auto target_size = vk::DeviceSize(ctx.vertex_capacity) *
+                             sizeof(mesh_file::vertex) / UPLOAD_SIZE *
+                             UPLOAD_SIZE;
+
+    // the vertex buffer is overwritten, everything drawn afterwards uses
+    // the triangle re-uploaded below
+    for (uint32_t run = 0; run != opts.runs; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        for (vk::DeviceSize offset = 0; offset != TOTAL_SIZE;
+             offset += UPLOAD_SIZE) {
+            staging::upload(
+                ctx.staging,
+                *ctx.vertex_buffer.handle,
+                offset % target_size,
+                data.data(),
+                UPLOAD_SIZE);
+        }
+        staging::wait_idle(ctx.staging);
+
+        bandwidth.samples.add(
+            static_cast<double>(TOTAL_SIZE >> 20) /
+            (elapsed_ms(start) / 1000.0));
+    }
+
+    ctx.device->waitIdle();
+    ctx.vertex_count = 0;
+    ctx.index_count  = 0;
+
+    const auto triangle = vulkan::add_mesh(
+        ctx, vulkan::g_triangle_vertices, vulkan::g_triangle_indices);
+    ctx.draws.assign(
+        1,
+        {triangle.index_count,
+         1,
+         triangle.first_index,
+         triangle.vertex_offset,
+         0});
+    staging::flush(ctx.staging);
+
+    results.push_back(std::move(bandwidth));
+}
+
+// a sphere filling half the vertex buffer, written as a mesh file and
+// loaded through the mapping and through try_read_file(); a plain memcpy
+// of the same bytes is the bound. Only the CPU side is timed, up to the
+// staging flush
+void
+bench_mesh_load(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    constexpr uint32_t SEGMENTS = 1'023;
+    constexpr uint32_t RINGS    = 511;
+
+    std::vector<mesh_file::vertex> vertices;
+    for (uint32_t ring = 0; ring <= RINGS; ++ring) {
+        const auto v     = float(ring) / float(RINGS);
+        const auto theta = v * glm::pi<float>();
+        for (uint32_t segment = 0; segment <= SEGMENTS; ++segment) {
+            const auto u   = float(segment) / float(SEGMENTS);
+            const auto phi = u * glm::two_pi<float>();
+
+            const std::array<float, 3> p = {
+                std::sin(theta) * std::cos(phi),
+                -std::cos(theta),
+                std::sin(theta) * std::sin(phi)};
+            vertices.push_back(mesh_file::pack(p, p, {u, v}));
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    for (uint32_t ring = 0; ring != RINGS; ++ring) {
+        for (uint32_t segment = 0; segment != SEGMENTS; ++segment) {
+            const auto top    = ring * (SEGMENTS + 1) + segment;
+            const auto bottom = top + SEGMENTS + 1;
+            indices.insert(
+                end(indices),
+                {top, top + 1, bottom + 1, top, bottom + 1, bottom});
+        }
+    }
+
+    if (!mesh_file::write(
+            BENCH_MESH_PATH,
+            vertices,
+            indices,
+            mesh_file::build_meshlets(vertices, indices))) {
+        ERROR("failed to write {}", BENCH_MESH_PATH);
+    }
+
+    const auto mib = static_cast<double>(
+                         sizeof(mesh_file::vertex) * vertices.size() +
+                         sizeof(uint32_t) * indices.size()) /
+                     (1024.0 * 1024.0);
+    const auto name = fmt::format("mesh_load_{}_vertices", vertices.size());
+    measurement mapped{name + "_mapped", "MiB/s", sample_window()};
+    measurement read{name + "_read_file", "MiB/s", sample_window()};
+    measurement copy{name + "_memcpy", "MiB/s", sample_window()};
+
+    // every run overwrites the same range past the meshes drawn so far
+    const auto vertex_count = ctx.vertex_count;
+    const auto index_count  = ctx.index_count;
+    const auto rewind       = [&] {
+        staging::wait_idle(ctx.staging);
+        ctx.vertex_count = vertex_count;
+        ctx.index_count  = index_count;
+    };
+
+    std::vector<std::byte> target(
+        sizeof(mesh_file::vertex) * vertices.size() +
+        sizeof(uint32_t) * indices.size());
+
+    for (uint32_t run = 0; run != opts.runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        if (!vulkan::load_mesh(ctx, BENCH_MESH_PATH)) {
+            ERROR("failed to load {}", BENCH_MESH_PATH);
+        }
+        staging::flush(ctx.staging);
+        mapped.samples.add(mib / (elapsed_ms(start) / 1000.0));
+        rewind();
+
+        start = std::chrono::steady_clock::now();
+        const auto bytes = vulkan::try_read_file(BENCH_MESH_PATH);
+        const auto contents =
+            bytes ? mesh_file::parse(
+                        reinterpret_cast<const std::byte*>(bytes->data()),
+                        bytes->size()) :
+                    std::nullopt;
+        if (!contents) { ERROR("failed to read {}", BENCH_MESH_PATH); }
+        vulkan::add_packed_mesh(
+            ctx,
+            {contents->vertices, contents->vertex_count},
+            {contents->indices, contents->index_count},
+            contents->radius);
+        staging::flush(ctx.staging);
+        read.samples.add(mib / (elapsed_ms(start) / 1000.0));
+        rewind();
+
+        start = std::chrono::steady_clock::now();
+        std::memcpy(
+            target.data(),
+            vertices.data(),
+            sizeof(mesh_file::vertex) * vertices.size());
+        std::memcpy(
+            target.data() + sizeof(mesh_file::vertex) * vertices.size(),
+            indices.data(),
+            sizeof(uint32_t) * indices.size());
+        copy.samples.add(mib / (elapsed_ms(start) / 1000.0));
+    }
+
+    std::remove(BENCH_MESH_PATH);
+
+    results.push_back(std::move(mapped));
+    results.push_back(std::move(read));
+    results.push_back(std::move(copy));
+}
+
+// a full mip chain of random BC7 mode 6 blocks, written as is and decoded
+// to RGBA8; both are loaded through load_texture() and timed until the
+// staging ring drained, along with the device memory each takes. Devices
+// without BC7 decode it on load, the log of the context says which
+void
+bench_texture_load(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    constexpr uint32_t EXTENT = 2048;
+
+    std::mt19937                            random(42);
+    std::uniform_int_distribution<uint32_t> byte(0, 255);
+
+    const auto block = *ktx2::shape(ktx2::BC7_SRGB);
+
+    std::vector<std::vector<std::byte>> bc7;
+    std::vector<std::vector<std::byte>> rgba8;
+    for (size_t level = 0; (EXTENT >> level) != 0; ++level) {
+        const auto extent = ktx2::mip_extent(EXTENT, level);
+
+        // mode 6 is the lowest set bit of a block's first byte being bit 6
+        auto& blocks =
+            bc7.emplace_back(ktx2::level_size(block, extent, extent));
+        for (size_t i = 0; i != blocks.size(); ++i) {
+            blocks[i] = std::byte(byte(random));
+            if (i % 16 == 0) {
+                blocks[i] = (blocks[i] & std::byte(0x80)) | std::byte(0x40);
+            }
+        }
+
+        std::vector<uint8_t> decoded;
+        bcn::decode_image(
+            bcn::format::bc7,
+            blocks.data(),
+            blocks.size(),
+            extent,
+            extent,
+            decoded);
+        auto& texels = rgba8.emplace_back(decoded.size());
+        std::memcpy(texels.data(), decoded.data(), decoded.size());
+    }
+
+    const auto write = [](const char*                                path,
+                          uint32_t                                   format,
+                          const std::vector<std::vector<std::byte>>& levels) {
+        const auto file = ktx2::serialize(format, EXTENT, EXTENT, levels);
+        if (!vulkan::write_file(path, file.data(), file.size())) {
+            ERROR("failed to write {}", path);
+        }
+    };
+    write(BENCH_BC7_PATH, ktx2::BC7_SRGB, bc7);
+    write(BENCH_RGBA8_PATH, ktx2::R8G8B8A8_SRGB, rgba8);
+
+    const auto name = fmt::format("texture_load_{}", EXTENT);
+    measurement bc7_load{name + "_bc7", "ms", sample_window()};
+    measurement rgba8_load{name + "_rgba8", "ms", sample_window()};
+    measurement bc7_memory{name + "_bc7_memory", "MiB", sample_window()};
+    measurement rgba8_memory{name + "_rgba8_memory", "MiB", sample_window()};
+
+    const auto load = [&](const char*  path,
+                          measurement& time,
+                          measurement& memory) {
+        const auto bytes = ctx.texture_bytes;
+        const auto start = std::chrono::steady_clock::now();
+        if (!vulkan::load_texture(ctx, path)) {
+            ERROR("failed to load {}", path);
+        }
+        staging::wait_idle(ctx.staging);
+        time.samples.add(elapsed_ms(start));
+        memory.samples.add(
+            static_cast<double>(ctx.texture_bytes - bytes) /
+            (1024.0 * 1024.0));
+    };
+
+    // the textures stay resident: a dedicated transfer queue leaves their
+    // ownership acquires to the next frame, which needs the images alive
+    for (uint32_t run = 0; run != opts.runs; ++run) {
+        load(BENCH_BC7_PATH, bc7_load, bc7_memory);
+        load(BENCH_RGBA8_PATH, rgba8_load, rgba8_memory);
+    }
+
+    std::remove(BENCH_BC7_PATH);
+    std::remove(BENCH_RGBA8_PATH);
+
+    results.push_back(std::move(bc7_load));
+    results.push_back(std::move(rgba8_load));
+    results.push_back(std::move(bc7_memory));
+    results.push_back(std::move(rgba8_memory));
+}
+
+// where the kernel lets a process reset its peak resident set size, so the
+// peak of one phase can be read; elsewhere the peak covers the whole run
+void
+reset_peak_rss() noexcept
+{
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif // __linux__
+}
+
+// MiB, 0 where unknown
+double
+peak_rss_mib() noexcept
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string   line;
+    while (std::getline(status, line)) {
+        if (line.substr(0, 6) == "VmHWM:") {
+            return std::strtod(line.c_str() + 6, nullptr) / 1024.0;
+        }
+    }
+#endif // __linux__
+
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return double(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+        return double(usage.ru_maxrss) / 1024.0;
+#endif // __APPLE__
+    }
+#endif // __unix__ || __APPLE__
+
+    return 0.;
+}
+
+// a grid of distinct sphere meshes in a .gltf with an external .bin, the
+// layout exporters write for large scenes; returns the primitive count
+uint32_t
+write_bench_gltf() noexcept
+{
+    constexpr uint32_t GRID     = 16;
+    constexpr uint32_t SEGMENTS = 48;
+    constexpr uint32_t RINGS    = 48;
+
+    std::vector<float>    attributes;
+    std::vector<uint32_t> indices;
+    for (uint32_t ring = 0; ring <= RINGS; ++ring) {
+        const auto v     = float(ring) / float(RINGS);
+        const auto theta = v * glm::pi<float>();
+        for (uint32_t segment = 0; segment <= SEGMENTS; ++segment) {
+            const auto u   = float(segment) / float(SEGMENTS);
+            const auto phi = u * glm::two_pi<float>();
+
+            const glm::vec3 p(
+                std::sin(theta) * std::cos(phi),
+                std::cos(theta),
+                -std::sin(theta) * std::sin(phi));
+            attributes.insert(
+                end(attributes), {p.x, p.y, p.z, p.x, p.y, p.z, u, v});
+        }
+    }
+    for (uint32_t ring = 0; ring != RINGS; ++ring) {
+        for (uint32_t segment = 0; segment != SEGMENTS; ++segment) {
+            const auto top    = ring * (SEGMENTS + 1) + segment;
+            const auto bottom = top + SEGMENTS + 1;
+            indices.insert(
+                end(indices),
+                {top, bottom, bottom + 1, top, bottom + 1, top + 1});
+        }
+    }
+
+    const auto vertex_count = attributes.size() / 8;
+    const auto vertex_bytes = attributes.size() * sizeof(float);
+    const auto index_bytes  = indices.size() * sizeof(uint32_t);
+    const auto mesh_bytes   = vertex_bytes + index_bytes;
+    const auto count        = GRID * GRID;
+
+    // every mesh gets its own copy, as distinct meshes would
+    std::ofstream bin(BENCH_GLTF_BUFFER_PATH, std::ios::binary);
+    for (uint32_t i = 0; i != count; ++i) {
+        bin.write(
+            reinterpret_cast<const char*>(attributes.data()),
+            std::streamsize(vertex_bytes));
+        bin.write(
+            reinterpret_cast<const char*>(indices.data()),
+            std::streamsize(index_bytes));
+    }
+    if (!bin) { ERROR("failed to write {}", BENCH_GLTF_BUFFER_PATH); }
+
+    std::string views;
+    std::string accessors;
+    std::string meshes;
+    std::string nodes;
+    std::string roots;
+    for (uint32_t i = 0; i != count; ++i) {
+        const auto separator = i == 0 ? "" : ",";
+        views += fmt::format(
+            "{}{{\"buffer\":0,\"byteOffset\":{},\"byteLength\":{},"
+            "\"byteStride\":32}},"
+            "{{\"buffer\":0,\"byteOffset\":{},\"byteLength\":{}}}",
+            separator,
+            i * mesh_bytes,
+            vertex_bytes,
+            i * mesh_bytes + vertex_bytes,
+            index_bytes);
+        accessors += fmt::format(
+            "{0}{{\"bufferView\":{1},\"componentType\":5126,\"count\":{2},"
+            "\"type\":\"VEC3\",\"min\":[-1,-1,-1],\"max\":[1,1,1]}},"
+            "{{\"bufferView\":{1},\"byteOffset\":12,\"componentType\":5126,"
+            "\"count\":{2},\"type\":\"VEC3\"}},"
+            "{{\"bufferView\":{1},\"byteOffset\":24,\"componentType\":5126,"
+            "\"count\":{2},\"type\":\"VEC2\"}},"
+            "{{\"bufferView\":{3},\"componentType\":5125,\"count\":{4},"
+            "\"type\":\"SCALAR\"}}",
+            separator,
+            2 * i,
+            vertex_count,
+            2 * i + 1,
+            indices.size());
+        meshes += fmt::format(
+            "{}{{\"primitives\":[{{\"attributes\":{{\"POSITION\":{},"
+            "\"NORMAL\":{},\"TEXCOORD_0\":{}}},\"indices\":{},"
+            "\"material\":{}}}]}}",
+            separator,
+            4 * i,
+            4 * i + 1,
+            4 * i + 2,
+            4 * i + 3,
+            i % 4);
+        nodes += fmt::format(
+            "{}{{\"mesh\":{},\"translation\":[{},{},0]}}",
+            separator,
+            i,
+            2.5f * float(i % GRID),
+            2.5f * float(i / GRID));
+        roots += fmt::format("{}{}", separator, i);
+    }
+
+    std::ofstream document(BENCH_GLTF_PATH);
+    document << fmt::format(
+        "{{\"asset\":{{\"version\":\"2.0\"}},"
+        "\"buffers\":[{{\"uri\":\"{}\",\"byteLength\":{}}}],"
+        "\"bufferViews\":[{}],\"accessors\":[{}],\"meshes\":[{}],"
+        "\"materials\":["
+        "{{\"pbrMetallicRoughness\":{{\"baseColorFactor\":[1,.2,.2,1]}}}},"
+        "{{\"pbrMetallicRoughness\":{{\"metallicFactor\":0}}}},"
+        "{{\"doubleSided\":true}},"
+        "{{\"alphaMode\":\"BLEND\"}}],"
+        "\"nodes\":[{}],\"scenes\":[{{\"nodes\":[{}]}}]}}",
+        BENCH_GLTF_BUFFER_PATH,
+        count * mesh_bytes,
+        views,
+        accessors,
+        meshes,
+        nodes,
+        roots);
+    if (!document) { ERROR("failed to write {}", BENCH_GLTF_PATH); }
+
+    return count;
+}
+
+// imports a scene of distinct meshes while rendering headless frames: when
+// the first objects were drawn, when all of them were resident, and the
+// peak resident set size meanwhile
+void
+bench_gltf_import(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    const auto count = write_bench_gltf();
+
+    const auto name = fmt::format("gltf_import_{}_meshes", count);
+    measurement first{name + "_first_objects", "ms", sample_window()};
+    measurement resident{name + "_resident", "ms", sample_window()};
+    measurement rss{name + "_peak_rss", "MiB", sample_window()};
+
+    // every run overwrites the same range past the meshes drawn so far
+    const auto draws        = ctx.draws;
+    const auto vertex_count = ctx.vertex_count;
+    const auto index_count  = ctx.index_count;
+
+    for (uint32_t run = 0; run != opts.runs; ++run) {
+        reset_peak_rss();
+        {
+            importer::session s;
+            if (!importer::start(s, ctx, BENCH_GLTF_PATH)) {
+                ERROR("failed to import {}", BENCH_GLTF_PATH);
+            }
+            while (!importer::resident(s)) {
+                importer::poll(s, ctx);
+                application::draw_offscreen_frame(ctx);
+            }
+            ctx.device->waitIdle();
+
+            first.samples.add(s.first_objects_ms.value_or(0.));
+            resident.samples.add(*s.resident_ms);
+        }
+        rss.samples.add(peak_rss_mib());
+
+        vulkan::create_scene(ctx, {}, {});
+        ctx.draws = draws;
+        staging::wait_idle(ctx.staging);
+        ctx.vertex_count = vertex_count;
+        ctx.index_count  = index_count;
+    }
+
+    std::remove(BENCH_GLTF_PATH);
+    std::remove(BENCH_GLTF_BUFFER_PATH);
+
+    results.push_back(std::move(first));
+    results.push_back(std::move(resident));
+    results.push_back(std::move(rss));
+}
+
+void
+bench_pipeline_creation(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    measurement creation{"pipeline_creation", "ms", sample_window()};
+
+    for (uint32_t run = 0; run != opts.runs; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        vulkan::create_graphics_pipeline(ctx);
+        creation.samples.add(elapsed_ms(start));
+    }
+
+    results.push_back(std::move(creation));
+}
+
+// a library cycling through every feature combination, so most materials
+// share a permutation; the pipeline cache is warm after the first run
+void
+bench_material_library(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    constexpr uint32_t LIBRARY_SIZE = 500;
+
+    measurement load{
+        fmt::format("material_library_{}", LIBRARY_SIZE),
+        "ms",
+        sample_window()};
+
+    for (uint32_t run = 0; run != opts.runs; ++run) {
+        vulkan::defer_destroy(ctx, std::move(ctx.material_pipelines));
+        ctx.material_pipelines.clear();
+        ctx.materials = material::library();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i != LIBRARY_SIZE; ++i) {
+            material::feature_set features;
+            features.normal_map   = i & 1;
+            features.clearcoat    = i & 2;
+            features.double_sided = i & 4;
+            features.alpha =
+                static_cast<material::alpha_mode>(i / 8 % 3);
+            material::parameters params;
+            params.base_color[0] = float(i % 10) / 10.f;
+            params.roughness     = float(i % 7) / 7.f;
+            vulkan::add_material(
+                ctx, fmt::format("material {}", i), features, params);
+        }
+        vulkan::build_materials(ctx);
+        staging::flush(ctx.staging);
+        load.samples.add(elapsed_ms(start));
+    }
+
+    results.push_back(std::move(load));
+}
+
+// one sphere per swatch, cycling through the library left by
+// bench_material_library; a frame costs one instanced draw per permutation
+void
+bench_swatches(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    const auto draws  = ctx.draws;
+    const auto sphere = vulkan::add_sphere_mesh(ctx, 16, 8);
+    const auto frames = std::max(opts.frames / 10, 1u);
+
+    for (uint32_t count : std::array<uint32_t, 3>{1'000, 10'000, 50'000}) {
+        std::vector<uint32_t> materials(count);
+        for (uint32_t i = 0; i != count; ++i) {
+            materials[i] = gsl::narrow<uint32_t>(i % ctx.materials.size());
+        }
+        vulkan::create_swatch_grid(ctx, sphere, materials);
+        staging::flush(ctx.staging);
+
+        for (uint32_t frame = 0; frame != 10; ++frame) {
+            application::draw_offscreen_frame(ctx);
+        }
+        ctx.device->waitIdle();
+
+        measurement throughput{
+            fmt::format("swatches_{}", count), "swatches/s", sample_window()};
+
+        for (uint32_t run = 0; run != opts.runs; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            for (uint32_t frame = 0; frame != frames; ++frame) {
+                application::draw_offscreen_frame(ctx);
+            }
+            ctx.device->waitIdle();
+
+            throughput.samples.add(
+                double(count) * frames / (elapsed_ms(start) / 1000.0));
+        }
+
+        results.push_back(std::move(throughput));
+    }
+
+    ctx.draws = draws;
+}
+
+// the same kind of grid as a GPU-driven scene, whole and zoomed in so most
+// of it is culled; the CPU records one indirect draw per permutation either
+// way
+void
+bench_scene(
+    vulkan::context&          ctx,
+    const options&            opts,
+    std::vector<measurement>& results) noexcept
+{
+    constexpr uint32_t OBJECT_COUNT = 50'000;
+
+    const auto draws  = ctx.draws;
+    const auto sphere = vulkan::add_sphere_mesh(ctx, 16, 8);
+    const auto frames = std::max(opts.frames / 10, 1u);
+
+    const swatch::grid grid(OBJECT_COUNT, opts.width, opts.height);
+
+    std::vector<swatch::instance> instances;
+    instances.reserve(OBJECT_COUNT);
+    for (uint32_t i = 0; i != OBJECT_COUNT; ++i) {
+        instances.push_back(grid.place(
+            i, gsl::narrow<uint32_t>(i % ctx.materials.size())));
+    }
+    const auto first_instance = vulkan::add_instances(ctx, instances);
+
+    std::vector<vulkan::scene_object> objects;
+    objects.reserve(OBJECT_COUNT);
+    for (uint32_t i = 0; i != OBJECT_COUNT; ++i) {
+        objects.push_back({sphere, first_instance + i, instances[i].material});
+    }
+
+    ctx.draws.clear();
+    vulkan::create_scene(ctx, objects, {first_instance, OBJECT_COUNT});
+    staging::flush(ctx.staging);
+
+    for (uint32_t zoom : {1u, 4u}) {
+        ctx.view = {0.f, 0.f, float(zoom), float(zoom)};
+
+        for (uint32_t frame = 0; frame != 10; ++frame) {
+            application::draw_offscreen_frame(ctx);
+        }
+        ctx.device->waitIdle();
+
+        const auto name =
+            fmt::format("scene_{}_objects_zoom_{}", OBJECT_COUNT, zoom);
+        measurement fps{name, "fps", sample_window()};
+        measurement visible{name + "_visible", "objects", sample_window()};
+
+        for (uint32_t run = 0; run != opts.runs; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            for (uint32_t frame = 0; frame != frames; ++frame) {
+                application::draw_offscreen_frame(ctx);
+            }
+            ctx.device->waitIdle();
+
+            fps.samples.add(frames / (elapsed_ms(start) / 1000.0));
+            visible.samples.add(
+                profiler::last_count(ctx.gpu_profiler, "visible objects")
+                    .value_or(0));
+        }
+
+        results.push_back(std::move(fps));
+        results.push_back(std::move(visible));
+    }
+
+    ctx.view = {0.f, 0.f, 1.f, 1.f};
+    vulkan::create_scene(ctx, {}, {});
+    ctx.draws = draws;
+}
+
+bool
+write_json(
+    const options&                  opts,
+    const vulkan::context&          ctx,
+    const std::vector<measurement>& results) noexcept
+{
+    const auto properties = ctx.physical_device.getProperties();
+
+    std::ofstream out(opts.output, std::ios::trunc);
+    if (!out) { return false; }
+
+    out << fmt::format(
+        "{{\n  \"version\": \"{}\",\n  \"device\": \"{}\",\n"
+        "  \"driver_version\": {},\n  \"width\": {},\n  \"height\": {},\n"
+        "  \"results\": [",
+        MATERIALIST_VERSION,
+        properties.deviceName,
+        properties.driverVersion,
+        opts.width,
+        opts.height);
+
+    for (size_t i = 0; i != results.size(); ++i) {
+        const auto& r = results[i];
+        out << fmt::format(
+            "{}\n    {{\"name\": \"{}\", \"unit\": \"{}\", \"min\": {:.4f}, "
+            "\"avg\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f}, "
+            "\"samples\": {}}}",
+            i == 0 ? "" : ",",
+            r.name,
+            r.unit,
+            r.samples.min(),
+            r.samples.average(),
+            r.samples.percentile(99),
+            r.samples.max(),
+            r.samples.size());
+    }
+
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    const auto opts = parse_options(argc, argv);
+
+    vk::DynamicLoader dl;
+    if (!dl.success()) { ERROR("failed to create dynamic loader"); }
+    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr =
+        dl.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+
+    std::vector<measurement> results;
+
+    bench_startup(opts, results);
+    bench_scene_graph(opts, results);
+
+    vulkan::context ctx;
+    initialize_headless(ctx, opts);
+
+    bench_resize(ctx, opts, results);
+    bench_frames(ctx, opts, results);
+    bench_upload(ctx, opts, results);
+    bench_mesh_load(ctx, opts, results);
+    bench_texture_load(ctx, opts, results);
+    bench_gltf_import(ctx, opts, results);
+    bench_pipeline_creation(ctx, opts, results);
+    bench_material_library(ctx, opts, results);
+    bench_swatches(ctx, opts, results);
+    bench_scene(ctx, opts, results);
+
+    ctx.device->waitIdle();
+
+    for (const auto& r : results) {
+        spdlog::info(
+            "{}: avg {:.3f} {} (min {:.3f}, p99 {:.3f})",
+            r.name,
+            r.samples.average(),
+            r.unit,
+            r.samples.min(),
+            r.samples.percentile(99));
+    }
+
+    if (!write_json(opts, ctx, results)) {
+        ERROR("failed to write {}", opts.output);
+    }
+    spdlog::info("results written to {}", opts.output);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+# turns every SPIR-V binary in SHADERS_BINARY_DIR into a constexpr uint32_t
+# array behind shaders::embedded(), see src/shaders.hpp
+#
+#   cmake -DSHADERS_BINARY_DIR=<dir> -DOUTPUT=<file> -P embed_shaders.cmake
+
+file(GLOB SPIR_V_BINARIES ${SHADERS_BINARY_DIR}/*.spv)
+list(SORT SPIR_V_BINARIES)
+
+set(ARRAYS "")
+set(TABLE "")
+
+foreach(SPIR_V ${SPIR_V_BINARIES})
+    get_filename_component(FILENAME ${SPIR_V} NAME)
+    string(REGEX REPLACE "\\.spv$" "" NAME ${FILENAME})
+    string(MAKE_C_IDENTIFIER ${NAME} IDENTIFIER)
+
+    # SPIR-V is a stream of little-endian words
+    file(READ ${SPIR_V} HEX HEX)
+    string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u, " WORDS "${HEX}")
+    set(WORD "0x[0-9a-f]+u, ")
+    string(REGEX REPLACE "(${WORD}${WORD}${WORD}${WORD}${WORD}${WORD})" "\\1\n    " WORDS "${WORDS}")
+    string(REPLACE ", \n" ",\n" WORDS "${WORDS}")
+    string(STRIP "${WORDS}" WORDS)
+    string(REGEX REPLACE ",$" "" WORDS "${WORDS}")
+
+    string(APPEND ARRAYS "constexpr uint32_t ${IDENTIFIER}[] = {\n    ${WORDS}};\n\n")
+    string(APPEND TABLE "    {\"${NAME}\", ${IDENTIFIER}},\n")
+endforeach(SPIR_V ${SPIR_V_BINARIES})
+
+file(WRITE ${OUTPUT}
+"// generated by config/embed_shaders.cmake, do not edit
+
+#include \"shaders.hpp\"
+
+namespace shaders {
+
+namespace /* anonymous */ {
+
+${ARRAYS}struct embedded_shader {
+    std::string_view          name;
+    gsl::span<const uint32_t> code;
+};
+
+const embedded_shader g_embedded_shaders[] = {
+${TABLE}};
+
+} // namespace
+
+gsl::span<const uint32_t>
+embedded(std::string_view name) noexcept
+{
+    for (const auto& shader : g_embedded_shaders) {
+        if (shader.name == name) { return shader.code; }
+    }
+
+    return {};
+}
+
+} // namespace shaders
+")
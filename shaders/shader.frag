@@ -1,10 +1,80 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(location = 0) in vec3 frag_color;
+// material features, see material::pipeline_state
+layout(constant_id = 0) const bool HAS_NORMAL_MAP = false;
+layout(constant_id = 1) const bool HAS_CLEARCOAT = false;
+layout(constant_id = 2) const uint ALPHA_MODE = 0u; // opaque, mask, blend
+
+const uint ALPHA_MODE_MASK = 1u;
+const uint ALPHA_MODE_BLEND = 2u;
+const float ALPHA_CUTOFF = 0.5;
+
+const uint NO_TEXTURE = 0xffffffffu;
+
+// see material::parameters
+struct material_parameters {
+    vec4 base_color;
+    float roughness;
+    float metallic;
+    uint base_color_texture;
+    uint normal_texture;
+};
+
+layout(set = 0, binding = 0, std430) readonly buffer materials {
+    material_parameters parameters[];
+};
+
+layout(set = 0, binding = 1) uniform sampler2D textures[];
+
+layout(location = 0) in vec3 frag_normal;
+layout(location = 1) in vec2 frag_uv;
+layout(location = 2) flat in uint frag_material;
 
 layout(location = 0) out vec4 out_color;
 
 void main() {
-    out_color = vec4(frag_color, 1.0);
+    const material_parameters m = parameters[frag_material];
+
+    vec4 base_color = m.base_color;
+    if (m.base_color_texture != NO_TEXTURE) {
+        base_color *=
+            texture(textures[nonuniformEXT(m.base_color_texture)], frag_uv);
+    }
+
+    vec3 n = normalize(frag_normal);
+    if (HAS_NORMAL_MAP) {
+        if (m.normal_texture != NO_TEXTURE) {
+            const vec3 t =
+                texture(textures[nonuniformEXT(m.normal_texture)], frag_uv)
+                    .xyz;
+            n = normalize(n + vec3(t.xy * 2.0 - 1.0, 0.0));
+        } else {
+            // procedural bumps for materials without a normal texture
+            n = normalize(n + 0.25 * vec3(sin(frag_uv * 40.0), 0.0));
+        }
+    }
+
+    const vec3 l = normalize(vec3(0.3, -0.5, -1.0));
+    const vec3 h = normalize(l + vec3(0.0, 0.0, -1.0));
+    const float shininess = mix(256.0, 4.0, m.roughness);
+    const vec3 specular_color = mix(vec3(0.04), base_color.rgb, m.metallic);
+
+    vec3 color = base_color.rgb * (1.0 - m.metallic) *
+                 (0.2 + 0.8 * max(dot(n, l), 0.0));
+    color += specular_color * pow(max(dot(n, h), 0.0), shininess);
+
+    if (HAS_CLEARCOAT) {
+        color += vec3(0.25 * pow(max(dot(n, h), 0.0), 64.0));
+    }
+
+    float alpha = 1.0;
+    if (ALPHA_MODE == ALPHA_MODE_MASK) {
+        if (base_color.a < ALPHA_CUTOFF) { discard; }
+    } else if (ALPHA_MODE == ALPHA_MODE_BLEND) {
+        alpha = base_color.a;
+    }
+
+    out_color = vec4(color, alpha);
 }
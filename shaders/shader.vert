@@ -1,20 +1,49 @@
 #version 450
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+// see swatch::instance
+struct instance {
+    vec4 offset_scale;
+    uint material;
+};
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+layout(set = 0, binding = 2, std430) readonly buffer instances {
+    instance instance_data[];
+};
 
-layout(location = 0) out vec3 frag_color;
+// see vulkan::context::view
+layout(push_constant) uniform camera {
+    vec4 view;
+};
+
+// see mesh_file::vertex
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec2 in_normal;
+layout(location = 2) in vec2 in_uv;
+
+layout(location = 0) out vec3 frag_normal;
+layout(location = 1) out vec2 frag_uv;
+layout(location = 2) flat out uint frag_material;
+
+// see mesh_file::decode_octahedral
+vec3 decode_octahedral(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    const float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    frag_color = colors[gl_VertexIndex];
+    const instance i = instance_data[gl_InstanceIndex];
+
+    const vec2 position =
+        in_position.xy * i.offset_scale.zw + i.offset_scale.xy;
+
+    // depth stays within [0, 1] for meshes inside the unit sphere
+    gl_Position = vec4(
+        position * view.zw + view.xy,
+        in_position.z * 0.5 + 0.5,
+        1.0);
+    frag_normal = decode_octahedral(in_normal);
+    frag_uv = in_uv;
+    frag_material = i.material;
 }
@@ -1,11 +1,46 @@
 #ifndef MATERIALIST_APPLICATION_HPP
 #define MATERIALIST_APPLICATION_HPP
 
+#include <cstdint>
+#include <string>
+
+#include "vulkan_context.hpp"
+
 namespace application {
 
-void main_loop() noexcept;
+struct options {
+    bool headless = false;
 
-}
+    // 0 runs until the window is closed
+    uint32_t frame_count = 0;
 
-#endif // MATERIALIST_APPLICATION_HPP
+    int width  = 800;
+    int height = 600;
+
+    // frames the CPU may record ahead of the GPU
+    uint32_t frames_in_flight = 2;
+
+    // ignored when headless
+    vulkan::present_policy present = vulkan::present_policy::smooth;
+
+    // 0 lets the present policy pick
+    uint32_t swapchain_images = 0;
+
+    // chrome trace written on exit, empty for none
+    std::string trace_path;
 
+    // rebuild pipelines when a shader source changes; windowed runs only
+    bool hot_reload = false;
+
+    // mesh_file drawn instead of the triangle, empty for none
+    std::string mesh_path;
+
+    // glTF 2.0 asset streamed in instead of the triangle, empty for none
+    std::string gltf_path;
+};
+
+void main_loop(const options&) noexcept;
+
+} // namespace application
+
+#endif // MATERIALIST_APPLICATION_HPP
@@ -4,11 +4,67 @@ namespace /* anonymous */ {
 
 void draw_frame(vulkan::context&) noexcept;
 
+void draw_offscreen_frame(vulkan::context&) noexcept;
+
+void run_headless(
+    vulkan::context&, bake::queue&, importer::session&, uint32_t) noexcept;
+
+void run(const options&) noexcept;
+
+void write_trace(const std::string&) noexcept;
+
+void show_mesh(vulkan::context&, const std::string&) noexcept;
+
+constexpr auto DEFAULT_TRACE_PATH = "materialist.trace.json";
+
+} // namespace
+
+void
+main_loop(const options& opts) noexcept
+{
+    run(opts);
+
+    if (!opts.trace_path.empty()) { write_trace(opts.trace_path); }
 }
 
+namespace /* anonymous */ {
+
+void
+write_trace(const std::string& path) noexcept
+{
+    if (trace::write_file(path)) {
+        spdlog::info("trace written to {}", path);
+    } else {
+        spdlog::warn("failed to write trace to {}", path);
+    }
+}
+
+// the mesh is drawn as stored; mesh files are normalized into the unit
+// sphere by the converter, so it fills the view
 void
-main_loop() noexcept
+show_mesh(vulkan::context& ctx, const std::string& path) noexcept
 {
+    const auto mesh = vulkan::load_mesh(ctx, path);
+    if (!mesh) {
+        spdlog::warn("failed to load mesh {}", path);
+        return;
+    }
+    staging::flush(ctx.staging);
+
+    ctx.draws.assign(
+        1,
+        {mesh->index_count,
+         1,
+         mesh->first_index,
+         mesh->vertex_offset,
+         0});
+}
+
+void
+run(const options& opts) noexcept
+{
+    TRACE_ZONE("main_loop");
+
     vk::DynamicLoader dl;
     if (!dl.success()) { ERROR("failed to create dynamic loader"); }
     PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr =
@@ -16,37 +72,193 @@ main_loop() noexcept
     VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
 
     vulkan::context context;
-    vulkan::initialize(context, 800, 600);
+    context.headless              = opts.headless;
+    context.frames_in_flight      = opts.frames_in_flight;
+    context.present               = opts.present;
+    context.swapchain_image_count = opts.swapchain_images;
+    vulkan::initialize(context, opts.width, opts.height);
+
+    if (!opts.mesh_path.empty()) { show_mesh(context, opts.mesh_path); }
+
+    // the triangle stays up until the first imported objects are resident
+    importer::session gltf_import;
+    if (!opts.gltf_path.empty()) {
+        importer::start(gltf_import, context, opts.gltf_path);
+    }
+
+    // precomputation runs on the compute queue while the first frames render
+    bake::queue bakes;
+    bake::initialize(bakes, context);
+    bake::bake_brdf_lut(bakes, context);
+
+    hot_reload::reloader reloader;
 
-    auto& window = context.window;
-    assert(*window);
+    if (context.headless) {
+        run_headless(context, bakes, gltf_import, opts.frame_count);
+    } else {
+        auto& window = context.window;
+        assert(*window);
 
-    while (!glfwWindowShouldClose(*window)) {
-        glfwPollEvents();
-        draw_frame(context);
+        if (opts.hot_reload) { hot_reload::initialize(reloader, context); }
+
+        uint32_t frame       = 0;
+        bool     dump_pressed = false;
+        while (!glfwWindowShouldClose(*window) &&
+               (opts.frame_count == 0 || frame != opts.frame_count)) {
+            vulkan::pace_frame(context);
+            {
+                TRACE_ZONE("glfwPollEvents");
+                glfwPollEvents();
+            }
+
+            // F12 dumps the trace recorded so far
+            const bool pressed =
+                glfwGetKey(*window, GLFW_KEY_F12) == GLFW_PRESS;
+            if (pressed && !dump_pressed) {
+                write_trace(
+                    opts.trace_path.empty() ? DEFAULT_TRACE_PATH :
+                                              opts.trace_path);
+            }
+            dump_pressed = pressed;
+
+            bake::poll(bakes, context);
+            hot_reload::poll(reloader, context);
+            importer::poll(gltf_import, context);
+            draw_frame(context);
+            ++frame;
+        }
     }
 
+    hot_reload::stop(reloader);
+    importer::stop(gltf_import);
+    bake::wait_idle(bakes, context);
+    vulkan::wait_idle(context);
     context.device->waitIdle();
+
+    vulkan::save_pipeline_cache(context);
+
+    profiler::log_summary(context.gpu_profiler);
+    staging::log_statistics(context.staging);
+    shaders::log_statistics(context.shader_modules);
+    vulkan::log_latency(context);
+    memory::log_statistics(context.allocator);
 }
 
-namespace /* anonymous */ {
+void
+run_headless(
+    vulkan::context&   ctx,
+    bake::queue&       bakes,
+    importer::session& gltf_import,
+    uint32_t           frame_count) noexcept
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t frame = 0; frame != frame_count; ++frame) {
+        bake::poll(bakes, ctx);
+        importer::poll(gltf_import, ctx);
+        draw_offscreen_frame(ctx);
+    }
+
+    vulkan::wait_idle(ctx);
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    spdlog::info(
+        "rendered {} offscreen frames in {:.3f}s ({:.1f} fps)",
+        frame_count,
+        elapsed.count(),
+        frame_count / elapsed.count());
+}
+
+void
+submit_frame(
+    vulkan::context&                           ctx,
+    vk::CommandBuffer                          command_buffer,
+    const std::vector<vk::Semaphore>&          wait_semaphores,
+    const std::vector<vk::PipelineStageFlags>& wait_stages,
+    vk::Semaphore                              render_finished) noexcept
+{
+    TRACE_ZONE("submit");
+
+    // binary semaphores ignore their entry in the value arrays
+    const std::vector<uint64_t> wait_values(wait_semaphores.size(), 0);
+
+    const auto signal_semaphores = std::array{*ctx.timeline, render_finished};
+    const auto signal_values     = std::array<uint64_t, 2>{
+        ctx.frame_number + 1, 0};
+    const auto signal_count = render_finished ? 2u : 1u;
+
+    vk::TimelineSemaphoreSubmitInfo tssi(
+        gsl::narrow<uint32_t>(wait_values.size()),
+        wait_values.data(),
+        signal_count,
+        signal_values.data());
+
+    vk::SubmitInfo submit_info;
+    submit_info.setPNext(&tssi);
+    submit_info.waitSemaphoreCount =
+        gsl::narrow<uint32_t>(wait_semaphores.size());
+    submit_info.pWaitSemaphores      = wait_semaphores.data();
+    submit_info.pWaitDstStageMask    = wait_stages.data();
+    submit_info.commandBufferCount   = 1;
+    submit_info.pCommandBuffers      = &command_buffer;
+    submit_info.signalSemaphoreCount = signal_count;
+    submit_info.pSignalSemaphores    = signal_semaphores.data();
+
+    if (ctx.graphics_queue.submit(1, &submit_info, vk::Fence()) !=
+        vk::Result::eSuccess) {
+        ERROR("failed to submit draw command buffer!");
+    }
+
+    vulkan::end_frame(ctx);
+}
+
+void
+draw_offscreen_frame(vulkan::context& ctx) noexcept
+{
+    TRACE_ZONE("draw_offscreen_frame");
+
+    {
+        TRACE_ZONE("wait frame slot");
+        vulkan::begin_frame(ctx);
+    }
+
+    // offscreen targets are owned per frame in flight, so the frame index
+    // doubles as the image index
+    const auto image_index = gsl::narrow<uint32_t>(ctx.current_frame);
+
+    std::vector<vk::Semaphore> upload_waits;
+    auto command_buffer = vulkan::record_frame(ctx, image_index, upload_waits);
+
+    const std::vector<vk::PipelineStageFlags> wait_stages(
+        upload_waits.size(), staging::consumer_stages());
+
+    submit_frame(
+        ctx, command_buffer, upload_waits, wait_stages, vk::Semaphore());
+}
 
 void
 draw_frame(vulkan::context& ctx) noexcept
 {
-    ctx.device->waitForFences(
-        1u,
-        &*ctx.inflight_fences[ctx.current_frame],
-        VK_TRUE,
-        std::numeric_limits<uint64_t>::max());
-
-    uint32_t image_index;
-    auto     result = ctx.device->acquireNextImageKHR(
-        *ctx.swapchain,
-        std::numeric_limits<uint64_t>::max(),
-        *ctx.image_avail_semaphores[ctx.current_frame],
-        vk::Fence(),
-        &image_index);
+    TRACE_ZONE("draw_frame");
+
+    {
+        TRACE_ZONE("wait frame slot");
+        vulkan::begin_frame(ctx);
+    }
+
+    uint32_t   image_index;
+    vk::Result result;
+    {
+        TRACE_ZONE("acquireNextImageKHR");
+        result = ctx.device->acquireNextImageKHR(
+            *ctx.swapchain,
+            std::numeric_limits<uint64_t>::max(),
+            *ctx.image_avail_semaphores[ctx.current_frame],
+            vk::Fence(),
+            &image_index);
+    }
 
     if (result == vk::Result::eErrorOutOfDateKHR) {
         vulkan::recreate_swapchain(ctx);
@@ -57,59 +269,53 @@ draw_frame(vulkan::context& ctx) noexcept
         ERROR("failed to acquire next image");
     }
 
-    if (ctx.images_inflight[image_index]) {
-        ctx.device->waitForFences(
-            1u,
-            &ctx.images_inflight[image_index],
-            VK_TRUE,
-            std::numeric_limits<uint32_t>::max());
+    // with more images than frames in flight an image can come back while
+    // the frame that last rendered to it is still running
+    {
+        TRACE_ZONE("wait image");
+        vulkan::wait_for_frames(ctx, ctx.image_frames[image_index]);
     }
-    ctx.images_inflight[image_index] = *ctx.inflight_fences[ctx.current_frame];
+    ctx.image_frames[image_index] = ctx.frame_number + 1;
 
-    vk::SubmitInfo submit_info;
+    std::vector<vk::Semaphore> wait_semaphores;
+    auto command_buffer =
+        vulkan::record_frame(ctx, image_index, wait_semaphores);
 
-    vk::Semaphore wait_semaphores[] = {
-        *ctx.image_avail_semaphores[ctx.current_frame]};
-    vk::PipelineStageFlags wait_stages[] = {
-        vk::PipelineStageFlagBits::eColorAttachmentOutput};
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores    = wait_semaphores;
-    submit_info.pWaitDstStageMask  = wait_stages;
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers    = &*ctx.command_buffers[image_index];
-
-    vk::Semaphore signal_semaphores[] = {
-        *ctx.render_finished_semaphores[ctx.current_frame]};
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores    = signal_semaphores;
-
-    ctx.device->resetFences(1u, &*ctx.inflight_fences[ctx.current_frame]);
-
-    if (ctx.graphics_queue.submit(
-            1, &submit_info, *ctx.inflight_fences[ctx.current_frame]) !=
-        vk::Result::eSuccess) {
-        ERROR("failed to submit draw command buffer!");
-    }
+    std::vector<vk::PipelineStageFlags> wait_stages(
+        wait_semaphores.size(), staging::consumer_stages());
+    wait_semaphores.push_back(*ctx.image_avail_semaphores[ctx.current_frame]);
+    wait_stages.push_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+
+    const auto render_finished =
+        *ctx.render_finished_semaphores[ctx.current_frame];
+
+    submit_frame(
+        ctx, command_buffer, wait_semaphores, wait_stages, render_finished);
 
     vk::PresentInfoKHR present_info;
 
     present_info.waitSemaphoreCount = 1;
-    present_info.pWaitSemaphores    = signal_semaphores;
+    present_info.pWaitSemaphores    = &render_finished;
 
     vk::SwapchainKHR swapchains[] = {*ctx.swapchain};
     present_info.swapchainCount   = 1;
     present_info.pSwapchains      = swapchains;
     present_info.pImageIndices    = &image_index;
 
-    result = ctx.present_queue.presentKHR(&present_info);
+    {
+        TRACE_ZONE("presentKHR");
+        result = ctx.present_queue.presentKHR(&present_info);
+    }
+    const std::chrono::duration<double, std::milli> latency =
+        std::chrono::steady_clock::now() - ctx.input_time;
+    ctx.input_to_present_ms.add(latency.count());
+
     if (result == vk::Result::eErrorOutOfDateKHR ||
         result == vk::Result::eSuboptimalKHR) {
         vulkan::recreate_swapchain(ctx);
     } else if (result != vk::Result::eSuccess) {
         ERROR("failed to present swap chain image!");
     }
-
-    ctx.current_frame = (ctx.current_frame + 1) % vulkan::MAX_FRAMES_IN_FLIGHT;
 }
 
 } // namespace
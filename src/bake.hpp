@@ -0,0 +1,24 @@
+#ifndef MATERIALIST_BAKE_HPP
+#define MATERIALIST_BAKE_HPP
+
+namespace vulkan {
+
+struct context;
+
+} // namespace vulkan
+
+namespace bake {
+
+struct queue;
+
+void initialize(queue&, vulkan::context&) noexcept;
+
+void bake_brdf_lut(queue&, vulkan::context&) noexcept;
+
+void poll(queue&, vulkan::context&) noexcept;
+
+void wait_idle(queue&, vulkan::context&) noexcept;
+
+} // namespace bake
+
+#endif // MATERIALIST_BAKE_HPP
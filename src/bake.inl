@@ -0,0 +1,396 @@
+namespace bake {
+
+// one precomputation in flight on the compute queue; `readback` carries the
+// result to the disk cache, or the cached result into the target on a hit
+struct job {
+    std::string                           name;
+    std::string                           cache_path;
+    bool                                  cached = false;
+    vk::DeviceSize                        size   = 0;
+    vulkan::buffer                        readback;
+    vk::UniqueDescriptorPool              descriptor_pool;
+    vk::UniqueCommandBuffer               command_buffer;
+    vk::UniqueFence                       fence;
+    std::chrono::steady_clock::time_point start;
+};
+
+// precomputed lookup tables; each one can be sampled by the graphics queue
+// once poll() has retired the job producing it
+struct queue {
+    vk::UniqueCommandPool    command_pool;
+    vulkan::compute_pipeline brdf_lut_pipeline;
+    std::vector<job>         pending;
+
+    vulkan::image       brdf_lut;
+    vk::UniqueImageView brdf_lut_view;
+};
+
+namespace /* anonymous */ {
+
+constexpr uint32_t BRDF_LUT_SIZE         = 512;
+constexpr uint32_t BRDF_LUT_SAMPLE_COUNT = 1024;
+constexpr uint32_t BRDF_LUT_GROUP_SIZE   = 16;
+constexpr auto     BRDF_LUT_FORMAT       = vk::Format::eR16G16B16A16Sfloat;
+constexpr uint32_t BRDF_LUT_TEXEL_SIZE   = 8;
+
+// the cache file is named after everything that determines its contents
+std::string
+cache_path(std::string_view name, uint64_t input_hash)
+{
+    return fmt::format("materialist.{}.{:016x}.bake", name, input_hash);
+}
+
+vk::UniqueCommandBuffer
+allocate_command_buffer(queue& q, vulkan::context& ctx) noexcept
+{
+    vk::CommandBufferAllocateInfo cbai(
+        *q.command_pool, vk::CommandBufferLevel::ePrimary, 1);
+    auto [result, command_buffers] =
+        ctx.device->allocateCommandBuffersUnique(cbai);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to allocate bake command buffer");
+    }
+
+    return std::move(command_buffers.front());
+}
+
+void
+submit(queue& q, vulkan::context& ctx, job&& j) noexcept
+{
+    if (j.command_buffer->end() != vk::Result::eSuccess) {
+        ERROR("failed to record bake command buffer for {}", j.name);
+    }
+
+    auto [fresult, fence] =
+        ctx.device->createFenceUnique(vk::FenceCreateInfo());
+    if (fresult != vk::Result::eSuccess) {
+        ERROR("failed to create bake fence");
+    }
+    j.fence = std::move(fence);
+
+    vk::SubmitInfo submit_info;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers    = &*j.command_buffer;
+
+    j.start = std::chrono::steady_clock::now();
+    if (ctx.compute_queue.submit(1, &submit_info, *j.fence) !=
+        vk::Result::eSuccess) {
+        ERROR("failed to submit bake {}", j.name);
+    }
+
+    q.pending.push_back(std::move(j));
+}
+
+void
+finish(job& j) noexcept
+{
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - j.start;
+
+    if (j.cached) {
+        spdlog::info(
+            "{} loaded from {} in {:.3f}ms",
+            j.name,
+            j.cache_path,
+            elapsed.count());
+        return;
+    }
+
+    spdlog::info("{} baked in {:.3f}ms", j.name, elapsed.count());
+
+    if (!vulkan::write_file(
+            j.cache_path, j.readback.allocation.mapped, j.size)) {
+        spdlog::warn("failed to write bake cache {}", j.cache_path);
+    }
+}
+
+} // namespace
+
+void
+initialize(queue& q, vulkan::context& ctx) noexcept
+{
+    const auto indices =
+        vulkan::find_queue_families(ctx.physical_device, *ctx.surface);
+
+    vk::CommandPoolCreateInfo cpci(
+        vk::CommandPoolCreateFlagBits::eTransient, *indices.compute_family);
+
+    auto [result, command_pool] = ctx.device->createCommandPoolUnique(cpci);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create bake command pool");
+    }
+    q.command_pool = std::move(command_pool);
+
+    const auto bindings = std::array{vk::DescriptorSetLayoutBinding(
+        0,
+        vk::DescriptorType::eStorageImage,
+        1,
+        vk::ShaderStageFlagBits::eCompute)};
+
+    q.brdf_lut_pipeline = vulkan::create_compute_pipeline(
+        ctx, "brdf_lut.comp", bindings, sizeof(uint32_t));
+}
+
+// integrates the split-sum BRDF term into a 2D table indexed by n.v and
+// roughness; the result is reused from disk when neither the shader nor the
+// table parameters changed
+void
+bake_brdf_lut(queue& q, vulkan::context& ctx) noexcept
+{
+    const auto indices =
+        vulkan::find_queue_families(ctx.physical_device, *ctx.surface);
+
+    const auto shader_code = shaders::embedded("brdf_lut.comp");
+    const auto parameters  = std::array{BRDF_LUT_SIZE,
+                                       BRDF_LUT_SAMPLE_COUNT,
+                                       static_cast<uint32_t>(BRDF_LUT_FORMAT)};
+    const auto input_hash  = hash::fnv1a(
+        parameters.data(),
+        sizeof(parameters),
+        hash::fnv1a(shader_code.data(), shader_code.size_bytes()));
+
+    job j;
+    j.name       = "brdf lut";
+    j.cache_path = cache_path("brdf_lut", input_hash);
+
+    const vk::DeviceSize size =
+        vk::DeviceSize(BRDF_LUT_SIZE) * BRDF_LUT_SIZE * BRDF_LUT_TEXEL_SIZE;
+    j.size = size;
+
+    j.readback = vulkan::create_buffer(
+        ctx,
+        size,
+        vk::BufferUsageFlagBits::eTransferSrc |
+            vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+        memory::strategy::linear);
+
+    auto cached = vulkan::try_read_file(j.cache_path);
+    if (cached && cached->size() == size) {
+        std::memcpy(j.readback.allocation.mapped, cached->data(), size);
+        j.cached = true;
+    }
+
+    // shared with the graphics family so sampling it needs no ownership
+    // transfer; the table is small and written once
+    const auto families =
+        std::array{*indices.compute_family, *indices.graphics_family};
+    const bool concurrent = families[0] != families[1];
+
+    vk::ImageCreateInfo ici(
+        {},
+        vk::ImageType::e2D,
+        BRDF_LUT_FORMAT,
+        vk::Extent3D(BRDF_LUT_SIZE, BRDF_LUT_SIZE, 1),
+        1,
+        1,
+        vk::SampleCountFlagBits::e1,
+        vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled |
+            vk::ImageUsageFlagBits::eTransferSrc |
+            vk::ImageUsageFlagBits::eTransferDst,
+        concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+        concurrent ? 2u : 0u,
+        concurrent ? families.data() : nullptr);
+
+    q.brdf_lut = vulkan::create_image(
+        ctx, ici, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+    vk::ImageSubresourceRange subresource_range(
+        vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    vk::ImageViewCreateInfo ivci(
+        {},
+        *q.brdf_lut.handle,
+        vk::ImageViewType::e2D,
+        BRDF_LUT_FORMAT,
+        vk::ComponentMapping(),
+        subresource_range);
+    auto [ivresult, view] = ctx.device->createImageViewUnique(ivci);
+    if (ivresult != vk::Result::eSuccess) {
+        ERROR("failed to create brdf lut image view");
+    }
+    q.brdf_lut_view = std::move(view);
+
+    j.command_buffer    = allocate_command_buffer(q, ctx);
+    auto command_buffer = *j.command_buffer;
+
+    vk::CommandBufferBeginInfo cbbi(
+        vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    if (command_buffer.begin(cbbi) != vk::Result::eSuccess) {
+        ERROR("failed to begin recording bake command buffer");
+    }
+
+    const vk::BufferImageCopy region(
+        0,
+        0,
+        0,
+        vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+        vk::Offset3D(0, 0, 0),
+        vk::Extent3D(BRDF_LUT_SIZE, BRDF_LUT_SIZE, 1));
+
+    vk::ImageMemoryBarrier barrier(
+        {},
+        j.cached ? vk::AccessFlagBits::eTransferWrite :
+                   vk::AccessFlagBits::eShaderWrite,
+        vk::ImageLayout::eUndefined,
+        j.cached ? vk::ImageLayout::eTransferDstOptimal :
+                   vk::ImageLayout::eGeneral,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        *q.brdf_lut.handle,
+        subresource_range);
+
+    if (j.cached) {
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTopOfPipe,
+            vk::PipelineStageFlagBits::eTransfer,
+            {},
+            nullptr,
+            nullptr,
+            barrier);
+        command_buffer.copyBufferToImage(
+            *j.readback.handle,
+            *q.brdf_lut.handle,
+            vk::ImageLayout::eTransferDstOptimal,
+            region);
+
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.oldLayout     = vk::ImageLayout::eTransferDstOptimal;
+    } else {
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTopOfPipe,
+            vk::PipelineStageFlagBits::eComputeShader,
+            {},
+            nullptr,
+            nullptr,
+            barrier);
+
+        vk::DescriptorPoolSize pool_size(vk::DescriptorType::eStorageImage, 1);
+        vk::DescriptorPoolCreateInfo dpci({}, 1, 1, &pool_size);
+        auto [dpresult, descriptor_pool] =
+            ctx.device->createDescriptorPoolUnique(dpci);
+        if (dpresult != vk::Result::eSuccess) {
+            ERROR("failed to create bake descriptor pool");
+        }
+        j.descriptor_pool = std::move(descriptor_pool);
+
+        vk::DescriptorSetAllocateInfo dsai(
+            *j.descriptor_pool, 1, &*q.brdf_lut_pipeline.set_layout);
+        auto [dsresult, descriptor_sets] =
+            ctx.device->allocateDescriptorSets(dsai);
+        if (dsresult != vk::Result::eSuccess) {
+            ERROR("failed to allocate bake descriptor set");
+        }
+
+        vk::DescriptorImageInfo image_info(
+            vk::Sampler(), *q.brdf_lut_view, vk::ImageLayout::eGeneral);
+        vk::WriteDescriptorSet write(
+            descriptor_sets.front(),
+            0,
+            0,
+            1,
+            vk::DescriptorType::eStorageImage,
+            &image_info);
+        ctx.device->updateDescriptorSets(write, nullptr);
+
+        command_buffer.bindPipeline(
+            vk::PipelineBindPoint::eCompute, *q.brdf_lut_pipeline.pipeline);
+        command_buffer.bindDescriptorSets(
+            vk::PipelineBindPoint::eCompute,
+            *q.brdf_lut_pipeline.layout,
+            0,
+            descriptor_sets,
+            nullptr);
+        command_buffer.pushConstants(
+            *q.brdf_lut_pipeline.layout,
+            vk::ShaderStageFlagBits::eCompute,
+            0,
+            sizeof(BRDF_LUT_SAMPLE_COUNT),
+            &BRDF_LUT_SAMPLE_COUNT);
+
+        const auto group_count =
+            (BRDF_LUT_SIZE + BRDF_LUT_GROUP_SIZE - 1) / BRDF_LUT_GROUP_SIZE;
+        command_buffer.dispatch(group_count, group_count, 1);
+
+        // read the table back for the disk cache
+        barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+        barrier.oldLayout     = vk::ImageLayout::eGeneral;
+        barrier.newLayout     = vk::ImageLayout::eTransferSrcOptimal;
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eComputeShader,
+            vk::PipelineStageFlagBits::eTransfer,
+            {},
+            nullptr,
+            nullptr,
+            barrier);
+        command_buffer.copyImageToBuffer(
+            *q.brdf_lut.handle,
+            vk::ImageLayout::eTransferSrcOptimal,
+            *j.readback.handle,
+            region);
+
+        vk::BufferMemoryBarrier host_barrier(
+            vk::AccessFlagBits::eTransferWrite,
+            vk::AccessFlagBits::eHostRead,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            *j.readback.handle,
+            0,
+            VK_WHOLE_SIZE);
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eHost,
+            {},
+            nullptr,
+            host_barrier,
+            nullptr);
+
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+        barrier.oldLayout     = vk::ImageLayout::eTransferSrcOptimal;
+    }
+
+    // consumers only start after poll() saw the fence, which orders the
+    // accesses; the barrier just moves the table into its final layout
+    barrier.dstAccessMask = {};
+    barrier.newLayout     = vk::ImageLayout::eShaderReadOnlyOptimal;
+    command_buffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer |
+            vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eBottomOfPipe,
+        {},
+        nullptr,
+        nullptr,
+        barrier);
+
+    submit(q, ctx, std::move(j));
+}
+
+// retires finished bakes without blocking
+void
+poll(queue& q, vulkan::context& ctx) noexcept
+{
+    auto done = std::stable_partition(
+        begin(q.pending), end(q.pending), [&ctx](const job& j) {
+            return ctx.device->getFenceStatus(*j.fence) !=
+                   vk::Result::eSuccess;
+        });
+
+    std::for_each(done, end(q.pending), finish);
+    q.pending.erase(done, end(q.pending));
+}
+
+void
+wait_idle(queue& q, vulkan::context& ctx) noexcept
+{
+    for (const auto& j : q.pending) {
+        ctx.device->waitForFences(
+            1u, &*j.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+
+    poll(q, ctx);
+}
+
+} // namespace bake
@@ -0,0 +1,416 @@
+#ifndef MATERIALIST_BCN_HPP
+#define MATERIALIST_BCN_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// CPU decoding of the unsigned LDR block-compressed formats into RGBA8, for
+// devices that can't sample them; every format packs 4x4 texels per block
+namespace bcn {
+
+// bc1_rgb is BC1 without alpha: its three color mode ends in opaque black
+enum class format { bc1, bc1_rgb, bc2, bc3, bc4, bc5, bc7 };
+
+constexpr uint32_t BLOCK_DIMENSION = 4;
+
+// decoded texels of one block, RGBA8 in row-major order
+using texels = std::array<uint8_t, BLOCK_DIMENSION * BLOCK_DIMENSION * 4>;
+
+constexpr size_t
+block_size(format f) noexcept
+{
+    // BC1 and BC4 pack half as many bits per texel as the others
+    const bool half =
+        f == format::bc1 || f == format::bc1_rgb || f == format::bc4;
+    return half ? 8 : 16;
+}
+
+namespace detail {
+
+inline uint64_t
+load64(const std::byte* p) noexcept
+{
+    uint64_t value = 0;
+    for (size_t i = 8; i-- != 0;) { value = value << 8 | uint64_t(p[i]); }
+    return value;
+}
+
+inline std::array<uint8_t, 3>
+expand565(uint32_t c) noexcept
+{
+    const auto r = c >> 11 & 31;
+    const auto g = c >> 5 & 63;
+    const auto b = c & 31;
+    return {
+        uint8_t(r << 3 | r >> 2),
+        uint8_t(g << 2 | g >> 4),
+        uint8_t(b << 3 | b >> 2)};
+}
+
+// the color half shared by BC1, BC2 and BC3; only BC1 has the three color
+// mode with transparent black, the others always interpolate four colors
+inline void
+decode_color(const std::byte* block, bool bc1, texels& out) noexcept
+{
+    const auto c0 = uint32_t(block[0]) | uint32_t(block[1]) << 8;
+    const auto c1 = uint32_t(block[2]) | uint32_t(block[3]) << 8;
+    const auto e0 = expand565(c0);
+    const auto e1 = expand565(c1);
+
+    std::array<std::array<uint8_t, 4>, 4> palette{};
+    for (size_t c = 0; c != 3; ++c) {
+        palette[0][c] = e0[c];
+        palette[1][c] = e1[c];
+        if (c0 > c1 || !bc1) {
+            palette[2][c] = uint8_t((2 * e0[c] + e1[c]) / 3);
+            palette[3][c] = uint8_t((e0[c] + 2 * e1[c]) / 3);
+        } else {
+            palette[2][c] = uint8_t((e0[c] + e1[c]) / 2);
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = c0 > c1 || !bc1 ? 255 : 0;
+
+    for (size_t i = 0; i != 16; ++i) {
+        const auto index = uint32_t(block[4 + i / 4]) >> (2 * (i % 4)) & 3;
+        std::memcpy(&out[i * 4], palette[index].data(), 4);
+    }
+}
+
+// the 8 byte single channel block of BC3 alpha, BC4 and BC5
+inline void
+decode_channel(const std::byte* block, size_t channel, texels& out) noexcept
+{
+    const auto a0 = uint32_t(block[0]);
+    const auto a1 = uint32_t(block[1]);
+
+    std::array<uint8_t, 8> palette{uint8_t(a0), uint8_t(a1)};
+    if (a0 > a1) {
+        for (uint32_t k = 1; k != 7; ++k) {
+            palette[k + 1] = uint8_t(((7 - k) * a0 + k * a1) / 7);
+        }
+    } else {
+        for (uint32_t k = 1; k != 5; ++k) {
+            palette[k + 1] = uint8_t(((5 - k) * a0 + k * a1) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    const auto indices = load64(block) >> 16;
+    for (size_t i = 0; i != 16; ++i) {
+        out[i * 4 + channel] = palette[indices >> (3 * i) & 7];
+    }
+}
+
+// reads the block least significant bit first
+class bit_reader {
+    const std::byte* _data;
+    size_t           _position = 0;
+
+public:
+    explicit bit_reader(const std::byte* data) noexcept : _data(data) {}
+
+    uint32_t
+    read(size_t count) noexcept
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i != count; ++i, ++_position) {
+            const auto bit =
+                uint32_t(_data[_position / 8]) >> (_position % 8) & 1;
+            value |= bit << i;
+        }
+        return value;
+    }
+};
+
+struct bc7_mode {
+    uint8_t subsets;
+    uint8_t partition_bits;
+    uint8_t rotation_bits;
+    uint8_t index_selection_bits;
+    uint8_t color_bits;
+    uint8_t alpha_bits;
+    uint8_t endpoint_pbits;
+    uint8_t shared_pbits;
+    uint8_t index_bits;
+    uint8_t secondary_index_bits;
+};
+
+constexpr std::array<bc7_mode, 8> BC7_MODES = {{
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+    {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+    {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+    {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+}};
+
+// subset of each texel, one bit per texel
+constexpr std::array<uint16_t, 64> BC7_PARTITIONS_2 = {
+    0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+    0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+    0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+    0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+    0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+    0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+    0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+    0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22};
+
+// subset of each texel, two bits per texel
+constexpr std::array<uint32_t, 64> BC7_PARTITIONS_3 = {
+    0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050,
+    0x5555a0a0, 0x5a5a5050, 0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090,
+    0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250, 0xa5945040, 0x0a425054,
+    0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+    0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414,
+    0x50a4a450, 0x6a5a0200, 0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424,
+    0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50, 0x500aa550, 0xaaaa4444,
+    0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+    0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580,
+    0xaa141414, 0x96960000, 0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000,
+    0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254};
+
+// the texel of subset 1 (of 2) whose index drops its top bit
+constexpr std::array<uint8_t, 64> BC7_ANCHORS_2 = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 2,  8,  2,  2,  8,  8,  15, 2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15, 6,  8,  2,  8,  15, 15, 2,  8,  2,  2,  2,  15, 15, 6,
+    6,  2,  6,  8,  15, 15, 2,  2,  15, 15, 15, 15, 15, 2,  2,  15};
+
+// the same for subsets 1 and 2 (of 3)
+constexpr std::array<uint8_t, 64> BC7_ANCHORS_3A = {
+    3,  3,  15, 15, 8,  3,  15, 15, 8,  8,  6,  6,  6,  5,  3,  3,
+    3,  3,  8,  15, 3,  3,  6,  10, 5,  8,  8,  6,  8,  5,  15, 15,
+    8,  15, 3,  5,  6,  10, 8,  15, 15, 3,  15, 5,  15, 15, 15, 15,
+    3,  15, 5,  5,  5,  8,  5,  10, 5,  10, 8,  13, 15, 12, 3,  3};
+
+constexpr std::array<uint8_t, 64> BC7_ANCHORS_3B = {
+    15, 8,  8,  3,  15, 15, 3,  8,  15, 15, 15, 15, 15, 15, 15, 8,
+    15, 8,  15, 3,  15, 8,  15, 8,  3,  15, 6,  10, 15, 15, 10, 8,
+    15, 3,  15, 10, 10, 8,  9,  10, 6,  15, 8,  15, 3,  6,  6,  8,
+    15, 3,  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3,  15, 15, 8};
+
+constexpr std::array<uint8_t, 4> BC7_WEIGHTS_2 = {0, 21, 43, 64};
+constexpr std::array<uint8_t, 8> BC7_WEIGHTS_3 = {0, 9, 18, 27, 37, 46, 55, 64};
+constexpr std::array<uint8_t, 16> BC7_WEIGHTS_4 = {
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+inline uint8_t
+bc7_interpolate(uint32_t e0, uint32_t e1, uint32_t index, size_t bits) noexcept
+{
+    const uint32_t weight = bits == 2 ? BC7_WEIGHTS_2[index] :
+                            bits == 3 ? BC7_WEIGHTS_3[index] :
+                                        BC7_WEIGHTS_4[index];
+    return uint8_t(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+}
+
+inline void
+decode_bc7(const std::byte* block, texels& out) noexcept
+{
+    const auto first = uint32_t(block[0]);
+
+    // the reserved mode 8 decodes to transparent black
+    if (first == 0) {
+        out.fill(0);
+        return;
+    }
+
+    size_t mode_index = 0;
+    while ((first >> mode_index & 1) == 0) { ++mode_index; }
+    const auto& mode = BC7_MODES[mode_index];
+
+    bit_reader bits(block);
+    bits.read(mode_index + 1);
+
+    const auto partition       = bits.read(mode.partition_bits);
+    const auto rotation        = bits.read(mode.rotation_bits);
+    const auto index_selection = bits.read(mode.index_selection_bits);
+
+    // [subset * 2 + endpoint][channel]
+    std::array<std::array<uint32_t, 4>, 6> endpoints{};
+    const size_t endpoint_count = size_t(mode.subsets) * 2;
+    for (size_t c = 0; c != 3; ++c) {
+        for (size_t e = 0; e != endpoint_count; ++e) {
+            endpoints[e][c] = bits.read(mode.color_bits);
+        }
+    }
+    for (size_t e = 0; e != endpoint_count; ++e) {
+        endpoints[e][3] = mode.alpha_bits != 0 ? bits.read(mode.alpha_bits) :
+                                                 255;
+    }
+
+    std::array<uint32_t, 6> pbits{};
+    if (mode.endpoint_pbits != 0) {
+        for (size_t e = 0; e != endpoint_count; ++e) {
+            pbits[e] = bits.read(1);
+        }
+    } else if (mode.shared_pbits != 0) {
+        for (size_t s = 0; s != mode.subsets; ++s) {
+            pbits[s * 2] = pbits[s * 2 + 1] = bits.read(1);
+        }
+    }
+    const auto has_pbits = mode.endpoint_pbits != 0 || mode.shared_pbits != 0;
+
+    // append the p-bit, then replicate the top bits into the low ones
+    for (size_t e = 0; e != endpoint_count; ++e) {
+        for (size_t c = 0; c != 4; ++c) {
+            const size_t channel_bits =
+                c == 3 ? mode.alpha_bits : mode.color_bits;
+            if (channel_bits == 0) { continue; }
+
+            auto       value     = endpoints[e][c];
+            const auto precision = channel_bits + (has_pbits ? 1 : 0);
+            if (has_pbits) { value = value << 1 | pbits[e]; }
+            value <<= 8 - precision;
+            endpoints[e][c] = value | value >> precision;
+        }
+    }
+
+    const auto subset_of = [&](size_t texel) -> size_t {
+        if (mode.subsets == 2) {
+            return BC7_PARTITIONS_2[partition] >> texel & 1;
+        }
+        if (mode.subsets == 3) {
+            return BC7_PARTITIONS_3[partition] >> (2 * texel) & 3;
+        }
+        return 0;
+    };
+    const auto is_anchor = [&](size_t texel) {
+        if (texel == 0) { return true; }
+        if (mode.subsets == 2) { return texel == BC7_ANCHORS_2[partition]; }
+        if (mode.subsets == 3) {
+            return texel == BC7_ANCHORS_3A[partition] ||
+                   texel == BC7_ANCHORS_3B[partition];
+        }
+        return false;
+    };
+
+    std::array<uint32_t, 16> primary{};
+    for (size_t i = 0; i != 16; ++i) {
+        primary[i] = bits.read(mode.index_bits - (is_anchor(i) ? 1 : 0));
+    }
+    std::array<uint32_t, 16> secondary{};
+    if (mode.secondary_index_bits != 0) {
+        for (size_t i = 0; i != 16; ++i) {
+            secondary[i] =
+                bits.read(mode.secondary_index_bits - (i == 0 ? 1 : 0));
+        }
+    }
+
+    for (size_t i = 0; i != 16; ++i) {
+        const auto& e0 = endpoints[subset_of(i) * 2];
+        const auto& e1 = endpoints[subset_of(i) * 2 + 1];
+
+        // modes 4 and 5 index color and alpha separately, mode 4 chooses
+        // which of the two index sets goes to the color
+        auto color_index = primary[i];
+        auto color_bits  = size_t(mode.index_bits);
+        auto alpha_index = primary[i];
+        auto alpha_bits  = size_t(mode.index_bits);
+        if (mode.secondary_index_bits != 0) {
+            alpha_index = secondary[i];
+            alpha_bits  = mode.secondary_index_bits;
+            if (index_selection != 0) {
+                std::swap(color_index, alpha_index);
+                std::swap(color_bits, alpha_bits);
+            }
+        }
+
+        std::array<uint8_t, 4> texel{};
+        for (size_t c = 0; c != 3; ++c) {
+            texel[c] = bc7_interpolate(e0[c], e1[c], color_index, color_bits);
+        }
+        texel[3] = bc7_interpolate(e0[3], e1[3], alpha_index, alpha_bits);
+
+        if (rotation != 0) { std::swap(texel[3], texel[rotation - 1]); }
+        std::memcpy(&out[i * 4], texel.data(), 4);
+    }
+}
+
+} // namespace detail
+
+// decodes one block of `f`; channels the format lacks read 0, alpha 255
+inline void
+decode_block(format f, const std::byte* block, texels& out) noexcept
+{
+    switch (f) {
+    case format::bc1: detail::decode_color(block, true, out); break;
+    case format::bc1_rgb:
+        detail::decode_color(block, true, out);
+        for (size_t i = 0; i != 16; ++i) { out[i * 4 + 3] = 255; }
+        break;
+    case format::bc2: {
+        detail::decode_color(block + 8, false, out);
+        for (size_t i = 0; i != 16; ++i) {
+            const auto alpha = uint32_t(block[i / 2]) >> (4 * (i % 2)) & 15;
+            out[i * 4 + 3]   = uint8_t(alpha * 17);
+        }
+        break;
+    }
+    case format::bc3:
+        detail::decode_color(block + 8, false, out);
+        detail::decode_channel(block, 3, out);
+        break;
+    case format::bc4:
+    case format::bc5:
+        for (size_t i = 0; i != 16; ++i) {
+            out[i * 4 + 1] = 0;
+            out[i * 4 + 2] = 0;
+            out[i * 4 + 3] = 255;
+        }
+        detail::decode_channel(block, 0, out);
+        if (f == format::bc5) { detail::decode_channel(block + 8, 1, out); }
+        break;
+    case format::bc7: detail::decode_bc7(block, out); break;
+    }
+}
+
+// decodes a width x height image stored as `size` bytes of row-major
+// blocks into tightly packed RGBA8; false when `size` doesn't match the
+// extent
+inline bool
+decode_image(
+    format                format,
+    const std::byte*      blocks,
+    size_t                size,
+    uint32_t              width,
+    uint32_t              height,
+    std::vector<uint8_t>& out) noexcept
+{
+    const size_t columns = (size_t(width) + 3) / 4;
+    const size_t rows    = (size_t(height) + 3) / 4;
+    if (columns * rows * block_size(format) != size) { return false; }
+
+    out.resize(size_t(width) * height * 4);
+
+    texels block;
+    for (size_t y = 0; y != rows; ++y) {
+        for (size_t x = 0; x != columns; ++x) {
+            decode_block(
+                format, blocks + (y * columns + x) * block_size(format), block);
+
+            // blocks on the right and bottom edges may be partial
+            const auto texels_x = std::min<size_t>(4, width - x * 4);
+            const auto texels_y = std::min<size_t>(4, height - y * 4);
+            for (size_t row = 0; row != texels_y; ++row) {
+                std::memcpy(
+                    out.data() + ((y * 4 + row) * width + x * 4) * 4,
+                    block.data() + row * 16,
+                    texels_x * 4);
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace bcn
+
+#endif // MATERIALIST_BCN_HPP
@@ -0,0 +1,18 @@
+#ifndef GLM_ALL_HPP
+#define GLM_ALL_HPP
+
+#ifdef __linux__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Wshadow"
+#endif // __linux__
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#ifdef __linux__
+#pragma GCC diagnostic pop
+#endif // __linux__
+
+#endif // GLM_ALL_HPP
@@ -0,0 +1,1064 @@
+#ifndef MATERIALIST_GLTF_HPP
+#define MATERIALIST_GLTF_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+#include "material.hpp"
+#include "mesh_file.hpp"
+#include "scene_graph.hpp"
+
+// glTF 2.0 (.gltf with external or data: URI buffers, and .glb): the
+// document is parsed once up front, each primitive is decoded on its own
+// into packed vertices, so primitives can be decoded in parallel and in any
+// order
+namespace gltf {
+
+constexpr uint32_t NONE = ~0u;
+
+// accessor.componentType
+constexpr uint32_t BYTE           = 5120;
+constexpr uint32_t UNSIGNED_BYTE  = 5121;
+constexpr uint32_t SHORT          = 5122;
+constexpr uint32_t UNSIGNED_SHORT = 5123;
+constexpr uint32_t UNSIGNED_INT   = 5125;
+constexpr uint32_t FLOAT          = 5126;
+
+// primitive.mode
+constexpr uint32_t TRIANGLES = 4;
+
+// extensions a file may require; anything else is rejected
+constexpr std::array<std::string_view, 2> SUPPORTED_EXTENSIONS = {
+    "KHR_mesh_quantization", "KHR_texture_basisu"};
+
+struct bytes {
+    const std::byte* data = nullptr;
+    size_t           size = 0;
+};
+
+struct buffer {
+    std::string uri;
+    size_t      length = 0;
+};
+
+struct buffer_view {
+    uint32_t buffer = NONE;
+    size_t   offset = 0;
+    size_t   length = 0;
+
+    // 0 for tightly packed elements
+    size_t stride = 0;
+};
+
+struct accessor {
+    // NONE for all zeros
+    uint32_t buffer_view    = NONE;
+    size_t   offset         = 0;
+    uint32_t component_type = FLOAT;
+    uint32_t components     = 1;
+    uint32_t count          = 0;
+    bool     normalized     = false;
+
+    // min/max, required for positions
+    bool        has_bounds = false;
+    scene::aabb bounds;
+};
+
+struct primitive {
+    uint32_t position = NONE;
+    uint32_t normal   = NONE;
+    uint32_t uv       = NONE;
+    uint32_t indices  = NONE;
+    uint32_t material = NONE;
+    uint32_t mode     = TRIANGLES;
+};
+
+struct mesh {
+    std::vector<primitive> primitives;
+};
+
+struct surface {
+    std::string           name;
+    material::feature_set features;
+
+    // texture slots are left NO_TEXTURE, the textures are referenced below
+    material::parameters parameters;
+
+    // indices into document::textures, NONE for none
+    uint32_t base_color_texture = NONE;
+    uint32_t normal_texture     = NONE;
+};
+
+struct texture {
+    // the KTX2 image of KHR_texture_basisu when there is one
+    uint32_t image = NONE;
+};
+
+struct image {
+    // empty when the image lives in `buffer_view`
+    std::string uri;
+    uint32_t    buffer_view = NONE;
+    std::string mime_type;
+};
+
+struct node {
+    uint32_t              mesh = NONE;
+    std::vector<uint32_t> children;
+    scene::affine         local = scene::IDENTITY;
+};
+
+struct document {
+    std::vector<buffer>      buffers;
+    std::vector<buffer_view> buffer_views;
+    std::vector<accessor>    accessors;
+    std::vector<mesh>        meshes;
+    std::vector<surface>     surfaces;
+    std::vector<texture>     textures;
+    std::vector<image>       images;
+    std::vector<node>        nodes;
+
+    // nodes of the displayed scene
+    std::vector<uint32_t> roots;
+};
+
+inline scene::affine
+multiply(const scene::affine& a, const scene::affine& b) noexcept
+{
+    scene::affine m;
+    for (size_t r = 0; r != 3; ++r) {
+        for (size_t c = 0; c != 4; ++c) {
+            m[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c] +
+                           a[r * 4 + 2] * b[8 + c];
+        }
+        m[r * 4 + 3] += a[r * 4 + 3];
+    }
+    return m;
+}
+
+inline std::array<float, 3>
+transform_point(const scene::affine& m, const std::array<float, 3>& p) noexcept
+{
+    std::array<float, 3> result;
+    for (size_t r = 0; r != 3; ++r) {
+        result[r] = m[r * 4] * p[0] + m[r * 4 + 1] * p[1] +
+                    m[r * 4 + 2] * p[2] + m[r * 4 + 3];
+    }
+    return result;
+}
+
+// translation * rotation (a unit quaternion, xyzw) * scale
+inline scene::affine
+compose(
+    const std::array<float, 3>& t,
+    const std::array<float, 4>& q,
+    const std::array<float, 3>& s) noexcept
+{
+    const auto [x, y, z, w] = q;
+    return {
+        (1.f - 2.f * (y * y + z * z)) * s[0],
+        2.f * (x * y - z * w) * s[1],
+        2.f * (x * z + y * w) * s[2],
+        t[0],
+        2.f * (x * y + z * w) * s[0],
+        (1.f - 2.f * (x * x + z * z)) * s[1],
+        2.f * (y * z - x * w) * s[2],
+        t[1],
+        2.f * (x * z - y * w) * s[0],
+        2.f * (y * z + x * w) * s[1],
+        (1.f - 2.f * (x * x + y * y)) * s[2],
+        t[2]};
+}
+
+namespace detail {
+
+template <size_t N>
+std::array<float, N>
+floats(const json::value& v, const std::array<float, N>& fallback) noexcept
+{
+    if (v.size() != N) { return fallback; }
+
+    std::array<float, N> result;
+    for (size_t i = 0; i != N; ++i) { result[i] = float(v[i].number()); }
+    return result;
+}
+
+inline uint32_t
+component_count(std::string_view type) noexcept
+{
+    if (type == "SCALAR") { return 1; }
+    if (type == "VEC2") { return 2; }
+    if (type == "VEC3") { return 3; }
+    if (type == "VEC4") { return 4; }
+    if (type == "MAT2") { return 4; }
+    if (type == "MAT3") { return 9; }
+    if (type == "MAT4") { return 16; }
+    return 0;
+}
+
+inline size_t
+component_size(uint32_t component_type) noexcept
+{
+    switch (component_type) {
+    case BYTE:
+    case UNSIGNED_BYTE: return 1;
+    case SHORT:
+    case UNSIGNED_SHORT: return 2;
+    case UNSIGNED_INT:
+    case FLOAT: return 4;
+    default: return 0;
+    }
+}
+
+inline uint32_t
+texture_index(const json::value& info) noexcept
+{
+    return info["index"].index(NONE);
+}
+
+inline surface
+parse_surface(const json::value& v) noexcept
+{
+    surface s;
+    s.name = std::string(v["name"].string());
+
+    const auto& pbr             = v["pbrMetallicRoughness"];
+    const auto  base_color      = detail::floats<4>(
+        pbr["baseColorFactor"], s.parameters.base_color);
+    s.parameters.base_color = base_color;
+    s.parameters.metallic   = float(pbr["metallicFactor"].number(1.));
+    s.parameters.roughness  = float(pbr["roughnessFactor"].number(1.));
+    s.base_color_texture    = texture_index(pbr["baseColorTexture"]);
+    s.normal_texture        = texture_index(v["normalTexture"]);
+    s.features.normal_map   = s.normal_texture != NONE;
+
+    const auto alpha = v["alphaMode"].string("OPAQUE");
+    s.features.alpha = alpha == "MASK"  ? material::alpha_mode::mask :
+                       alpha == "BLEND" ? material::alpha_mode::blend :
+                                          material::alpha_mode::opaque;
+    s.features.double_sided = v["doubleSided"].boolean();
+    s.features.clearcoat =
+        !v["extensions"]["KHR_materials_clearcoat"].is_null();
+
+    return s;
+}
+
+inline node
+parse_node(const json::value& v) noexcept
+{
+    node n;
+    n.mesh = v["mesh"].index(NONE);
+    for (const auto& child : v["children"].items()) {
+        n.children.push_back(child.index(NONE));
+    }
+
+    const auto& matrix = v["matrix"];
+    if (matrix.size() == 16) {
+        // column-major 4x4
+        for (size_t r = 0; r != 3; ++r) {
+            for (size_t c = 0; c != 4; ++c) {
+                n.local[r * 4 + c] = float(matrix[c * 4 + r].number());
+            }
+        }
+    } else {
+        n.local = compose(
+            detail::floats<3>(v["translation"], {0.f, 0.f, 0.f}),
+            detail::floats<4>(v["rotation"], {0.f, 0.f, 0.f, 1.f}),
+            detail::floats<3>(v["scale"], {1.f, 1.f, 1.f}));
+    }
+
+    return n;
+}
+
+// every index refers to an existing element
+inline bool
+is_consistent(const document& doc) noexcept
+{
+    const auto valid = [](uint32_t index, size_t count, bool optional) {
+        return index < count || (optional && index == NONE);
+    };
+
+    for (const auto& view : doc.buffer_views) {
+        if (!valid(view.buffer, doc.buffers.size(), false)) { return false; }
+    }
+    for (const auto& a : doc.accessors) {
+        if (!valid(a.buffer_view, doc.buffer_views.size(), true) ||
+            component_size(a.component_type) == 0 || a.components == 0) {
+            return false;
+        }
+    }
+    for (const auto& m : doc.meshes) {
+        for (const auto& p : m.primitives) {
+            const auto accessors = doc.accessors.size();
+            if (!valid(p.position, accessors, false) ||
+                !doc.accessors[p.position].has_bounds ||
+                !valid(p.normal, accessors, true) ||
+                !valid(p.uv, accessors, true) ||
+                !valid(p.indices, accessors, true) ||
+                !valid(p.material, doc.surfaces.size(), true)) {
+                return false;
+            }
+        }
+    }
+    for (const auto& s : doc.surfaces) {
+        if (!valid(s.base_color_texture, doc.textures.size(), true) ||
+            !valid(s.normal_texture, doc.textures.size(), true)) {
+            return false;
+        }
+    }
+    for (const auto& t : doc.textures) {
+        if (!valid(t.image, doc.images.size(), true)) { return false; }
+    }
+    for (const auto& i : doc.images) {
+        if (!valid(i.buffer_view, doc.buffer_views.size(), true)) {
+            return false;
+        }
+    }
+    for (const auto& n : doc.nodes) {
+        if (!valid(n.mesh, doc.meshes.size(), true)) { return false; }
+        for (auto child : n.children) {
+            if (!valid(child, doc.nodes.size(), false)) { return false; }
+        }
+    }
+    for (auto root : doc.roots) {
+        if (!valid(root, doc.nodes.size(), false)) { return false; }
+    }
+
+    return true;
+}
+
+} // namespace detail
+
+// nullopt for documents that are not glTF 2.0, require an unsupported
+// extension or refer to missing elements
+inline std::optional<document>
+parse(const json::value& root) noexcept
+{
+    if (root["asset"]["version"].string().substr(0, 2) != "2.") {
+        return std::nullopt;
+    }
+    for (const auto& required : root["extensionsRequired"].items()) {
+        if (std::find(
+                begin(SUPPORTED_EXTENSIONS),
+                end(SUPPORTED_EXTENSIONS),
+                required.string()) == end(SUPPORTED_EXTENSIONS)) {
+            return std::nullopt;
+        }
+    }
+
+    document doc;
+
+    for (const auto& v : root["buffers"].items()) {
+        doc.buffers.push_back(
+            {std::string(v["uri"].string()),
+             size_t(v["byteLength"].number())});
+    }
+
+    for (const auto& v : root["bufferViews"].items()) {
+        doc.buffer_views.push_back(
+            {v["buffer"].index(NONE),
+             size_t(v["byteOffset"].number()),
+             size_t(v["byteLength"].number()),
+             size_t(v["byteStride"].number())});
+    }
+
+    for (const auto& v : root["accessors"].items()) {
+        accessor a;
+        a.buffer_view    = v["bufferView"].index(NONE);
+        a.offset         = size_t(v["byteOffset"].number());
+        a.component_type = v["componentType"].index(0);
+        a.components     = detail::component_count(v["type"].string());
+        a.count          = v["count"].index(0);
+        a.normalized     = v["normalized"].boolean();
+
+        if (v["min"].size() >= 3 && v["max"].size() >= 3) {
+            a.has_bounds = true;
+            for (size_t axis = 0; axis != 3; ++axis) {
+                a.bounds.min[axis] = float(v["min"][axis].number());
+                a.bounds.max[axis] = float(v["max"][axis].number());
+            }
+        }
+        doc.accessors.push_back(a);
+    }
+
+    for (const auto& v : root["meshes"].items()) {
+        mesh m;
+        for (const auto& p : v["primitives"].items()) {
+            const auto& attributes = p["attributes"];
+
+            primitive result;
+            result.position = attributes["POSITION"].index(NONE);
+            result.normal   = attributes["NORMAL"].index(NONE);
+            result.uv       = attributes["TEXCOORD_0"].index(NONE);
+            result.indices  = p["indices"].index(NONE);
+            result.material = p["material"].index(NONE);
+            result.mode     = p["mode"].index(TRIANGLES);
+            m.primitives.push_back(result);
+        }
+        doc.meshes.push_back(std::move(m));
+    }
+
+    for (const auto& v : root["materials"].items()) {
+        doc.surfaces.push_back(detail::parse_surface(v));
+    }
+
+    for (const auto& v : root["textures"].items()) {
+        const auto& basisu = v["extensions"]["KHR_texture_basisu"];
+        doc.textures.push_back(
+            {basisu["source"].index(v["source"].index(NONE))});
+    }
+
+    for (const auto& v : root["images"].items()) {
+        doc.images.push_back(
+            {std::string(v["uri"].string()),
+             v["bufferView"].index(NONE),
+             std::string(v["mimeType"].string())});
+    }
+
+    for (const auto& v : root["nodes"].items()) {
+        doc.nodes.push_back(detail::parse_node(v));
+    }
+
+    const auto& scenes = root["scenes"];
+    if (scenes.size() != 0) {
+        for (const auto& n : scenes[root["scene"].index(0)]["nodes"].items()) {
+            doc.roots.push_back(n.index(NONE));
+        }
+    } else {
+        // no scene, show every node without a parent
+        std::vector<bool> is_child(doc.nodes.size());
+        for (const auto& n : doc.nodes) {
+            for (auto child : n.children) {
+                if (child < is_child.size()) { is_child[child] = true; }
+            }
+        }
+        for (uint32_t i = 0; i != doc.nodes.size(); ++i) {
+            if (!is_child[i]) { doc.roots.push_back(i); }
+        }
+    }
+
+    if (!detail::is_consistent(doc)) { return std::nullopt; }
+
+    return doc;
+}
+
+// the chunks of a .glb container
+struct glb {
+    std::string_view json;
+    bytes            binary;
+};
+
+constexpr uint32_t GLB_MAGIC      = 0x46546c67; // "glTF"
+constexpr uint32_t GLB_JSON_CHUNK = 0x4e4f534a; // "JSON"
+constexpr uint32_t GLB_BIN_CHUNK  = 0x004e4942; // "BIN\0"
+
+inline bool
+is_glb(const std::byte* data, size_t size) noexcept
+{
+    uint32_t magic = 0;
+    if (size < sizeof(magic)) { return false; }
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == GLB_MAGIC;
+}
+
+inline std::optional<glb>
+split_glb(const std::byte* data, size_t size) noexcept
+{
+    constexpr size_t HEADER_SIZE = 12;
+    constexpr size_t CHUNK_SIZE  = 8;
+
+    std::array<uint32_t, 3> header;
+    if (!is_glb(data, size) || size < HEADER_SIZE) { return std::nullopt; }
+    std::memcpy(header.data(), data, HEADER_SIZE);
+    if (header[1] != 2 || header[2] > size) { return std::nullopt; }
+
+    glb result;
+    bool has_json = false;
+    for (size_t offset = HEADER_SIZE; header[2] - offset >= CHUNK_SIZE;) {
+        std::array<uint32_t, 2> chunk;
+        std::memcpy(chunk.data(), data + offset, CHUNK_SIZE);
+        offset += CHUNK_SIZE;
+        if (chunk[0] > header[2] - offset) { return std::nullopt; }
+
+        if (chunk[1] == GLB_JSON_CHUNK && !has_json) {
+            result.json = std::string_view(
+                reinterpret_cast<const char*>(data + offset), chunk[0]);
+            has_json = true;
+        } else if (chunk[1] == GLB_BIN_CHUNK && !result.binary.data) {
+            result.binary = {data + offset, chunk[0]};
+        }
+        offset += chunk[0];
+    }
+
+    if (!has_json) { return std::nullopt; }
+    return result;
+}
+
+// RFC 4648 base64, padding optional
+inline std::optional<std::vector<std::byte>>
+decode_base64(std::string_view text) noexcept
+{
+    const auto sextet = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') { return c - 'A'; }
+        if (c >= 'a' && c <= 'z') { return c - 'a' + 26; }
+        if (c >= '0' && c <= '9') { return c - '0' + 52; }
+        if (c == '+') { return 62; }
+        if (c == '/') { return 63; }
+        return -1;
+    };
+
+    while (!text.empty() && text.back() == '=') { text.remove_suffix(1); }
+
+    std::vector<std::byte> result;
+    result.reserve(text.size() / 4 * 3 + 2);
+
+    uint32_t bits  = 0;
+    int      count = 0;
+    for (auto c : text) {
+        const auto value = sextet(c);
+        if (value < 0) { return std::nullopt; }
+
+        bits = bits << 6 | uint32_t(value);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            result.push_back(std::byte((bits >> count) & 0xffu));
+        }
+    }
+
+    return result;
+}
+
+// data:[<mime type>];base64,<data>; nullopt for other URIs
+inline std::optional<std::vector<std::byte>>
+decode_data_uri(std::string_view uri) noexcept
+{
+    if (uri.substr(0, 5) != "data:") { return std::nullopt; }
+
+    const auto comma = uri.find(',');
+    if (comma == std::string_view::npos ||
+        uri.substr(0, comma).find(";base64") == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    return decode_base64(uri.substr(comma + 1));
+}
+
+// a relative URI as a path next to the glTF file
+inline std::string
+resolve_uri(std::string_view directory, std::string_view uri)
+{
+    std::string path(directory);
+    for (size_t i = 0; i < uri.size(); ++i) {
+        const auto hex = [](char c) {
+            return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+        };
+        if (uri[i] == '%' && i + 2 < uri.size()) {
+            path += char(hex(uri[i + 1]) << 4 | hex(uri[i + 2]));
+            i += 2;
+        } else {
+            path += uri[i];
+        }
+    }
+    return path;
+}
+
+// the document with its buffers in memory; buffers point into the mapped
+// files or, for data: URIs, into `decoded`
+struct asset {
+    document                            doc;
+    std::string                         directory;
+    std::vector<bytes>                  buffers;
+    std::vector<std::vector<std::byte>> decoded;
+    std::vector<mesh_file::mapped_file> files;
+};
+
+inline bool
+is_data_uri(std::string_view uri) noexcept
+{
+    return uri.substr(0, 5) == "data:";
+}
+
+// parses the document and maps the file and external buffers without
+// reading them; data: URI buffers are left to decode_buffer()
+inline std::optional<asset>
+open(const std::string& path) noexcept
+{
+    auto file = mesh_file::mapped_file::open(path, false);
+    if (!file) { return std::nullopt; }
+
+    std::string_view json_text(
+        reinterpret_cast<const char*>(file->data()), file->size());
+    bytes binary;
+    if (is_glb(file->data(), file->size())) {
+        const auto chunks = split_glb(file->data(), file->size());
+        if (!chunks) { return std::nullopt; }
+        json_text = chunks->json;
+        binary    = chunks->binary;
+    }
+
+    const auto root = json::parse(json_text);
+    if (!root) { return std::nullopt; }
+    auto doc = parse(*root);
+    if (!doc) { return std::nullopt; }
+
+    asset a;
+    a.doc       = std::move(*doc);
+    a.directory = path.substr(0, path.find_last_of("/\\") + 1);
+    a.buffers.resize(a.doc.buffers.size());
+    a.decoded.resize(a.doc.buffers.size());
+    a.files.push_back(std::move(*file));
+
+    for (size_t i = 0; i != a.doc.buffers.size(); ++i) {
+        const auto& uri = a.doc.buffers[i].uri;
+        if (uri.empty()) {
+            // the GLB binary chunk
+            if (i != 0 || !binary.data) { return std::nullopt; }
+            a.buffers[i] = binary;
+        } else if (!is_data_uri(uri)) {
+            auto external = mesh_file::mapped_file::open(
+                resolve_uri(a.directory, uri), false);
+            if (!external) { return std::nullopt; }
+            a.buffers[i] = {external->data(), external->size()};
+            a.files.push_back(std::move(*external));
+        }
+    }
+
+    return a;
+}
+
+inline bool
+decode_buffer(asset& a, size_t index) noexcept
+{
+    auto decoded = decode_data_uri(a.doc.buffers[index].uri);
+    if (!decoded) { return false; }
+
+    a.decoded[index] = std::move(*decoded);
+    a.buffers[index] = {a.decoded[index].data(), a.decoded[index].size()};
+    return true;
+}
+
+// open() and decode_buffer() for every data: URI buffer
+inline std::optional<asset>
+load(const std::string& path) noexcept
+{
+    auto a = open(path);
+    if (!a) { return std::nullopt; }
+
+    for (size_t i = 0; i != a->buffers.size(); ++i) {
+        if (is_data_uri(a->doc.buffers[i].uri) && !decode_buffer(*a, i)) {
+            return std::nullopt;
+        }
+    }
+    return a;
+}
+
+// the encoded bytes of an image: a view into a buffer, or the file or
+// data: URI the image names, held by `file` or `decoded`
+struct encoded_image {
+    bytes                  data;
+    std::vector<std::byte> decoded;
+    mesh_file::mapped_file file;
+};
+
+// nullopt when the image reaches outside its buffer, or its URI doesn't
+// resolve
+inline std::optional<encoded_image>
+read_image(const asset& a, uint32_t index) noexcept
+{
+    const auto&   i = a.doc.images[index];
+    encoded_image e;
+
+    if (i.uri.empty()) {
+        if (i.buffer_view == NONE) { return std::nullopt; }
+
+        const auto& view = a.doc.buffer_views[i.buffer_view];
+        const auto& buf  = a.buffers[view.buffer];
+        if (buf.data == nullptr || view.offset > buf.size ||
+            view.length > buf.size - view.offset) {
+            return std::nullopt;
+        }
+        e.data = {buf.data + view.offset, view.length};
+    } else if (is_data_uri(i.uri)) {
+        auto decoded = decode_data_uri(i.uri);
+        if (!decoded) { return std::nullopt; }
+        e.decoded = std::move(*decoded);
+        e.data    = {e.decoded.data(), e.decoded.size()};
+    } else {
+        auto file =
+            mesh_file::mapped_file::open(resolve_uri(a.directory, i.uri));
+        if (!file) { return std::nullopt; }
+        e.file = std::move(*file);
+        e.data = {e.file.data(), e.file.size()};
+    }
+    return e;
+}
+
+// where an accessor's elements live in memory
+struct elements {
+    const std::byte* base   = nullptr;
+    size_t           stride = 0;
+
+    // of one component
+    size_t size = 0;
+};
+
+// nullopt when the elements reach outside their buffer view or buffer;
+// a null base for accessors without a buffer view, which are all zeros
+inline std::optional<elements>
+locate(const asset& a, const accessor& acc) noexcept
+{
+    elements e;
+    e.size = detail::component_size(acc.component_type);
+    if (acc.buffer_view == NONE || acc.count == 0) { return e; }
+
+    const auto& view    = a.doc.buffer_views[acc.buffer_view];
+    const auto& buf     = a.buffers[view.buffer];
+    const auto  element = e.size * acc.components;
+    e.stride            = view.stride != 0 ? view.stride : element;
+    if (buf.data == nullptr || view.offset > buf.size ||
+        view.length > buf.size - view.offset || acc.offset > view.length ||
+        view.length - acc.offset < element ||
+        (view.length - acc.offset - element) / e.stride < acc.count - 1) {
+        return std::nullopt;
+    }
+
+    e.base = buf.data + view.offset + acc.offset;
+    return e;
+}
+
+// reads an accessor into `components` floats per element, converting
+// integer components (normalized or not, see KHR_mesh_quantization);
+// elements with fewer components are zero-filled
+inline bool
+read_floats(
+    const asset&        a,
+    uint32_t            index,
+    uint32_t            components,
+    std::vector<float>& out) noexcept
+{
+    const auto& acc = a.doc.accessors[index];
+    const auto  e   = locate(a, acc);
+    if (!e) { return false; }
+
+    out.assign(size_t(acc.count) * components, 0.f);
+    if (!e->base) { return true; }
+
+    const auto used    = std::min(acc.components, components);
+    const auto convert = [&](auto zero, float normalize) {
+        using component = decltype(zero);
+        for (size_t i = 0; i != acc.count; ++i) {
+            for (size_t c = 0; c != used; ++c) {
+                component value;
+                std::memcpy(
+                    &value, e->base + i * e->stride + c * e->size, e->size);
+                out[i * components + c] =
+                    acc.normalized ? std::max(float(value) / normalize, -1.f) :
+                                     float(value);
+            }
+        }
+    };
+
+    switch (acc.component_type) {
+    case BYTE: convert(int8_t(), 127.f); break;
+    case UNSIGNED_BYTE: convert(uint8_t(), 255.f); break;
+    case SHORT: convert(int16_t(), 32767.f); break;
+    case UNSIGNED_SHORT: convert(uint16_t(), 65535.f); break;
+    case UNSIGNED_INT: convert(uint32_t(), 4294967295.f); break;
+    case FLOAT: convert(float(), 1.f); break;
+    default: return false;
+    }
+    return true;
+}
+
+// unsigned byte, short or int indices
+inline bool
+read_indices(
+    const asset& a, uint32_t index, std::vector<uint32_t>& out) noexcept
+{
+    const auto& acc = a.doc.accessors[index];
+    const auto  e   = locate(a, acc);
+    if (!e || !e->base || acc.components != 1 || acc.normalized) {
+        return false;
+    }
+
+    out.resize(acc.count);
+    for (size_t i = 0; i != acc.count; ++i) {
+        const auto* p = e->base + i * e->stride;
+        switch (acc.component_type) {
+        case UNSIGNED_BYTE: out[i] = uint32_t(*p); break;
+        case UNSIGNED_SHORT: {
+            uint16_t value;
+            std::memcpy(&value, p, sizeof(value));
+            out[i] = value;
+            break;
+        }
+        case UNSIGNED_INT: std::memcpy(&out[i], p, sizeof(out[i])); break;
+        default: return false;
+        }
+    }
+    return true;
+}
+
+// one primitive of one node
+struct draw_item {
+    uint32_t node;
+    uint32_t mesh;
+    uint32_t primitive;
+
+    // of the node's meshes, in the unit sphere
+    float radius;
+};
+
+// where a document's nodes end up: world transforms from the scene
+// hierarchy, and a transform fitting the whole scene into the unit sphere
+// in the renderer's axes
+struct placement {
+    scene::hierarchy      hierarchy;
+    std::vector<uint32_t> hierarchy_nodes;
+    std::vector<draw_item> items;
+    scene::affine          to_view = scene::IDENTITY;
+};
+
+// glTF is y-up with counter-clockwise front faces, viewed from +z; the
+// renderer draws y-down with clockwise front faces, viewed from -z. Half a
+// turn around x keeps the scene upright and facing the viewer, decode()
+// reverses the winding as well
+inline placement
+place(const document& doc) noexcept
+{
+    placement p;
+    p.hierarchy_nodes.assign(doc.nodes.size(), NONE);
+    p.hierarchy.reserve(doc.nodes.size());
+
+    // pre-order, as scene::hierarchy requires; a node reached twice (which
+    // glTF forbids) is placed once
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    for (auto it = doc.roots.rbegin(); it != doc.roots.rend(); ++it) {
+        stack.push_back({*it, scene::NO_PARENT});
+    }
+    while (!stack.empty()) {
+        const auto [index, parent] = stack.back();
+        stack.pop_back();
+        if (p.hierarchy_nodes[index] != NONE) { continue; }
+
+        const auto& n = doc.nodes[index];
+
+        scene::aabb bounds;
+        if (n.mesh != NONE) {
+            bounds.min = {1e30f, 1e30f, 1e30f};
+            bounds.max = {-1e30f, -1e30f, -1e30f};
+            for (const auto& prim : doc.meshes[n.mesh].primitives) {
+                const auto& b = doc.accessors[prim.position].bounds;
+                for (size_t axis = 0; axis != 3; ++axis) {
+                    bounds.min[axis] = std::min(bounds.min[axis], b.min[axis]);
+                    bounds.max[axis] = std::max(bounds.max[axis], b.max[axis]);
+                }
+            }
+        }
+
+        p.hierarchy_nodes[index] = p.hierarchy.add(parent, n.local, bounds);
+        for (auto it = n.children.rbegin(); it != n.children.rend(); ++it) {
+            stack.push_back({*it, p.hierarchy_nodes[index]});
+        }
+    }
+    p.hierarchy.update();
+
+    scene::aabb world;
+    world.min = {1e30f, 1e30f, 1e30f};
+    world.max = {-1e30f, -1e30f, -1e30f};
+    for (uint32_t i = 0; i != doc.nodes.size(); ++i) {
+        if (doc.nodes[i].mesh == NONE || p.hierarchy_nodes[i] == NONE) {
+            continue;
+        }
+
+        const auto b = p.hierarchy.world_bounds(p.hierarchy_nodes[i]);
+        for (size_t axis = 0; axis != 3; ++axis) {
+            world.min[axis] = std::min(world.min[axis], b.min[axis]);
+            world.max[axis] = std::max(world.max[axis], b.max[axis]);
+        }
+
+        const auto& prims = doc.meshes[doc.nodes[i].mesh].primitives;
+        for (uint32_t k = 0; k != prims.size(); ++k) {
+            const std::array<float, 3> half = {
+                (b.max[0] - b.min[0]) * .5f,
+                (b.max[1] - b.min[1]) * .5f,
+                (b.max[2] - b.min[2]) * .5f};
+            p.items.push_back(
+                {i, doc.nodes[i].mesh, k, mesh_file::length(half)});
+        }
+    }
+    if (p.items.empty()) { return p; }
+
+    const std::array<float, 3> center = {
+        (world.min[0] + world.max[0]) * .5f,
+        (world.min[1] + world.max[1]) * .5f,
+        (world.min[2] + world.max[2]) * .5f};
+    const auto radius = mesh_file::length(
+        {world.max[0] - center[0],
+         world.max[1] - center[1],
+         world.max[2] - center[2]});
+    const auto scale = radius > 0.f ? 1.f / radius : 1.f;
+
+    p.to_view = {
+        scale, 0.f, 0.f, -scale * center[0],
+        0.f, -scale, 0.f, scale * center[1],
+        0.f, 0.f, -scale, scale * center[2]};
+    for (auto& item : p.items) { item.radius *= scale; }
+
+    // the largest first, so that streaming shows the scene's shape early
+    std::stable_sort(
+        begin(p.items), end(p.items), [](const auto& a, const auto& b) {
+            return a.radius > b.radius;
+        });
+
+    return p;
+}
+
+struct decoded_mesh {
+    std::vector<mesh_file::vertex> vertices;
+    std::vector<uint32_t>          indices;
+
+    // bounds the vertices around the origin
+    float radius = 0.f;
+};
+
+// the primitive's vertices transformed into the renderer's unit sphere;
+// nullopt for primitives that aren't triangle lists, reference data
+// outside their buffers or have attributes of differing counts
+inline std::optional<decoded_mesh>
+decode(const asset& a, const placement& p, const draw_item& item) noexcept
+{
+    const auto& prim = a.doc.meshes[item.mesh].primitives[item.primitive];
+    if (prim.mode != TRIANGLES) { return std::nullopt; }
+
+    const auto m = multiply(
+        p.to_view, p.hierarchy.world(p.hierarchy_nodes[item.node]));
+
+    // the cofactor matrix transforms normals, the determinant's sign tells
+    // mirroring transforms, which flip the winding
+    std::array<float, 9> normal_matrix;
+    for (size_t r = 0; r != 3; ++r) {
+        for (size_t c = 0; c != 3; ++c) {
+            const auto r1 = (r + 1) % 3, r2 = (r + 2) % 3;
+            const auto c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+            normal_matrix[r * 3 + c] = m[r1 * 4 + c1] * m[r2 * 4 + c2] -
+                                       m[r1 * 4 + c2] * m[r2 * 4 + c1];
+        }
+    }
+    const auto determinant = m[0] * normal_matrix[0] +
+                             m[1] * normal_matrix[1] +
+                             m[2] * normal_matrix[2];
+    const bool mirrored = determinant < 0.f;
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+    if (!read_floats(a, prim.position, 3, positions) ||
+        (prim.normal != NONE && !read_floats(a, prim.normal, 3, normals)) ||
+        (prim.uv != NONE && !read_floats(a, prim.uv, 2, uvs))) {
+        return std::nullopt;
+    }
+
+    const auto vertex_count = positions.size() / 3;
+    if ((!normals.empty() && normals.size() / 3 != vertex_count) ||
+        (!uvs.empty() && uvs.size() / 2 != vertex_count)) {
+        return std::nullopt;
+    }
+
+    decoded_mesh result;
+    if (prim.indices != NONE) {
+        if (!read_indices(a, prim.indices, result.indices)) {
+            return std::nullopt;
+        }
+    } else {
+        result.indices.resize(vertex_count);
+        for (uint32_t i = 0; i != vertex_count; ++i) {
+            result.indices[i] = i;
+        }
+    }
+    result.indices.resize(result.indices.size() / 3 * 3);
+    for (auto index : result.indices) {
+        if (index >= vertex_count) { return std::nullopt; }
+    }
+
+    // mirroring transforms flip the winding, so that the triangles are
+    // counter-clockwise after the transform again
+    if (mirrored) {
+        for (size_t i = 0; i != result.indices.size(); i += 3) {
+            std::swap(result.indices[i + 1], result.indices[i + 2]);
+        }
+    }
+
+    std::vector<std::array<float, 3>> transformed(vertex_count);
+    for (size_t i = 0; i != vertex_count; ++i) {
+        transformed[i] = transform_point(
+            m, {positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]});
+    }
+
+    std::vector<std::array<float, 3>> vertex_normals(
+        vertex_count, std::array<float, 3>{0.f, 0.f, 0.f});
+    if (normals.empty()) {
+        // area-weighted face normals
+        for (size_t i = 0; i != result.indices.size(); i += 3) {
+            const auto& v0 = transformed[result.indices[i]];
+            const auto& v1 = transformed[result.indices[i + 1]];
+            const auto& v2 = transformed[result.indices[i + 2]];
+
+            const std::array<float, 3> e1 = {
+                v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]};
+            const std::array<float, 3> e2 = {
+                v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]};
+            const std::array<float, 3> face = {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]};
+            for (size_t k = i; k != i + 3; ++k) {
+                auto& n = vertex_normals[result.indices[k]];
+                for (size_t axis = 0; axis != 3; ++axis) {
+                    n[axis] += face[axis];
+                }
+            }
+        }
+    } else {
+        const auto sign = mirrored ? -1.f : 1.f;
+        for (size_t i = 0; i != vertex_count; ++i) {
+            for (size_t r = 0; r != 3; ++r) {
+                vertex_normals[i][r] =
+                    sign * (normal_matrix[r * 3] * normals[i * 3] +
+                            normal_matrix[r * 3 + 1] * normals[i * 3 + 1] +
+                            normal_matrix[r * 3 + 2] * normals[i * 3 + 2]);
+            }
+        }
+    }
+
+    result.vertices.reserve(vertex_count);
+    for (size_t i = 0; i != vertex_count; ++i) {
+        result.radius =
+            std::max(result.radius, mesh_file::length(transformed[i]));
+        result.vertices.push_back(mesh_file::pack(
+            transformed[i],
+            vertex_normals[i],
+            uvs.empty() ? std::array{0.f, 0.f} :
+                          std::array{uvs[i * 2], uvs[i * 2 + 1]}));
+    }
+
+    // clockwise for the renderer
+    for (size_t i = 0; i != result.indices.size(); i += 3) {
+        std::swap(result.indices[i + 1], result.indices[i + 2]);
+    }
+
+    return result;
+}
+
+} // namespace gltf
+
+#endif // MATERIALIST_GLTF_HPP
@@ -0,0 +1,44 @@
+#ifndef MATERIALIST_HANDOFF_HPP
+#define MATERIALIST_HANDOFF_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// bookkeeping of staging batches whose copies another queue family consumes;
+// kept free of Vulkan so the ordering rules can be tested without a device
+namespace handoff {
+
+// moves the batches of `consuming` whose consumer signaled its timeline
+// value to `idle`. A batch's consumer_value stays 0 until the acquiring
+// submission is known; `completed` (the consumer timeline's counter) is
+// only queried once some batch has one, as there may be no timeline before
+template <typename Batch, typename Query>
+void
+recycle_consumed(
+    std::vector<Batch>& consuming,
+    std::vector<Batch>& idle,
+    Query&&             completed)
+{
+    const bool handed_off =
+        std::any_of(begin(consuming), end(consuming), [](const Batch& b) {
+            return b.consumer_value != 0;
+        });
+    if (!handed_off) { return; }
+
+    const uint64_t value = completed();
+
+    auto consumed = std::stable_partition(
+        begin(consuming), end(consuming), [value](const Batch& b) {
+            return b.consumer_value == 0 || b.consumer_value > value;
+        });
+    for (auto it = consumed; it != end(consuming); ++it) {
+        it->awaiting_consumer = false;
+        idle.push_back(std::move(*it));
+    }
+    consuming.erase(consumed, end(consuming));
+}
+
+} // namespace handoff
+
+#endif // MATERIALIST_HANDOFF_HPP
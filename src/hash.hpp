@@ -0,0 +1,38 @@
+#ifndef MATERIALIST_HASH_HPP
+#define MATERIALIST_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace hash {
+
+constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV1A_PRIME        = 0x100000001b3ull;
+
+// 64-bit FNV-1a; pass a previous result as `seed` to hash several inputs as
+// if they were concatenated
+inline uint64_t
+fnv1a(
+    const void* data, size_t size, uint64_t seed = FNV1A_OFFSET_BASIS) noexcept
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+
+    auto value = seed;
+    for (size_t i = 0; i != size; ++i) {
+        value ^= bytes[i];
+        value *= FNV1A_PRIME;
+    }
+
+    return value;
+}
+
+inline uint64_t
+fnv1a_string(std::string_view text, uint64_t seed = FNV1A_OFFSET_BASIS) noexcept
+{
+    return fnv1a(text.data(), text.size(), seed);
+}
+
+} // namespace hash
+
+#endif // MATERIALIST_HASH_HPP
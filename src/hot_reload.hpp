@@ -0,0 +1,22 @@
+#ifndef MATERIALIST_HOT_RELOAD_HPP
+#define MATERIALIST_HOT_RELOAD_HPP
+
+namespace vulkan {
+
+struct context;
+
+} // namespace vulkan
+
+namespace hot_reload {
+
+struct reloader;
+
+void initialize(reloader&, vulkan::context&) noexcept;
+
+void poll(reloader&, vulkan::context&) noexcept;
+
+void stop(reloader&) noexcept;
+
+} // namespace hot_reload
+
+#endif // MATERIALIST_HOT_RELOAD_HPP
@@ -0,0 +1,304 @@
+namespace hot_reload {
+
+// a recompiled shader; for a graphics stage `pipelines` holds the rebuilt
+// permutations, in permutation order and built for render passes of `format`
+struct result {
+    std::string                           name;
+    std::vector<uint32_t>                 code;
+    bool                                  graphics = false;
+    std::vector<vk::UniquePipeline>       pipelines;
+    vk::Format                            format = vk::Format::eUndefined;
+    std::chrono::steady_clock::time_point start;
+};
+
+// watches the shader sources from a background thread that recompiles a
+// changed shader with glslc and rebuilds the material permutations using it;
+// poll() swaps the results in on the render thread
+struct reloader {
+    vk::Device        device;
+    vk::PipelineCache pipeline_cache;
+    bool              headless = false;
+
+    // what the render thread renders to, published by poll()
+    std::atomic<vk::Format> format{vk::Format::eUndefined};
+
+    // owned by the watcher thread; pipelines are built against its own
+    // render pass and layout, which are compatible with the context's
+    std::map<std::string, vk::UniqueShaderModule, std::less<>> modules;
+    vk::Format               pass_format = vk::Format::eUndefined;
+    vk::UniqueRenderPass     render_pass;
+    vk::UniquePipelineLayout layout;
+
+    std::mutex          mutex;
+    std::vector<result> ready;
+
+    // the permutations to rebuild, published by poll()
+    std::vector<material::pipeline_state> states;
+
+    int               watch_fd = -1;
+    std::atomic<bool> stopping{false};
+    std::thread       thread;
+
+    reloader() = default;
+    reloader(const reloader&) = delete;
+    reloader& operator=(const reloader&) = delete;
+
+    ~reloader() { stop(*this); }
+};
+
+namespace /* anonymous */ {
+
+#if defined(MATERIALIST_HOT_RELOAD) && defined(__linux__)
+
+constexpr auto GRAPHICS_STAGES = std::array{"shader.vert", "shader.frag"};
+
+// how often the watcher checks for stop() while no shader changes
+constexpr int WATCH_TIMEOUT_MS = 100;
+
+// editors save in several writes (or write and rename), the burst is
+// collapsed into one rebuild
+constexpr auto SAVE_SETTLE_TIME = std::chrono::milliseconds(50);
+
+bool
+is_shader_source(std::string_view filename) noexcept
+{
+    const auto dot = filename.rfind('.');
+    if (dot == std::string_view::npos) { return false; }
+
+    const auto extension = filename.substr(dot);
+    return extension == ".vert" || extension == ".frag" ||
+           extension == ".comp";
+}
+
+std::optional<std::vector<uint32_t>>
+compile(const std::string& name) noexcept
+{
+    TRACE_ZONE("compile shader");
+
+    const auto output =
+        fmt::format("{}/{}.spv", MATERIALIST_SHADERS_BINARY_DIR, name);
+    const auto command = fmt::format(
+        "'{}' '{}/{}' -o '{}' 2>&1",
+        MATERIALIST_GLSLC,
+        MATERIALIST_SHADERS_DIR,
+        name,
+        output);
+
+    auto* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        spdlog::warn("failed to run {}", MATERIALIST_GLSLC);
+        return std::nullopt;
+    }
+
+    std::string log;
+    char        line[256];
+    while (std::fgets(line, sizeof(line), pipe)) { log += line; }
+
+    if (pclose(pipe) != 0) {
+        spdlog::warn("failed to compile {}:\n{}", name, log);
+        return std::nullopt;
+    }
+
+    // copied out of the char buffer so the words are aligned
+    const auto bytes = vulkan::try_read_file(output);
+    if (!bytes || bytes->empty() || bytes->size() % sizeof(uint32_t) != 0) {
+        spdlog::warn("failed to read {}", output);
+        return std::nullopt;
+    }
+
+    std::vector<uint32_t> spirv(bytes->size() / sizeof(uint32_t));
+    std::memcpy(spirv.data(), bytes->data(), bytes->size());
+
+    return spirv;
+}
+
+std::vector<vk::UniquePipeline>
+rebuild_permutations(reloader& r, vk::Format format) noexcept
+{
+    TRACE_ZONE("rebuild permutations");
+
+    if (format != r.pass_format) {
+        r.render_pass = vulkan::build_render_pass(r.device, format, r.headless);
+        r.pass_format = format;
+    }
+
+    std::vector<material::pipeline_state> states;
+    {
+        std::lock_guard lock(r.mutex);
+        states = r.states;
+    }
+
+    std::vector<vk::UniquePipeline> pipelines;
+    pipelines.reserve(states.size());
+    for (const auto& state : states) {
+        pipelines.push_back(vulkan::build_graphics_pipeline(
+            r.device,
+            r.pipeline_cache,
+            *r.layout,
+            *r.render_pass,
+            *r.modules.find("shader.vert")->second,
+            *r.modules.find("shader.frag")->second,
+            state));
+    }
+
+    return pipelines;
+}
+
+void
+reload(reloader& r, const std::string& name) noexcept
+{
+    result res;
+    res.name  = name;
+    res.start = std::chrono::steady_clock::now();
+
+    auto spirv = compile(name);
+    if (!spirv) { return; }
+
+    auto module_it = r.modules.find(name);
+    if (module_it != end(r.modules)) {
+        module_it->second = shaders::create_module(r.device, *spirv);
+        res.graphics      = true;
+        res.format        = r.format.load();
+        res.pipelines     = rebuild_permutations(r, res.format);
+    }
+    res.code = std::move(*spirv);
+
+    std::lock_guard lock(r.mutex);
+    r.ready.push_back(std::move(res));
+}
+
+void
+watch(reloader& r) noexcept
+{
+    alignas(inotify_event) char buffer[4096];
+
+    while (!r.stopping) {
+        pollfd pfd{r.watch_fd, POLLIN, 0};
+        if (::poll(&pfd, 1, WATCH_TIMEOUT_MS) <= 0) { continue; }
+
+        std::this_thread::sleep_for(SAVE_SETTLE_TIME);
+
+        std::set<std::string> changed;
+        for (;;) {
+            const auto length = ::read(r.watch_fd, buffer, sizeof(buffer));
+            if (length <= 0) { break; }
+
+            for (size_t offset = 0; offset < static_cast<size_t>(length);) {
+                const auto* event =
+                    reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len != 0 && is_shader_source(event->name)) {
+                    changed.insert(event->name);
+                }
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        for (const auto& name : changed) { reload(r, name); }
+    }
+}
+
+#endif // MATERIALIST_HOT_RELOAD && __linux__
+
+} // namespace
+
+// starts watching the shader sources; graphics stages are rebuilt from the
+// code the context currently uses
+void
+initialize(reloader& r, vulkan::context& ctx) noexcept
+{
+#if defined(MATERIALIST_HOT_RELOAD) && defined(__linux__)
+    r.device         = *ctx.device;
+    r.pipeline_cache = *ctx.pipeline_cache;
+    r.headless       = ctx.headless;
+    r.format         = ctx.format;
+    r.layout         = vulkan::build_graphics_pipeline_layout(
+        r.device, *ctx.bindless_set_layout);
+    r.states         = ctx.materials.states();
+
+    for (const auto* name : GRAPHICS_STAGES) {
+        r.modules.emplace(
+            name,
+            shaders::create_module(
+                r.device, shaders::code(ctx.shader_modules, name)));
+    }
+
+    r.watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (r.watch_fd < 0 ||
+        inotify_add_watch(
+            r.watch_fd, MATERIALIST_SHADERS_DIR, IN_CLOSE_WRITE | IN_MOVED_TO) <
+            0) {
+        spdlog::warn("failed to watch {}", MATERIALIST_SHADERS_DIR);
+        return;
+    }
+
+    r.thread = std::thread([&r] { watch(r); });
+
+    spdlog::info("watching {} for shader changes", MATERIALIST_SHADERS_DIR);
+#else  // MATERIALIST_HOT_RELOAD && __linux__
+    (void)r;
+    (void)ctx;
+    spdlog::warn("shader hot reload is not available in this build");
+#endif // MATERIALIST_HOT_RELOAD && __linux__
+}
+
+// to be called at a frame boundary; pipelines replaced here are parked until
+// the frames using them retire, so nothing waits for the device
+void
+poll(reloader& r, vulkan::context& ctx) noexcept
+{
+    r.format = ctx.format;
+
+    std::vector<result> ready;
+    {
+        std::lock_guard lock(r.mutex);
+        if (r.states.size() != ctx.materials.states().size()) {
+            r.states = ctx.materials.states();
+        }
+        if (r.ready.empty()) { return; }
+        ready.swap(r.ready);
+    }
+
+    for (auto& res : ready) {
+        shaders::replace(ctx.shader_modules, res.name, std::move(res.code));
+
+        if (!res.graphics) {
+            spdlog::info(
+                "{} recompiled, used by pipelines created from now on",
+                res.name);
+            continue;
+        }
+
+        // the swapchain format changed while the watcher was building
+        if (res.format != ctx.format) {
+            vulkan::create_graphics_pipeline(ctx);
+        } else {
+            vulkan::defer_destroy(
+                ctx,
+                std::exchange(
+                    ctx.material_pipelines, std::move(res.pipelines)));
+
+            // materials added since the states were published
+            vulkan::build_materials(ctx);
+        }
+
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - res.start;
+        spdlog::info("{} reloaded in {:.3f}ms", res.name, elapsed.count());
+    }
+}
+
+void
+stop(reloader& r) noexcept
+{
+    r.stopping = true;
+    if (r.thread.joinable()) { r.thread.join(); }
+
+#if defined(MATERIALIST_HOT_RELOAD) && defined(__linux__)
+    if (r.watch_fd >= 0) {
+        close(r.watch_fd);
+        r.watch_fd = -1;
+    }
+#endif // MATERIALIST_HOT_RELOAD && __linux__
+}
+
+} // namespace hot_reload
@@ -0,0 +1,26 @@
+#ifndef MATERIALIST_IMPORTER_HPP
+#define MATERIALIST_IMPORTER_HPP
+
+#include <string>
+
+namespace vulkan {
+
+struct context;
+
+} // namespace vulkan
+
+namespace importer {
+
+struct session;
+
+bool start(session&, vulkan::context&, const std::string&) noexcept;
+
+void poll(session&, vulkan::context&) noexcept;
+
+bool resident(const session&) noexcept;
+
+void stop(session&) noexcept;
+
+} // namespace importer
+
+#endif // MATERIALIST_IMPORTER_HPP
@@ -0,0 +1,478 @@
+namespace importer {
+
+// a primitive decoded by a worker, waiting for poll() to upload it; `mesh`
+// is empty when the primitive could not be decoded
+struct decoded {
+    uint32_t                          item;
+    std::optional<gltf::decoded_mesh> mesh;
+};
+
+// a texture read by a worker, waiting for poll() to upload it; `data`
+// points into `image` and is empty when the texture could not be read
+struct decoded_texture {
+    uint32_t                            texture;
+    gltf::encoded_image                 image;
+    std::optional<vulkan::texture_data> data;
+};
+
+// a texture slot of a material to fill in once the texture is sampleable
+struct texture_patch {
+    uint32_t material;
+    bool     normal;
+    uint32_t slot;
+};
+
+// imports a glTF asset in the background: the document is parsed once on
+// the calling thread, then workers decode the data: URI buffers and, once
+// all of them are in memory, every primitive on its own, largest first,
+// then the KTX2 textures the materials sample. poll() uploads what is
+// ready on the render thread and redraws the scene with it, so the first
+// objects show long before the asset is resident
+struct session {
+    std::string     path;
+    gltf::asset     asset;
+    gltf::placement placement;
+
+    // [glTF material], then the default for primitives without one; the
+    // instance of material slot i is first_instance + i
+    std::vector<uint32_t> materials;
+    uint32_t              first_instance = 0;
+
+    // what start() imports into, for stop() to hand the instances back
+    vulkan::context* ctx = nullptr;
+
+    // decodes run on the context's workers, where recording and pipeline
+    // jobs go ahead of them; `pending_jobs` is guarded by `mutex`
+    bool                    running = false;
+    std::atomic<bool>       cancelled{false};
+    std::atomic<size_t>     pending_buffers{0};
+    size_t                  pending_jobs = 0;
+    std::condition_variable jobs_done;
+
+    // [texture] the materials sample
+    std::vector<uint32_t> textures;
+
+    std::mutex                   mutex;
+    std::vector<decoded>         ready;
+    std::vector<decoded_texture> ready_textures;
+
+    // owned by the render thread
+    std::vector<vulkan::scene_object> objects;
+    size_t                            finished          = 0;
+    size_t                            dropped           = 0;
+    size_t                            textures_finished = 0;
+    size_t                            textures_uploaded = 0;
+
+    // since start(), empty until reached
+    std::chrono::steady_clock::time_point start;
+    std::optional<double>                 first_objects_ms;
+    std::optional<double>                 resident_ms;
+
+    session() = default;
+    session(const session&) = delete;
+    session& operator=(const session&) = delete;
+
+    ~session() { stop(*this); }
+};
+
+namespace /* anonymous */ {
+
+// bytes of decoded geometry one poll() hands to the staging ring, bounding
+// the render thread's stall to a quarter of the ring
+constexpr size_t UPLOAD_BUDGET = 8 << 20;
+
+double
+elapsed_ms(const session& s) noexcept
+{
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - s.start;
+    return elapsed.count();
+}
+
+size_t
+upload_size(const decoded& d) noexcept
+{
+    if (!d.mesh) { return 0; }
+    return d.mesh->vertices.size() * sizeof(mesh_file::vertex) +
+           d.mesh->indices.size() * sizeof(uint32_t);
+}
+
+size_t
+upload_size(const decoded_texture& d) noexcept
+{
+    if (!d.data) { return 0; }
+
+    size_t size = 0;
+    for (const auto& level : d.data->levels) { size += level.size; }
+    return size;
+}
+
+// queues `job` on the context's workers, counted until it returned
+template <typename F>
+void
+submit(session& s, vulkan::context& ctx, F job) noexcept
+{
+    {
+        std::lock_guard lock(s.mutex);
+        ++s.pending_jobs;
+    }
+    ctx.workers->submit([&s, job = std::move(job)](size_t) {
+        job();
+
+        std::lock_guard lock(s.mutex);
+        if (--s.pending_jobs == 0) { s.jobs_done.notify_all(); }
+    });
+}
+
+void
+wait_for_jobs(session& s) noexcept
+{
+    std::unique_lock lock(s.mutex);
+    s.jobs_done.wait(lock, [&s] { return s.pending_jobs == 0; });
+}
+
+// the instances add_materials() took, owned by the scene once one draws
+// with them
+vulkan::instance_range
+session_instances(const session& s) noexcept
+{
+    return {s.first_instance, gsl::narrow<uint32_t>(s.materials.size())};
+}
+
+// waits for the jobs still returning; the session's instances go back
+// unless a scene draws with them, which releases them when it's replaced
+void
+finish(session& s) noexcept
+{
+    wait_for_jobs(s);
+    if (s.objects.empty()) {
+        vulkan::release_instances(*s.ctx, session_instances(s));
+    }
+    s.running = false;
+}
+
+// moves the front of `ready` out, until `bytes` reaches UPLOAD_BUDGET
+template <typename T>
+std::vector<T>
+take(std::vector<T>& ready, size_t& bytes) noexcept
+{
+    size_t count = 0;
+    for (; count != ready.size() && bytes < UPLOAD_BUDGET; ++count) {
+        bytes += upload_size(ready[count]);
+    }
+
+    std::vector<T> batch(
+        std::make_move_iterator(begin(ready)),
+        std::make_move_iterator(begin(ready) + std::ptrdiff_t(count)));
+    ready.erase(begin(ready), begin(ready) + std::ptrdiff_t(count));
+    return batch;
+}
+
+void
+submit_decodes(session& s, vulkan::context& ctx) noexcept
+{
+    for (uint32_t i = 0; i != s.placement.items.size(); ++i) {
+        submit(s, ctx, [&s, i] {
+            if (s.cancelled) { return; }
+
+            TRACE_ZONE("decode primitive");
+            auto mesh =
+                gltf::decode(s.asset, s.placement, s.placement.items[i]);
+
+            std::lock_guard lock(s.mutex);
+            s.ready.push_back({i, std::move(mesh)});
+        });
+    }
+
+    // after the geometry, which is what shows first
+    for (auto texture : s.textures) {
+        submit(s, ctx, [&s, &ctx, texture] {
+            if (s.cancelled) { return; }
+
+            TRACE_ZONE("read texture");
+            const auto  index = s.asset.doc.textures[texture].image;
+            const auto& uri   = s.asset.doc.images[index].uri;
+            const auto  name  = uri.empty() || gltf::is_data_uri(uri) ?
+                                    fmt::format("{} image {}", s.path, index) :
+                                    uri;
+
+            decoded_texture d{texture, {}, std::nullopt};
+            if (auto image = gltf::read_image(s.asset, index)) {
+                d.image = std::move(*image);
+                d.data  = vulkan::read_texture(
+                    ctx, d.image.data.data, d.image.data.size, name);
+            } else {
+                spdlog::warn("failed to read {}", name);
+            }
+
+            std::lock_guard lock(s.mutex);
+            s.ready_textures.push_back(std::move(d));
+        });
+    }
+}
+
+// the textures any material samples
+std::vector<uint32_t>
+sampled_textures(const gltf::document& doc) noexcept
+{
+    std::vector<uint32_t> textures;
+    for (const auto& surface : doc.surfaces) {
+        for (auto t : {surface.base_color_texture, surface.normal_texture}) {
+            if (t != gltf::NONE && doc.textures[t].image != gltf::NONE) {
+                textures.push_back(t);
+            }
+        }
+    }
+
+    std::sort(begin(textures), end(textures));
+    textures.erase(
+        std::unique(begin(textures), end(textures)), end(textures));
+    return textures;
+}
+
+// uploads the textures and points the materials sampling them at their
+// slots once the frame acquiring the uploads retired; frames drawn before
+// that keep sampling the material without them
+void
+upload_textures(
+    session&                      s,
+    vulkan::context&              ctx,
+    std::vector<decoded_texture>& batch) noexcept
+{
+    std::vector<texture_patch> patches;
+    for (const auto& d : batch) {
+        ++s.textures_finished;
+        if (!d.data || ctx.texture_count == ctx.texture_capacity) {
+            continue;
+        }
+
+        const auto slot = vulkan::upload_texture(ctx, *d.data);
+        ++s.textures_uploaded;
+
+        const auto& surfaces = s.asset.doc.surfaces;
+        for (size_t i = 0; i != surfaces.size(); ++i) {
+            if (surfaces[i].base_color_texture == d.texture) {
+                patches.push_back({s.materials[i], false, slot});
+            }
+            if (surfaces[i].normal_texture == d.texture) {
+                patches.push_back({s.materials[i], true, slot});
+            }
+        }
+    }
+    if (patches.empty()) { return; }
+
+    staging::flush(ctx.staging);
+    vulkan::on_frames_retired(
+        ctx, ctx.frame_number + 1, [&ctx, patches = std::move(patches)] {
+            for (const auto& patch : patches) {
+                auto params = ctx.materials.parameters(patch.material);
+                if (patch.normal) {
+                    params.normal_texture = patch.slot;
+                } else {
+                    params.base_color_texture = patch.slot;
+                }
+                vulkan::set_material_parameters(ctx, patch.material, params);
+            }
+            staging::flush(ctx.staging);
+        });
+}
+
+// one material per glTF material plus the default, each with an instance
+// selecting it; textures follow once images are imported
+void
+add_materials(session& s, vulkan::context& ctx) noexcept
+{
+    const auto& surfaces = s.asset.doc.surfaces;
+
+    std::vector<swatch::instance> instances;
+    for (size_t i = 0; i <= surfaces.size(); ++i) {
+        const gltf::surface fallback;
+        const auto& surface = i != surfaces.size() ? surfaces[i] : fallback;
+        const auto  label =
+            surface.name.empty() ? std::to_string(i) : surface.name;
+
+        const auto index = vulkan::add_material(
+            ctx,
+            fmt::format("{}#{}", s.path, label),
+            surface.features,
+            surface.parameters);
+        s.materials.push_back(index);
+
+        swatch::instance instance;
+        instance.material = index;
+        instances.push_back(instance);
+    }
+
+    s.first_instance = vulkan::add_instances(ctx, instances);
+    vulkan::build_materials(ctx);
+}
+
+} // namespace
+
+// parses the asset and starts decoding it; false, with a warning, when
+// `path` is no glTF 2.0 asset this importer supports
+bool
+start(session& s, vulkan::context& ctx, const std::string& path) noexcept
+{
+    TRACE_ZONE("importer::start");
+
+    assert(!s.running);
+    s.start = std::chrono::steady_clock::now();
+
+    auto asset = gltf::open(path);
+    if (!asset) {
+        spdlog::warn("failed to open glTF asset {}", path);
+        return false;
+    }
+
+    s.path      = path;
+    s.asset     = std::move(*asset);
+    s.placement = gltf::place(s.asset.doc);
+    s.textures  = sampled_textures(s.asset.doc);
+
+    add_materials(s, ctx);
+    staging::flush(ctx.staging);
+
+    s.ctx     = &ctx;
+    s.running = true;
+
+    std::vector<size_t> data_uris;
+    for (size_t i = 0; i != s.asset.doc.buffers.size(); ++i) {
+        if (gltf::is_data_uri(s.asset.doc.buffers[i].uri)) {
+            data_uris.push_back(i);
+        }
+    }
+
+    // the primitives may read any buffer, they wait for the last one
+    s.pending_buffers = data_uris.size();
+    if (data_uris.empty()) { submit_decodes(s, ctx); }
+    for (auto i : data_uris) {
+        submit(s, ctx, [&s, &ctx, i] {
+            if (!s.cancelled) {
+                TRACE_ZONE("decode buffer");
+                if (!gltf::decode_buffer(s.asset, i)) {
+                    spdlog::warn("failed to decode buffer {} of {}", i, s.path);
+                }
+            }
+            if (--s.pending_buffers == 0 && !s.cancelled) {
+                submit_decodes(s, ctx);
+            }
+        });
+    }
+
+    spdlog::info(
+        "importing {} primitives and {} textures from {}",
+        s.placement.items.size(),
+        s.textures.size(),
+        path);
+    return true;
+}
+
+// uploads decoded primitives and textures up to UPLOAD_BUDGET and replaces
+// the scene with everything uploaded so far; rebuilding it from all
+// objects is cheap next to uploading the geometry they draw
+void
+poll(session& s, vulkan::context& ctx) noexcept
+{
+    if (!s.running) { return; }
+
+    TRACE_ZONE("importer::poll");
+
+    std::vector<decoded>         batch;
+    std::vector<decoded_texture> textures;
+    {
+        std::lock_guard lock(s.mutex);
+
+        size_t bytes = 0;
+        batch        = take(s.ready, bytes);
+        textures     = take(s.ready_textures, bytes);
+    }
+
+    const auto object_count = s.objects.size();
+    for (auto& d : batch) {
+        ++s.finished;
+
+        const auto& mesh = d.mesh;
+        if (!mesh || s.objects.size() == ctx.scene_object_capacity ||
+            ctx.vertex_capacity - ctx.vertex_count < mesh->vertices.size() ||
+            ctx.index_capacity - ctx.index_count < mesh->indices.size()) {
+            ++s.dropped;
+            continue;
+        }
+
+        const auto& item = s.placement.items[d.item];
+        const auto  material =
+            s.asset.doc.meshes[item.mesh].primitives[item.primitive].material;
+        const auto slot = material != gltf::NONE ?
+                              size_t(material) :
+                              s.asset.doc.surfaces.size();
+
+        s.objects.push_back(
+            {vulkan::add_packed_mesh(
+                 ctx, mesh->vertices, mesh->indices, mesh->radius),
+             s.first_instance + gsl::narrow<uint32_t>(slot),
+             s.materials[slot]});
+    }
+
+    if (s.objects.size() != object_count) {
+        vulkan::create_scene(ctx, s.objects, session_instances(s));
+        staging::flush(ctx.staging);
+
+        if (!s.first_objects_ms) {
+            ctx.draws.clear();
+            s.first_objects_ms = elapsed_ms(s);
+        }
+    }
+
+    upload_textures(s, ctx, textures);
+
+    if (s.finished != s.placement.items.size() ||
+        s.textures_finished != s.textures.size()) {
+        return;
+    }
+
+    s.resident_ms = elapsed_ms(s);
+    spdlog::info(
+        "{}: {} primitives and {} textures resident in {:.3f}ms, first drawn "
+        "after {:.3f}ms",
+        s.path,
+        s.objects.size(),
+        s.textures_uploaded,
+        *s.resident_ms,
+        s.first_objects_ms.value_or(*s.resident_ms));
+    if (s.dropped != 0) {
+        spdlog::warn(
+            "{}: {} primitives failed to decode or didn't fit the scene",
+            s.path,
+            s.dropped);
+    }
+    if (s.textures_uploaded != s.textures.size()) {
+        spdlog::warn(
+            "{}: {} textures failed to load or didn't fit the texture array",
+            s.path,
+            s.textures.size() - s.textures_uploaded);
+    }
+
+    // the geometry and textures live on the GPU now
+    finish(s);
+    s.asset = gltf::asset();
+}
+
+bool
+resident(const session& s) noexcept
+{
+    return s.resident_ms.has_value();
+}
+
+// abandons the decodes still queued; what was uploaded stays in the scene
+void
+stop(session& s) noexcept
+{
+    if (!s.running) { return; }
+
+    // the queued jobs still run, but return right away
+    s.cancelled = true;
+    finish(s);
+}
+
+} // namespace importer
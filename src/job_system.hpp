@@ -0,0 +1,159 @@
+#ifndef MATERIALIST_JOB_SYSTEM_HPP
+#define MATERIALIST_JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jobs {
+
+struct range {
+    size_t chunk;
+    size_t begin;
+    size_t end;
+};
+
+// fixed set of worker threads fed from a single task queue; every task is
+// told the index of the worker running it, so callers can keep per-thread
+// state (e.g. command pools) without locking
+class pool {
+    std::vector<std::thread>                _threads;
+    std::deque<std::function<void(size_t)>> _tasks;
+    std::mutex                              _mutex;
+    std::condition_variable                 _task_cv;
+    std::condition_variable                 _done_cv;
+    size_t                                  _active = 0;
+    bool                                    _stop   = false;
+
+    void
+    run(size_t worker) noexcept
+    {
+        for (;;) {
+            std::function<void(size_t)> task;
+            {
+                std::unique_lock lock(_mutex);
+                _task_cv.wait(lock, [this] { return _stop || !_tasks.empty(); });
+                if (_tasks.empty()) { return; }
+
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+                ++_active;
+            }
+
+            task(worker);
+
+            {
+                std::lock_guard lock(_mutex);
+                --_active;
+            }
+            _done_cv.notify_all();
+        }
+    }
+
+public:
+    explicit pool(size_t thread_count)
+    {
+        thread_count = std::max<size_t>(thread_count, 1);
+        _threads.reserve(thread_count);
+        for (size_t i = 0; i != thread_count; ++i) {
+            _threads.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    pool(const pool&) = delete;
+    pool& operator=(const pool&) = delete;
+
+    ~pool()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stop = true;
+        }
+        _task_cv.notify_all();
+        for (auto& thread : _threads) { thread.join(); }
+    }
+
+    size_t
+    size() const noexcept
+    {
+        return _threads.size();
+    }
+
+    void
+    submit(std::function<void(size_t)> task)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+        _task_cv.notify_one();
+    }
+
+    // blocks until the queue is drained and no task is running
+    void
+    wait()
+    {
+        std::unique_lock lock(_mutex);
+        _done_cv.wait(lock, [this] { return _tasks.empty() && _active == 0; });
+    }
+
+    // splits [0, count) into at most size() chunks of at least `grain`
+    // elements, calls f(worker, range) for each and waits for all of them;
+    // the chunks are queued ahead of submitted tasks, which may be
+    // background work the caller shouldn't wait behind
+    template <typename F>
+    void
+    parallel_for(size_t count, size_t grain, F&& f)
+    {
+        if (count == 0) { return; }
+
+        const auto chunks = chunk_count(count, grain);
+        const auto step   = chunk_step(count, grain);
+
+        size_t remaining = chunks;
+        {
+            std::lock_guard lock(_mutex);
+            for (size_t chunk = chunks; chunk-- != 0;) {
+                const range r{
+                    chunk, chunk * step, std::min(count, (chunk + 1) * step)};
+                _tasks.push_front([&f, &remaining, r, this](size_t worker) {
+                    f(worker, r);
+                    std::lock_guard inner(_mutex);
+                    --remaining;
+                });
+            }
+        }
+        _task_cv.notify_all();
+
+        std::unique_lock lock(_mutex);
+        _done_cv.wait(lock, [&remaining] { return remaining == 0; });
+    }
+
+    // recounted from the step, which rounds up: 5 elements over 4 chunks
+    // step by 2 and so only fill 3
+    size_t
+    chunk_count(size_t count, size_t grain) const noexcept
+    {
+        const auto step = chunk_step(count, grain);
+        return std::max<size_t>((count + step - 1) / step, 1);
+    }
+
+private:
+    size_t
+    chunk_step(size_t count, size_t grain) const noexcept
+    {
+        grain = std::max<size_t>(grain, 1);
+        const auto chunks =
+            std::clamp<size_t>((count + grain - 1) / grain, 1, size());
+        return std::max<size_t>((count + chunks - 1) / chunks, 1);
+    }
+};
+
+} // namespace jobs
+
+#endif // MATERIALIST_JOB_SYSTEM_HPP
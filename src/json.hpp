@@ -0,0 +1,345 @@
+#ifndef MATERIALIST_JSON_HPP
+#define MATERIALIST_JSON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// a read-only JSON DOM, enough for asset manifests; numbers are doubles,
+// objects keep their members in document order
+namespace json {
+
+enum class type { null, boolean, number, string, array, object };
+
+class value {
+    friend class parser;
+
+    type        _type    = type::null;
+    bool        _boolean = false;
+    double      _number  = 0.;
+    std::string _string;
+
+    // array elements, or object member values
+    std::vector<value> _items;
+
+    // object member names, parallel to _items
+    std::vector<std::string> _keys;
+
+    static const value&
+    null() noexcept
+    {
+        static const value n;
+        return n;
+    }
+
+public:
+    type
+    kind() const noexcept
+    {
+        return _type;
+    }
+
+    bool
+    is_null() const noexcept
+    {
+        return _type == type::null;
+    }
+
+    bool
+    boolean(bool fallback = false) const noexcept
+    {
+        return _type == type::boolean ? _boolean : fallback;
+    }
+
+    double
+    number(double fallback = 0.) const noexcept
+    {
+        return _type == type::number ? _number : fallback;
+    }
+
+    // nonnegative integers, e.g. indices; `fallback` for anything else
+    uint32_t
+    index(uint32_t fallback) const noexcept
+    {
+        if (_type != type::number || _number < 0. || _number > 4294967295. ||
+            double(uint32_t(_number)) != _number) {
+            return fallback;
+        }
+        return uint32_t(_number);
+    }
+
+    std::string_view
+    string(std::string_view fallback = {}) const noexcept
+    {
+        return _type == type::string ? std::string_view(_string) : fallback;
+    }
+
+    // elements of an array, members of an object, 0 otherwise
+    size_t
+    size() const noexcept
+    {
+        return _items.size();
+    }
+
+    // an array element; null when out of range or not an array
+    const value&
+    operator[](size_t i) const noexcept
+    {
+        return _type == type::array && i < _items.size() ? _items[i] : null();
+    }
+
+    // an object member; null when missing or not an object
+    const value&
+    operator[](std::string_view key) const noexcept
+    {
+        if (_type == type::object) {
+            for (size_t i = 0; i != _keys.size(); ++i) {
+                if (_keys[i] == key) { return _items[i]; }
+            }
+        }
+        return null();
+    }
+
+    const std::vector<value>&
+    items() const noexcept
+    {
+        return _items;
+    }
+
+    const std::vector<std::string>&
+    keys() const noexcept
+    {
+        return _keys;
+    }
+};
+
+class parser {
+    // deeper documents are rejected instead of overflowing the stack
+    static constexpr size_t MAX_DEPTH = 256;
+
+    std::string_view _text;
+    size_t           _position = 0;
+
+    void
+    skip_whitespace() noexcept
+    {
+        while (_position != _text.size() &&
+               (_text[_position] == ' ' || _text[_position] == '\t' ||
+                _text[_position] == '\n' || _text[_position] == '\r')) {
+            ++_position;
+        }
+    }
+
+    bool
+    consume(char c) noexcept
+    {
+        skip_whitespace();
+        if (_position == _text.size() || _text[_position] != c) {
+            return false;
+        }
+        ++_position;
+        return true;
+    }
+
+    bool
+    consume_literal(std::string_view literal) noexcept
+    {
+        if (_text.substr(_position, literal.size()) != literal) {
+            return false;
+        }
+        _position += literal.size();
+        return true;
+    }
+
+    static void
+    append_utf8(std::string& out, uint32_t code_point)
+    {
+        if (code_point < 0x80) {
+            out += char(code_point);
+        } else if (code_point < 0x800) {
+            out += char(0xc0 | (code_point >> 6));
+            out += char(0x80 | (code_point & 0x3f));
+        } else if (code_point < 0x10000) {
+            out += char(0xe0 | (code_point >> 12));
+            out += char(0x80 | ((code_point >> 6) & 0x3f));
+            out += char(0x80 | (code_point & 0x3f));
+        } else {
+            out += char(0xf0 | (code_point >> 18));
+            out += char(0x80 | ((code_point >> 12) & 0x3f));
+            out += char(0x80 | ((code_point >> 6) & 0x3f));
+            out += char(0x80 | (code_point & 0x3f));
+        }
+    }
+
+    std::optional<uint32_t>
+    parse_hex4() noexcept
+    {
+        if (_text.size() - _position < 4) { return std::nullopt; }
+
+        uint32_t code = 0;
+        for (size_t i = 0; i != 4; ++i) {
+            const auto c = _text[_position++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= uint32_t(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= uint32_t(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= uint32_t(c - 'A' + 10);
+            } else {
+                return std::nullopt;
+            }
+        }
+        return code;
+    }
+
+    bool
+    parse_string(std::string& out)
+    {
+        if (!consume('"')) { return false; }
+
+        for (;;) {
+            if (_position == _text.size()) { return false; }
+
+            const auto c = _text[_position++];
+            if (c == '"') { return true; }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+
+            if (_position == _text.size()) { return false; }
+            switch (_text[_position++]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                auto code = parse_hex4();
+                if (!code) { return false; }
+
+                // a high surrogate combines with the low one following it,
+                // lone surrogates have no UTF-8 encoding
+                if (*code >= 0xd800 && *code < 0xdc00) {
+                    if (!consume_literal("\\u")) { return false; }
+
+                    const auto low = parse_hex4();
+                    if (!low || *low < 0xdc00 || *low >= 0xe000) {
+                        return false;
+                    }
+                    *code = 0x10000 + ((*code - 0xd800) << 10) +
+                            (*low - 0xdc00);
+                } else if (*code >= 0xdc00 && *code < 0xe000) {
+                    return false;
+                }
+                append_utf8(out, *code);
+                break;
+            }
+            default: return false;
+            }
+        }
+    }
+
+    bool
+    parse_number(value& v)
+    {
+        const auto start = _position;
+        while (_position != _text.size() &&
+               std::string_view("+-.0123456789eE").find(_text[_position]) !=
+                   std::string_view::npos) {
+            ++_position;
+        }
+
+        // strtod needs a terminated copy, _text need not be terminated
+        const std::string digits(_text.substr(start, _position - start));
+        char*             end = nullptr;
+
+        v._type   = type::number;
+        v._number = std::strtod(digits.c_str(), &end);
+        return !digits.empty() && end == digits.c_str() + digits.size();
+    }
+
+    bool
+    parse_value(value& v, size_t depth)
+    {
+        if (depth == MAX_DEPTH) { return false; }
+
+        skip_whitespace();
+        if (_position == _text.size()) { return false; }
+
+        switch (_text[_position]) {
+        case '{': {
+            ++_position;
+            v._type = type::object;
+            if (consume('}')) { return true; }
+
+            do {
+                v._keys.emplace_back();
+                if (!parse_string(v._keys.back()) || !consume(':') ||
+                    !parse_value(v._items.emplace_back(), depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+
+            return consume('}');
+        }
+        case '[': {
+            ++_position;
+            v._type = type::array;
+            if (consume(']')) { return true; }
+
+            do {
+                if (!parse_value(v._items.emplace_back(), depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+
+            return consume(']');
+        }
+        case '"': v._type = type::string; return parse_string(v._string);
+        case 't':
+            v._type    = type::boolean;
+            v._boolean = true;
+            return consume_literal("true");
+        case 'f':
+            v._type = type::boolean;
+            return consume_literal("false");
+        case 'n': return consume_literal("null");
+        default: return parse_number(v);
+        }
+    }
+
+public:
+    explicit parser(std::string_view text) noexcept : _text(text) {}
+
+    // the document, or nullopt when `text` is not exactly one JSON value
+    std::optional<value>
+    parse()
+    {
+        value v;
+        if (!parse_value(v, 0)) { return std::nullopt; }
+
+        skip_whitespace();
+        if (_position != _text.size()) { return std::nullopt; }
+
+        return v;
+    }
+};
+
+inline std::optional<value>
+parse(std::string_view text)
+{
+    return parser(text).parse();
+}
+
+} // namespace json
+
+#endif // MATERIALIST_JSON_HPP
@@ -0,0 +1,292 @@
+#ifndef MATERIALIST_KTX2_HPP
+#define MATERIALIST_KTX2_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include "bcn.hpp"
+
+// KTX 2.0 texture containers holding a 2D mip chain in a format the GPU
+// samples as is; the levels are uploaded straight from the file
+namespace ktx2 {
+
+constexpr std::array<uint8_t, 12> IDENTIFIER = {
+    0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+
+// the VkFormat values of header::format this loader handles
+constexpr uint32_t FORMAT_UNDEFINED = 0;
+constexpr uint32_t R8G8B8A8_UNORM   = 37;
+constexpr uint32_t R8G8B8A8_SRGB    = 43;
+constexpr uint32_t BC1_RGB_UNORM    = 131;
+constexpr uint32_t BC1_RGB_SRGB     = 132;
+constexpr uint32_t BC1_RGBA_UNORM   = 133;
+constexpr uint32_t BC1_RGBA_SRGB    = 134;
+constexpr uint32_t BC2_UNORM        = 135;
+constexpr uint32_t BC2_SRGB         = 136;
+constexpr uint32_t BC3_UNORM        = 137;
+constexpr uint32_t BC3_SRGB         = 138;
+constexpr uint32_t BC4_UNORM        = 139;
+constexpr uint32_t BC4_SNORM        = 140;
+constexpr uint32_t BC5_UNORM        = 141;
+constexpr uint32_t BC5_SNORM        = 142;
+constexpr uint32_t BC6H_UFLOAT      = 143;
+constexpr uint32_t BC6H_SFLOAT      = 144;
+constexpr uint32_t BC7_UNORM        = 145;
+constexpr uint32_t BC7_SRGB         = 146;
+constexpr uint32_t ASTC_4x4_UNORM   = 157;
+constexpr uint32_t ASTC_12x12_SRGB  = 184;
+
+// header::supercompression; only NONE is loaded, BasisLZ and Zstandard need
+// a transcoder or inflater first
+constexpr uint32_t SUPERCOMPRESSION_NONE  = 0;
+constexpr uint32_t SUPERCOMPRESSION_BASIS = 1;
+constexpr uint32_t SUPERCOMPRESSION_ZSTD  = 2;
+constexpr uint32_t SUPERCOMPRESSION_ZLIB  = 3;
+
+struct header {
+    std::array<uint8_t, 12> identifier;
+    uint32_t                format;
+    uint32_t                type_size;
+    uint32_t                width;
+    uint32_t                height;
+    uint32_t                depth;
+    uint32_t                layers;
+    uint32_t                faces;
+    uint32_t                levels;
+    uint32_t                supercompression;
+
+    uint32_t dfd_offset;
+    uint32_t dfd_length;
+    uint32_t kvd_offset;
+    uint32_t kvd_length;
+    uint64_t sgd_offset;
+    uint64_t sgd_length;
+};
+
+static_assert(sizeof(header) == 80, "must stay tightly packed");
+
+struct level_index {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t uncompressed_length;
+};
+
+static_assert(sizeof(level_index) == 24, "must stay tightly packed");
+
+// texels per block and bytes per block; uncompressed formats are 1x1
+struct block_shape {
+    uint32_t width;
+    uint32_t height;
+    uint32_t size;
+};
+
+// nullopt for the formats this loader doesn't know
+inline std::optional<block_shape>
+shape(uint32_t format) noexcept
+{
+    if (format == R8G8B8A8_UNORM || format == R8G8B8A8_SRGB) {
+        return block_shape{1, 1, 4};
+    }
+    if (format >= BC1_RGB_UNORM && format <= BC7_SRGB) {
+        // BC1 and BC4 pack half as many bits per texel as the others
+        const bool half = format <= BC1_RGBA_SRGB || format == BC4_UNORM ||
+                          format == BC4_SNORM;
+        return block_shape{4, 4, half ? 8u : 16u};
+    }
+    if (format >= ASTC_4x4_UNORM && format <= ASTC_12x12_SRGB) {
+        // 4x4, 5x4, 5x5, 6x5, 6x6, 8x5, 8x6, 8x8, 10x5, 10x6, 10x8,
+        // 10x10, 12x10, 12x12, each as UNORM then SRGB
+        constexpr std::array<std::array<uint32_t, 2>, 14> ASTC_BLOCKS = {{
+            {4, 4},
+            {5, 4},
+            {5, 5},
+            {6, 5},
+            {6, 6},
+            {8, 5},
+            {8, 6},
+            {8, 8},
+            {10, 5},
+            {10, 6},
+            {10, 8},
+            {10, 10},
+            {12, 10},
+            {12, 12},
+        }};
+        const auto& block = ASTC_BLOCKS[(format - ASTC_4x4_UNORM) / 2];
+        return block_shape{block[0], block[1], 16};
+    }
+    return std::nullopt;
+}
+
+inline bool
+is_srgb(uint32_t format) noexcept
+{
+    switch (format) {
+    case R8G8B8A8_SRGB:
+    case BC1_RGB_SRGB:
+    case BC1_RGBA_SRGB:
+    case BC2_SRGB:
+    case BC3_SRGB:
+    case BC7_SRGB: return true;
+    default:
+        return format >= ASTC_4x4_UNORM && format <= ASTC_12x12_SRGB &&
+               (format - ASTC_4x4_UNORM) % 2 == 1;
+    }
+}
+
+// the block format bcn::decode_image() turns `format` into RGBA8 from;
+// nullopt for formats without a CPU decoder (signed, HDR, ASTC)
+inline std::optional<bcn::format>
+decodable(uint32_t format) noexcept
+{
+    switch (format) {
+    case BC1_RGB_UNORM:
+    case BC1_RGB_SRGB: return bcn::format::bc1_rgb;
+    case BC1_RGBA_UNORM:
+    case BC1_RGBA_SRGB: return bcn::format::bc1;
+    case BC2_UNORM:
+    case BC2_SRGB: return bcn::format::bc2;
+    case BC3_UNORM:
+    case BC3_SRGB: return bcn::format::bc3;
+    case BC4_UNORM: return bcn::format::bc4;
+    case BC5_UNORM: return bcn::format::bc5;
+    case BC7_UNORM:
+    case BC7_SRGB: return bcn::format::bc7;
+    default: return std::nullopt;
+    }
+}
+
+inline uint32_t
+mip_extent(uint32_t extent, size_t level) noexcept
+{
+    return std::max(extent >> level, 1u);
+}
+
+inline size_t
+level_size(const block_shape& block, uint32_t width, uint32_t height) noexcept
+{
+    return size_t((width + block.width - 1) / block.width) *
+           ((height + block.height - 1) / block.height) * block.size;
+}
+
+struct level {
+    const std::byte* data   = nullptr;
+    size_t           size   = 0;
+    uint32_t         width  = 0;
+    uint32_t         height = 0;
+};
+
+// a parsed file, its levels pointing into it, largest first
+struct texture {
+    uint32_t           format           = FORMAT_UNDEFINED;
+    uint32_t           supercompression = SUPERCOMPRESSION_NONE;
+    uint32_t           width            = 0;
+    uint32_t           height           = 0;
+    std::vector<level> levels;
+};
+
+// checks the header and that every level lies within `size` bytes; the
+// sizes of uncompressed levels in a known format are checked too, which
+// leaves supercompressed data and unknown formats to the caller to reject
+inline std::optional<texture>
+parse(const std::byte* data, size_t size) noexcept
+{
+    header h;
+    if (size < sizeof(h)) { return std::nullopt; }
+    std::memcpy(&h, data, sizeof(h));
+
+    // 2D textures only: no arrays, cube maps or volumes
+    if (h.identifier != IDENTIFIER || h.width == 0 || h.height == 0 ||
+        h.depth != 0 || h.layers > 1 || h.faces != 1 || h.levels > 32) {
+        return std::nullopt;
+    }
+
+    // 0 asks for a single level, with the rest generated at load time
+    const uint32_t level_count = std::max(h.levels, 1u);
+    if (std::max(h.width, h.height) >> (level_count - 1) == 0 ||
+        (size - sizeof(h)) / sizeof(level_index) < level_count) {
+        return std::nullopt;
+    }
+
+    texture t;
+    t.format           = h.format;
+    t.supercompression = h.supercompression;
+    t.width            = h.width;
+    t.height           = h.height;
+
+    const auto block = shape(h.format);
+    for (size_t i = 0; i != level_count; ++i) {
+        level_index index;
+        std::memcpy(
+            &index, data + sizeof(h) + i * sizeof(index), sizeof(index));
+        if (index.offset > size || index.length > size - index.offset) {
+            return std::nullopt;
+        }
+
+        level l;
+        l.data   = data + index.offset;
+        l.size   = size_t(index.length);
+        l.width  = mip_extent(h.width, i);
+        l.height = mip_extent(h.height, i);
+        if (h.supercompression == SUPERCOMPRESSION_NONE && block &&
+            l.size != level_size(*block, l.width, l.height)) {
+            return std::nullopt;
+        }
+        t.levels.push_back(l);
+    }
+    return t;
+}
+
+// lays `levels` (largest first, in `format`) out as a KTX2 file; the data
+// format descriptor is left empty, which readers of the VkFormat don't need
+inline std::vector<std::byte>
+serialize(
+    uint32_t                                   format,
+    uint32_t                                   width,
+    uint32_t                                   height,
+    const std::vector<std::vector<std::byte>>& levels)
+{
+    header h{};
+    h.identifier = IDENTIFIER;
+    h.format     = format;
+    h.type_size  = 1;
+    h.width      = width;
+    h.height     = height;
+    h.faces      = 1;
+    h.levels     = uint32_t(levels.size());
+
+    // smallest level first in the file, as the specification recommends,
+    // each aligned to 16 bytes, which covers every block size
+    std::vector<level_index> indices(levels.size());
+    size_t end = sizeof(h) + indices.size() * sizeof(level_index);
+    for (size_t i = levels.size(); i-- != 0;) {
+        end                            = (end + 15) / 16 * 16;
+        indices[i].offset              = end;
+        indices[i].length              = levels[i].size();
+        indices[i].uncompressed_length = levels[i].size();
+        end += levels[i].size();
+    }
+
+    std::vector<std::byte> file(end);
+    std::memcpy(file.data(), &h, sizeof(h));
+    std::memcpy(
+        file.data() + sizeof(h),
+        indices.data(),
+        indices.size() * sizeof(level_index));
+    for (size_t i = 0; i != levels.size(); ++i) {
+        std::memcpy(
+            file.data() + indices[i].offset,
+            levels[i].data(),
+            levels[i].size());
+    }
+    return file;
+}
+
+} // namespace ktx2
+
+#endif // MATERIALIST_KTX2_HPP
@@ -1,16 +1,86 @@
-#include <cstdlib> // EXIT_SUCCESS
+#include <cstdlib> // EXIT_SUCCESS, std::strtoul
 
 #include "materialist.hpp"
 
+namespace /* anonymous */ {
+
+constexpr uint32_t DEFAULT_HEADLESS_FRAME_COUNT = 1000;
+
+std::optional<vulkan::present_policy>
+parse_present_policy(std::string_view name) noexcept
+{
+    if (name == "throughput") { return vulkan::present_policy::throughput; }
+    if (name == "low_latency") { return vulkan::present_policy::low_latency; }
+    if (name == "smooth") { return vulkan::present_policy::smooth; }
+
+    return std::nullopt;
+}
+
+std::optional<unsigned long>
+option_value(std::string_view arg, std::string_view name) noexcept
+{
+    if (arg.substr(0, name.size()) != name) { return std::nullopt; }
+
+    return std::strtoul(arg.data() + name.size(), nullptr, 10);
+}
+
+application::options
+parse_options(int argc, char** argv) noexcept
+{
+    application::options opts;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+
+        if (arg == "--headless") {
+            opts.headless = true;
+        } else if (arg == "--hot-reload") {
+            opts.hot_reload = true;
+        } else if (auto count = option_value(arg, "--frames-in-flight=")) {
+            opts.frames_in_flight =
+                std::max(gsl::narrow<uint32_t>(*count), uint32_t(1));
+        } else if (auto frames = option_value(arg, "--frames=")) {
+            opts.frame_count = gsl::narrow<uint32_t>(*frames);
+        } else if (auto width = option_value(arg, "--width=")) {
+            opts.width = gsl::narrow<int>(*width);
+        } else if (auto height = option_value(arg, "--height=")) {
+            opts.height = gsl::narrow<int>(*height);
+        } else if (auto images = option_value(arg, "--swapchain-images=")) {
+            opts.swapchain_images = gsl::narrow<uint32_t>(*images);
+        } else if (arg.substr(0, 10) == "--present=") {
+            if (auto policy = parse_present_policy(arg.substr(10))) {
+                opts.present = *policy;
+            } else {
+                spdlog::warn("unknown present policy {}", arg.substr(10));
+            }
+        } else if (arg.substr(0, 8) == "--trace=") {
+            opts.trace_path = std::string(arg.substr(8));
+        } else if (arg.substr(0, 7) == "--mesh=") {
+            opts.mesh_path = std::string(arg.substr(7));
+        } else if (arg.substr(0, 7) == "--gltf=") {
+            opts.gltf_path = std::string(arg.substr(7));
+        } else {
+            spdlog::warn("unknown option {}", arg);
+        }
+    }
+
+    if (opts.headless && opts.frame_count == 0) {
+        opts.frame_count = DEFAULT_HEADLESS_FRAME_COUNT;
+    }
+
+    return opts;
+}
+
+} // namespace
+
 int
-main(int, char**)
+main(int argc, char** argv)
 {
 #ifndef NDEBUG
     spdlog::set_level(spdlog::level::debug);
 #endif // NDEBUG
 
-    application::main_loop();
+    application::main_loop(parse_options(argc, argv));
 
     return EXIT_SUCCESS;
 }
-
@@ -0,0 +1,173 @@
+#ifndef MATERIALIST_MATERIAL_HPP
+#define MATERIALIST_MATERIAL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hash.hpp"
+
+namespace material {
+
+enum class alpha_mode : uint32_t { opaque, mask, blend };
+
+// what a material's shaders have to handle
+struct feature_set {
+    bool       normal_map   = false;
+    bool       clearcoat    = false;
+    bool       double_sided = false;
+    alpha_mode alpha        = alpha_mode::opaque;
+};
+
+// constant_id of each feature in shader.frag
+constexpr uint32_t NORMAL_MAP_CONSTANT = 0;
+constexpr uint32_t CLEARCOAT_CONSTANT  = 1;
+constexpr uint32_t ALPHA_MODE_CONSTANT = 2;
+constexpr size_t   CONSTANT_COUNT      = 3;
+
+constexpr uint32_t NO_TEXTURE = ~0u;
+
+// per-material values in the material buffer, indexed by material; mirrors
+// the std430 material_parameters struct in shader.frag
+struct parameters {
+    std::array<float, 4> base_color = {1.f, 1.f, 1.f, 1.f};
+
+    float roughness = .5f;
+    float metallic  = 0.f;
+
+    // slots in the bindless texture array
+    uint32_t base_color_texture = NO_TEXTURE;
+    uint32_t normal_texture     = NO_TEXTURE;
+};
+
+static_assert(sizeof(parameters) == 32, "must match the std430 layout");
+
+// everything that differs between pipeline permutations; feature sets that
+// resolve to the same state share a pipeline
+struct pipeline_state {
+    // fragment shader specialization constants, indexed by constant_id
+    std::array<uint32_t, CONSTANT_COUNT> constants;
+
+    uint32_t blend;
+    uint32_t double_sided;
+
+    bool
+    operator==(const pipeline_state& other) const noexcept
+    {
+        return constants == other.constants && blend == other.blend &&
+               double_sided == other.double_sided;
+    }
+};
+
+inline pipeline_state
+resolve(const feature_set& features) noexcept
+{
+    pipeline_state state{};
+    state.constants[NORMAL_MAP_CONSTANT] = features.normal_map;
+    state.constants[CLEARCOAT_CONSTANT]  = features.clearcoat;
+    state.constants[ALPHA_MODE_CONSTANT] =
+        static_cast<uint32_t>(features.alpha);
+    state.blend        = features.alpha == alpha_mode::blend;
+    state.double_sided = features.double_sided;
+
+    return state;
+}
+
+inline uint64_t
+hash(const pipeline_state& state) noexcept
+{
+    static_assert(
+        sizeof(pipeline_state) == 5 * sizeof(uint32_t),
+        "pipeline_state must not have padding");
+
+    return hash::fnv1a(&state, sizeof(state));
+}
+
+// named materials and the distinct pipeline states they need; a material
+// refers to its state by permutation index, permutations are only ever
+// appended so indices stay valid
+class library {
+    std::vector<std::string>          _names;
+    std::vector<material::parameters> _parameters;
+    std::vector<uint32_t>             _permutations;
+    std::vector<pipeline_state>       _states;
+
+    // hash(state) -> permutations; colliding states chain under one hash
+    std::unordered_multimap<uint64_t, uint32_t> _lookup;
+
+    uint32_t
+    find_or_add(const pipeline_state& state)
+    {
+        const auto key           = hash(state);
+        const auto [first, last] = _lookup.equal_range(key);
+        for (auto it = first; it != last; ++it) {
+            if (_states[it->second] == state) { return it->second; }
+        }
+
+        const auto permutation = static_cast<uint32_t>(_states.size());
+        _states.push_back(state);
+        _lookup.emplace(key, permutation);
+        return permutation;
+    }
+
+public:
+    // returns the index of the new material
+    uint32_t
+    add(std::string                 name,
+        const feature_set&          features,
+        const material::parameters& params = material::parameters())
+    {
+        const auto permutation = find_or_add(resolve(features));
+
+        _names.push_back(std::move(name));
+        _parameters.push_back(params);
+        _permutations.push_back(permutation);
+
+        return static_cast<uint32_t>(_names.size() - 1);
+    }
+
+    size_t
+    size() const noexcept
+    {
+        return _names.size();
+    }
+
+    std::string_view
+    name(uint32_t material) const noexcept
+    {
+        return _names[material];
+    }
+
+    const material::parameters&
+    parameters(uint32_t material) const noexcept
+    {
+        return _parameters[material];
+    }
+
+    // the permutation stays, only values and texture slots change
+    void
+    set_parameters(uint32_t material, const material::parameters& params)
+    {
+        _parameters[material] = params;
+    }
+
+    uint32_t
+    permutation(uint32_t material) const noexcept
+    {
+        return _permutations[material];
+    }
+
+    const std::vector<pipeline_state>&
+    states() const noexcept
+    {
+        return _states;
+    }
+};
+
+} // namespace material
+
+#endif // MATERIALIST_MATERIAL_HPP
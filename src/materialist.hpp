@@ -3,32 +3,93 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iterator>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <set>
+#include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#if defined(MATERIALIST_HOT_RELOAD) && defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // MATERIALIST_HOT_RELOAD && __linux__
+
 #include <GLFW/glfw3.h>
 #include <gsl/gsl>
 #include <vulkan/vulkan.hpp>
 
 #include "application.hpp"
+#include "bake.hpp"
+#include "bcn.hpp"
 #include "glfwwindow.hpp"
+#include "gltf.hpp"
+#include "handoff.hpp"
+#include "hash.hpp"
+#include "hot_reload.hpp"
+#include "importer.hpp"
+#include "job_system.hpp"
+#include "json.hpp"
+#include "ktx2.hpp"
+#include "material.hpp"
+#include "memory.hpp"
+#include "mesh_file.hpp"
+#include "profiler.hpp"
+#include "sample_window.hpp"
+#include "scene_graph.hpp"
+#include "shaders.hpp"
+#include "staging.hpp"
+#include "suballocator.hpp"
+#include "swatch.hpp"
+#include "trace.hpp"
 #include "vulkan_context.hpp"
 
 #include "error_handling.hpp"
+#include "glm_all.hpp"
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
 // implementation starts here
+#include "memory.inl"
+
+#include "staging.inl"
+
+#include "profiler.inl"
+
+#include "shaders.inl"
+
 #include "vulkan_context.inl"
 
+#include "bake.inl"
+
+#include "hot_reload.inl"
+
+#include "importer.inl"
+
 #include "application.inl"
 
 #endif // MATERIALIST_HPP
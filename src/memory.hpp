@@ -0,0 +1,50 @@
+#ifndef MATERIALIST_MEMORY_HPP
+#define MATERIALIST_MEMORY_HPP
+
+#include <functional>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+namespace memory {
+
+struct allocator;
+
+struct allocation;
+
+struct heap_statistics;
+
+enum class strategy { buddy, linear };
+
+// buffers and optimal-tiling images live in separate pools so neighbours
+// never violate bufferImageGranularity
+enum class resource_kind { buffer, image };
+
+// receives the device memory blocks being evacuated; resources living in them
+// should be recreated, new allocations never land in those blocks
+using defragment_hook =
+    std::function<void(const std::vector<vk::DeviceMemory>&)>;
+
+void initialize(allocator&, vk::PhysicalDevice, vk::Device) noexcept;
+
+allocation allocate(
+    allocator&,
+    const vk::MemoryRequirements&,
+    vk::MemoryPropertyFlags,
+    strategy,
+    resource_kind,
+    const vk::MemoryDedicatedAllocateInfo*) noexcept;
+
+void release(allocation&) noexcept;
+
+void defragment(allocator&, double) noexcept;
+
+void trim(allocator&) noexcept;
+
+std::vector<heap_statistics> statistics(allocator&) noexcept;
+
+void log_statistics(allocator&) noexcept;
+
+} // namespace memory
+
+#endif // MATERIALIST_MEMORY_HPP
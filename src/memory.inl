@@ -0,0 +1,453 @@
+namespace memory {
+
+constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;
+
+constexpr size_t POOLS_PER_MEMORY_TYPE = 4; // strategy x resource_kind
+
+struct block {
+    vk::UniqueDeviceMemory memory;
+    std::byte*             mapped = nullptr;
+
+    // set by defragment(); no new allocations land here and the block is
+    // released by trim() once it drains
+    bool evacuating = false;
+
+    std::variant<buddy_allocator, linear_allocator> range;
+};
+
+struct pool {
+    std::vector<std::unique_ptr<block>> blocks;
+};
+
+struct allocation {
+    allocator* owner = nullptr;
+
+    // nullptr for dedicated allocations, which own their memory instead
+    block*                 source = nullptr;
+    vk::UniqueDeviceMemory dedicated;
+
+    vk::DeviceMemory memory;
+    vk::DeviceSize   offset      = 0;
+    vk::DeviceSize   size        = 0;
+    std::byte*       mapped      = nullptr;
+    uint32_t         memory_type = 0;
+
+    allocation() = default;
+
+    allocation(allocation&& other) noexcept { *this = std::move(other); }
+
+    allocation&
+    operator=(allocation&& other) noexcept
+    {
+        if (this != &other) {
+            release(*this);
+            owner       = std::exchange(other.owner, nullptr);
+            source      = std::exchange(other.source, nullptr);
+            dedicated   = std::move(other.dedicated);
+            memory      = std::exchange(other.memory, vk::DeviceMemory());
+            offset      = std::exchange(other.offset, 0);
+            size        = std::exchange(other.size, 0);
+            mapped      = std::exchange(other.mapped, nullptr);
+            memory_type = std::exchange(other.memory_type, 0);
+        }
+        return *this;
+    }
+
+    ~allocation() { release(*this); }
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(memory);
+    }
+};
+
+struct heap_statistics {
+    vk::DeviceSize heap_size = 0;
+
+    // device memory held in blocks and dedicated allocations
+    vk::DeviceSize reserved = 0;
+    vk::DeviceSize used     = 0;
+
+    size_t block_count      = 0;
+    size_t allocation_count = 0;
+    size_t dedicated_count  = 0;
+
+    // see memory::fragmentation(); pooled blocks only
+    double fragmentation = 0.0;
+};
+
+struct allocator {
+    vk::Device                         device;
+    vk::PhysicalDeviceMemoryProperties properties;
+    vk::DeviceSize                     block_size = DEFAULT_BLOCK_SIZE;
+    uint32_t                           max_allocation_count = 0;
+
+    std::array<pool, VK_MAX_MEMORY_TYPES * POOLS_PER_MEMORY_TYPE> pools;
+    std::array<vk::DeviceSize, VK_MAX_MEMORY_TYPES> dedicated_bytes{};
+    std::array<size_t, VK_MAX_MEMORY_TYPES>         dedicated_count{};
+
+    // vkAllocateMemory calls currently alive, bounded by
+    // maxMemoryAllocationCount
+    size_t device_allocation_count = 0;
+
+    defragment_hook on_defragment;
+
+    // allocations happen from worker threads (uploads, bakes) too
+    std::mutex mutex;
+
+    allocator()                 = default;
+    allocator(const allocator&) = delete;
+    allocator& operator=(const allocator&) = delete;
+};
+
+namespace /* anonymous */ {
+
+size_t
+pool_index(uint32_t memory_type, strategy s, resource_kind kind) noexcept
+{
+    return memory_type * POOLS_PER_MEMORY_TYPE +
+           static_cast<size_t>(s) * 2 + static_cast<size_t>(kind);
+}
+
+uint32_t
+find_memory_type(
+    const allocator&        a,
+    uint32_t                type_filter,
+    vk::MemoryPropertyFlags properties) noexcept
+{
+    for (uint32_t i = 0; i != a.properties.memoryTypeCount; ++i) {
+        if ((type_filter & (1u << i)) &&
+            (a.properties.memoryTypes[i].propertyFlags & properties) ==
+                properties) {
+            return i;
+        }
+    }
+
+    ERROR("failed to find suitable memory type");
+}
+
+bool
+is_host_visible(const allocator& a, uint32_t memory_type) noexcept
+{
+    return static_cast<bool>(
+        a.properties.memoryTypes[memory_type].propertyFlags &
+        vk::MemoryPropertyFlagBits::eHostVisible);
+}
+
+// the caller holds a.mutex
+vk::UniqueDeviceMemory
+allocate_device_memory(
+    allocator&                    a,
+    const vk::MemoryAllocateInfo& mai,
+    std::byte**                   mapped) noexcept
+{
+    if (a.device_allocation_count == a.max_allocation_count) {
+        ERROR("maxMemoryAllocationCount ({}) reached", a.max_allocation_count);
+    }
+
+    auto [result, memory] = a.device.allocateMemoryUnique(mai);
+    if (result != vk::Result::eSuccess) {
+        ERROR(
+            "failed to allocate {} bytes of device memory",
+            mai.allocationSize);
+    }
+    ++a.device_allocation_count;
+
+    *mapped = nullptr;
+    if (is_host_visible(a, mai.memoryTypeIndex)) {
+        // host-visible memory stays mapped for its whole lifetime
+        auto [mmresult, data] = a.device.mapMemory(*memory, 0, VK_WHOLE_SIZE);
+        if (mmresult != vk::Result::eSuccess) {
+            ERROR("failed to map device memory");
+        }
+        *mapped = static_cast<std::byte*>(data);
+    }
+
+    return std::move(memory);
+}
+
+// the caller holds a.mutex
+std::unique_ptr<block>
+create_block(allocator& a, uint32_t memory_type, strategy s) noexcept
+{
+    using range_type = decltype(block::range);
+
+    auto b = std::make_unique<block>(block{
+        {},
+        nullptr,
+        false,
+        s == strategy::buddy ? range_type(buddy_allocator(a.block_size)) :
+                               range_type(linear_allocator(a.block_size))});
+
+    b->memory = allocate_device_memory(
+        a, vk::MemoryAllocateInfo(a.block_size, memory_type), &b->mapped);
+
+    spdlog::debug(
+        "memory: new {} MiB block in memory type {}",
+        a.block_size >> 20,
+        memory_type);
+
+    return b;
+}
+
+} // namespace
+
+void
+initialize(
+    allocator&         a,
+    vk::PhysicalDevice physical_device,
+    vk::Device         device) noexcept
+{
+    a.device               = device;
+    a.properties           = physical_device.getMemoryProperties();
+    a.max_allocation_count =
+        physical_device.getProperties().limits.maxMemoryAllocationCount;
+
+    // small heaps (e.g. the 256 MiB host-visible device-local window) would
+    // be exhausted by a handful of default sized blocks
+    for (uint32_t i = 0; i != a.properties.memoryHeapCount; ++i) {
+        a.block_size =
+            std::min(a.block_size, a.properties.memoryHeaps[i].size / 8);
+    }
+    a.block_size = std::max<vk::DeviceSize>(a.block_size, 1ull << 20);
+    while (!is_power_of_two(a.block_size)) {
+        a.block_size &= a.block_size - 1;
+    }
+
+    spdlog::debug(
+        "memory: {} MiB blocks, at most {} device allocations",
+        a.block_size >> 20,
+        a.max_allocation_count);
+}
+
+allocation
+allocate(
+    allocator&                             a,
+    const vk::MemoryRequirements&          requirements,
+    vk::MemoryPropertyFlags                properties,
+    strategy                               s,
+    resource_kind                          kind,
+    const vk::MemoryDedicatedAllocateInfo* dedicated) noexcept
+{
+    allocation result;
+    result.owner = &a;
+    result.memory_type =
+        find_memory_type(a, requirements.memoryTypeBits, properties);
+    result.size = requirements.size;
+
+    std::lock_guard lock(a.mutex);
+
+    if (dedicated || requirements.size > a.block_size / 2) {
+        vk::MemoryAllocateInfo mai(requirements.size, result.memory_type);
+        if (dedicated) { mai.setPNext(dedicated); }
+
+        result.dedicated = allocate_device_memory(a, mai, &result.mapped);
+        result.memory    = *result.dedicated;
+
+        a.dedicated_bytes[result.memory_type] += requirements.size;
+        ++a.dedicated_count[result.memory_type];
+
+        return result;
+    }
+
+    auto& blocks = a.pools[pool_index(result.memory_type, s, kind)].blocks;
+
+    auto try_block = [&result, &requirements](block& b) {
+        if (b.evacuating) { return false; }
+
+        const auto offset = std::visit(
+            [&requirements](auto& range) {
+                return range.allocate(
+                    requirements.size, requirements.alignment);
+            },
+            b.range);
+        if (!offset) { return false; }
+
+        result.source = &b;
+        result.memory = *b.memory;
+        result.offset = *offset;
+        result.mapped = b.mapped ? b.mapped + *offset : nullptr;
+        return true;
+    };
+
+    for (auto& b : blocks) {
+        if (try_block(*b)) { return result; }
+    }
+
+    blocks.push_back(create_block(a, result.memory_type, s));
+    if (!try_block(*blocks.back())) {
+        ERROR("failed to sub-allocate {} bytes", requirements.size);
+    }
+
+    return result;
+}
+
+void
+release(allocation& alloc) noexcept
+{
+    if (!alloc.owner) { return; }
+
+    auto& a = *alloc.owner;
+    {
+        std::lock_guard lock(a.mutex);
+
+        if (alloc.source) {
+            std::visit(
+                [&alloc](auto& range) { range.free(alloc.offset, alloc.size); },
+                alloc.source->range);
+        } else {
+            a.dedicated_bytes[alloc.memory_type] -= alloc.size;
+            --a.dedicated_count[alloc.memory_type];
+            --a.device_allocation_count;
+            alloc.dedicated.reset();
+        }
+    }
+
+    alloc.owner  = nullptr;
+    alloc.source = nullptr;
+    alloc.memory = vk::DeviceMemory();
+    alloc.offset = 0;
+    alloc.size   = 0;
+    alloc.mapped = nullptr;
+}
+
+// offers sparsely used blocks (occupancy below max_occupancy) of pools with
+// more than one block to the defragment hook, which is expected to recreate
+// the resources living in them
+void
+defragment(allocator& a, double max_occupancy) noexcept
+{
+    std::vector<vk::DeviceMemory> candidates;
+    {
+        std::lock_guard lock(a.mutex);
+
+        for (auto& p : a.pools) {
+            if (p.blocks.size() < 2) { continue; }
+
+            for (auto& b : p.blocks) {
+                const auto [used, capacity] = std::visit(
+                    [](const auto& range) {
+                        return std::pair(range.used(), range.capacity());
+                    },
+                    b->range);
+
+                if (used != 0 && static_cast<double>(used) <
+                                     max_occupancy *
+                                         static_cast<double>(capacity)) {
+                    b->evacuating = true;
+                    candidates.push_back(*b->memory);
+                }
+            }
+        }
+    }
+
+    if (candidates.empty()) { return; }
+
+    spdlog::debug("memory: evacuating {} blocks", candidates.size());
+
+    if (a.on_defragment) { a.on_defragment(candidates); }
+
+    trim(a);
+}
+
+// releases blocks without live allocations, keeping one spare block per pool
+// to avoid allocation churn
+void
+trim(allocator& a) noexcept
+{
+    std::lock_guard lock(a.mutex);
+
+    for (auto& p : a.pools) {
+        bool spare_kept = false;
+
+        auto drained = [&spare_kept](const std::unique_ptr<block>& b) {
+            const auto count = std::visit(
+                [](const auto& range) { return range.allocation_count(); },
+                b->range);
+            if (count != 0) { return false; }
+            if (b->evacuating || spare_kept) { return true; }
+            spare_kept = true;
+            return false;
+        };
+
+        auto it = std::remove_if(begin(p.blocks), end(p.blocks), drained);
+        a.device_allocation_count -=
+            static_cast<size_t>(std::distance(it, end(p.blocks)));
+        p.blocks.erase(it, end(p.blocks));
+    }
+}
+
+std::vector<heap_statistics>
+statistics(allocator& a) noexcept
+{
+    std::vector<heap_statistics> heaps(a.properties.memoryHeapCount);
+    for (uint32_t i = 0; i != a.properties.memoryHeapCount; ++i) {
+        heaps[i].heap_size = a.properties.memoryHeaps[i].size;
+    }
+
+    std::vector<vk::DeviceSize> free_bytes(heaps.size());
+    std::vector<vk::DeviceSize> largest_free(heaps.size());
+
+    std::lock_guard lock(a.mutex);
+
+    for (uint32_t type = 0; type != a.properties.memoryTypeCount; ++type) {
+        const auto heap  = a.properties.memoryTypes[type].heapIndex;
+        auto&      stats = heaps[heap];
+
+        stats.reserved += a.dedicated_bytes[type];
+        stats.used += a.dedicated_bytes[type];
+        stats.dedicated_count += a.dedicated_count[type];
+        stats.allocation_count += a.dedicated_count[type];
+
+        for (size_t p = 0; p != POOLS_PER_MEMORY_TYPE; ++p) {
+            const auto& blocks =
+                a.pools[type * POOLS_PER_MEMORY_TYPE + p].blocks;
+            for (const auto& b : blocks) {
+                std::visit(
+                    [&](const auto& range) {
+                        stats.reserved += range.capacity();
+                        stats.used += range.used();
+                        stats.allocation_count += range.allocation_count();
+                        free_bytes[heap] += range.capacity() - range.used();
+                        largest_free[heap] =
+                            std::max(largest_free[heap], range.largest_free());
+                    },
+                    b->range);
+                ++stats.block_count;
+            }
+        }
+    }
+
+    for (size_t heap = 0; heap != heaps.size(); ++heap) {
+        heaps[heap].fragmentation =
+            fragmentation(free_bytes[heap], largest_free[heap]);
+    }
+
+    return heaps;
+}
+
+void
+log_statistics(allocator& a) noexcept
+{
+    constexpr double MiB = 1024.0 * 1024.0;
+
+    const auto heaps = statistics(a);
+    for (size_t i = 0; i != heaps.size(); ++i) {
+        const auto& heap = heaps[i];
+        if (heap.reserved == 0) { continue; }
+
+        spdlog::info(
+            "memory heap {}: {:.1f}/{:.1f} MiB used/reserved of {:.1f} MiB, "
+            "{} allocations in {} blocks + {} dedicated, {:.0f}% fragmented",
+            i,
+            static_cast<double>(heap.used) / MiB,
+            static_cast<double>(heap.reserved) / MiB,
+            static_cast<double>(heap.heap_size) / MiB,
+            heap.allocation_count - heap.dedicated_count,
+            heap.block_count,
+            heap.dedicated_count,
+            heap.fragmentation * 100.0);
+    }
+}
+
+} // namespace memory
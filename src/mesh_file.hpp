@@ -0,0 +1,523 @@
+#ifndef MATERIALIST_MESH_FILE_HPP
+#define MATERIALIST_MESH_FILE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MATERIALIST_MESH_FILE_MMAP 1
+#endif
+
+// binary mesh container whose sections are laid out exactly as the GPU
+// reads them, so loading is a mapping plus one copy per section:
+//
+//   header | vertices | indices | meshlets
+//
+// every section starts on a SECTION_ALIGNMENT boundary
+namespace mesh_file {
+
+constexpr std::array<char, 4> MAGIC   = {'M', 'T', 'M', 'S'};
+constexpr uint32_t            VERSION = 1;
+
+constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+// meshlet limits of the common mesh shading hardware sweet spot
+constexpr uint32_t MAX_MESHLET_VERTICES  = 64;
+constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+// the vertex format of the shared vertex buffer: the position as snorm16
+// within [-1, 1] (w unused), the normal octahedral-encoded as snorm16 and
+// the uv as half floats
+struct vertex {
+    std::array<int16_t, 4>  position = {};
+    std::array<int16_t, 2>  normal   = {};
+    std::array<uint16_t, 2> uv       = {};
+};
+
+static_assert(sizeof(vertex) == 16, "must match the vertex input state");
+
+// a run of at most MAX_MESHLET_TRIANGLES triangles referencing at most
+// MAX_MESHLET_VERTICES vertices, [first_index, first_index + 3 *
+// triangle_count) of the index section, bounded by a sphere
+struct meshlet {
+    std::array<float, 3> center         = {};
+    float                radius         = 0.f;
+    uint32_t             first_index    = 0;
+    uint32_t             triangle_count = 0;
+    uint32_t             vertex_count   = 0;
+    uint32_t             padding        = 0;
+};
+
+static_assert(sizeof(meshlet) == 32, "must stay tightly packed");
+
+struct header {
+    std::array<char, 4> magic         = MAGIC;
+    uint32_t            version       = VERSION;
+    uint32_t            vertex_count  = 0;
+    uint32_t            index_count   = 0;
+    uint32_t            meshlet_count = 0;
+
+    // bounds the vertices around the origin
+    float radius = 0.f;
+
+    // from the start of the file
+    uint64_t vertex_offset  = 0;
+    uint64_t index_offset   = 0;
+    uint64_t meshlet_offset = 0;
+};
+
+static_assert(sizeof(header) == 48, "must stay tightly packed");
+
+inline int16_t
+to_snorm16(float value) noexcept
+{
+    return int16_t(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+inline float
+from_snorm16(int16_t value) noexcept
+{
+    return std::max(float(value) / 32767.f, -1.f);
+}
+
+// IEEE 754 binary16, rounding to nearest even
+inline uint16_t
+to_half(float value) noexcept
+{
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const auto sign     = uint32_t((bits >> 16) & 0x8000u);
+    const auto biased   = (bits >> 23) & 0xffu;
+    auto       mantissa = bits & 0x7fffffu;
+
+    if (biased == 0xffu) {
+        // keep NaNs NaN
+        return uint16_t(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+    }
+
+    const auto exponent = int32_t(biased) - 127 + 15;
+    if (exponent >= 0x1f) { return uint16_t(sign | 0x7c00u); }
+
+    const auto round = [](uint32_t kept, uint32_t dropped, uint32_t half) {
+        const bool up = dropped > half || (dropped == half && (kept & 1u));
+        return kept + uint32_t(up);
+    };
+
+    if (exponent <= 0) {
+        if (exponent < -10) { return uint16_t(sign); }
+
+        // subnormal: shift the implicit bit into the mantissa
+        mantissa |= 0x800000u;
+        const auto shift = uint32_t(14 - exponent);
+        return uint16_t(
+            sign | round(
+                       mantissa >> shift,
+                       mantissa & ((1u << shift) - 1u),
+                       1u << (shift - 1u)));
+    }
+
+    // a carry out of the mantissa correctly bumps the exponent
+    return uint16_t(
+        sign | round(
+                   (uint32_t(exponent) << 10) | (mantissa >> 13),
+                   mantissa & 0x1fffu,
+                   0x1000u));
+}
+
+inline float
+from_half(uint16_t value) noexcept
+{
+    const auto sign     = uint32_t(value & 0x8000u) << 16;
+    const auto exponent = uint32_t(value >> 10) & 0x1fu;
+    auto       mantissa = uint32_t(value) & 0x3ffu;
+
+    uint32_t bits = sign;
+    if (exponent == 0x1f) {
+        bits |= 0x7f800000u | mantissa << 13;
+    } else if (exponent != 0) {
+        bits |= (exponent + 112u) << 23 | mantissa << 13;
+    } else if (mantissa != 0) {
+        // subnormal: normalize into a float exponent
+        uint32_t biased = 113;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            --biased;
+        }
+        bits |= biased << 23 | (mantissa & 0x3ffu) << 13;
+    }
+
+    float result = 0.f;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// maps the unit sphere onto the [-1, 1] square by projecting onto the
+// octahedron and folding its lower half over the upper one; mirrored by
+// decode_octahedral() in shader.vert
+inline std::array<int16_t, 2>
+encode_octahedral(const std::array<float, 3>& normal) noexcept
+{
+    const auto sum =
+        std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (sum == 0.f) { return {0, 0}; }
+
+    auto x = normal[0] / sum;
+    auto y = normal[1] / sum;
+    if (normal[2] < 0.f) {
+        const auto folded_x = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+        const auto folded_y = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+        x                   = folded_x;
+        y                   = folded_y;
+    }
+
+    return {to_snorm16(x), to_snorm16(y)};
+}
+
+inline std::array<float, 3>
+decode_octahedral(const std::array<int16_t, 2>& encoded) noexcept
+{
+    auto       x = from_snorm16(encoded[0]);
+    auto       y = from_snorm16(encoded[1]);
+    const auto z = 1.f - std::fabs(x) - std::fabs(y);
+
+    const auto t = std::max(-z, 0.f);
+    x += x >= 0.f ? -t : t;
+    y += y >= 0.f ? -t : t;
+
+    const auto norm = std::sqrt(x * x + y * y + z * z);
+    return {x / norm, y / norm, z / norm};
+}
+
+inline vertex
+pack(
+    const std::array<float, 3>& position,
+    const std::array<float, 3>& normal,
+    const std::array<float, 2>& uv) noexcept
+{
+    vertex v;
+    v.position = {
+        to_snorm16(position[0]),
+        to_snorm16(position[1]),
+        to_snorm16(position[2]),
+        0};
+    v.normal = encode_octahedral(normal);
+    v.uv     = {to_half(uv[0]), to_half(uv[1])};
+    return v;
+}
+
+inline float
+length(const std::array<float, 3>& v) noexcept
+{
+    return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+inline std::array<float, 3>
+unpack_position(const vertex& v) noexcept
+{
+    return {
+        from_snorm16(v.position[0]),
+        from_snorm16(v.position[1]),
+        from_snorm16(v.position[2])};
+}
+
+// the radius the renderer culls and places meshes with, measured on the
+// quantized positions
+inline float
+bounding_radius(const std::vector<vertex>& vertices) noexcept
+{
+    float radius = 0.f;
+    for (const auto& v : vertices) {
+        radius = std::max(radius, length(unpack_position(v)));
+    }
+    return radius;
+}
+
+// splits the triangle list into meshlets greedily and in order, so the
+// index section stays a plain triangle list that draws as is; callers
+// wanting tighter meshlets reorder the triangles for locality first
+inline std::vector<meshlet>
+build_meshlets(
+    const std::vector<vertex>&   vertices,
+    const std::vector<uint32_t>& indices) noexcept
+{
+    std::vector<meshlet> meshlets;
+
+    // the meshlet that last referenced each vertex
+    std::vector<uint32_t> owner(vertices.size(), ~0u);
+
+    meshlet current;
+    const auto new_vertices = [&](size_t first) {
+        const auto index = uint32_t(meshlets.size());
+        return uint32_t(owner[indices[first]] != index) +
+               uint32_t(owner[indices[first + 1]] != index) +
+               uint32_t(owner[indices[first + 2]] != index);
+    };
+
+    for (size_t first = 0; first + 3 <= indices.size(); first += 3) {
+        if (current.triangle_count == MAX_MESHLET_TRIANGLES ||
+            current.vertex_count + new_vertices(first) >
+                MAX_MESHLET_VERTICES) {
+            meshlets.push_back(current);
+            current             = meshlet();
+            current.first_index = uint32_t(first);
+        }
+
+        const auto index = uint32_t(meshlets.size());
+        for (size_t corner = first; corner != first + 3; ++corner) {
+            if (owner[indices[corner]] != index) {
+                owner[indices[corner]] = index;
+                ++current.vertex_count;
+            }
+        }
+        ++current.triangle_count;
+    }
+
+    if (current.triangle_count != 0) { meshlets.push_back(current); }
+
+    for (auto& m : meshlets) {
+        std::array<float, 3> min = {1.f, 1.f, 1.f};
+        std::array<float, 3> max = {-1.f, -1.f, -1.f};
+
+        const auto end = m.first_index + 3 * m.triangle_count;
+        for (auto i = m.first_index; i != end; ++i) {
+            const auto p = unpack_position(vertices[indices[i]]);
+            for (size_t axis = 0; axis != 3; ++axis) {
+                min[axis] = std::min(min[axis], p[axis]);
+                max[axis] = std::max(max[axis], p[axis]);
+            }
+        }
+
+        for (size_t axis = 0; axis != 3; ++axis) {
+            m.center[axis] = (min[axis] + max[axis]) * .5f;
+        }
+        for (auto i = m.first_index; i != end; ++i) {
+            auto p = unpack_position(vertices[indices[i]]);
+            for (size_t axis = 0; axis != 3; ++axis) {
+                p[axis] -= m.center[axis];
+            }
+            m.radius = std::max(m.radius, length(p));
+        }
+    }
+
+    return meshlets;
+}
+
+constexpr uint64_t
+align_section(uint64_t offset) noexcept
+{
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT *
+           SECTION_ALIGNMENT;
+}
+
+inline bool
+write(
+    const std::string&           path,
+    const std::vector<vertex>&   vertices,
+    const std::vector<uint32_t>& indices,
+    const std::vector<meshlet>&  meshlets) noexcept
+{
+    header h;
+    h.vertex_count   = uint32_t(vertices.size());
+    h.index_count    = uint32_t(indices.size());
+    h.meshlet_count  = uint32_t(meshlets.size());
+    h.radius         = bounding_radius(vertices);
+    h.vertex_offset  = align_section(sizeof(header));
+    h.index_offset   = align_section(
+        h.vertex_offset + sizeof(vertex) * vertices.size());
+    h.meshlet_offset = align_section(
+        h.index_offset + sizeof(uint32_t) * indices.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) { return false; }
+
+    // pads up to `offset` before writing the section
+    const auto section = [&file](uint64_t offset, const auto& data) {
+        static constexpr std::array<char, SECTION_ALIGNMENT> zeros = {};
+        file.write(
+            zeros.data(), std::streamsize(offset - uint64_t(file.tellp())));
+        file.write(
+            reinterpret_cast<const char*>(data.data()),
+            std::streamsize(sizeof(data[0]) * data.size()));
+    };
+
+    section(0, std::array{h});
+    section(h.vertex_offset, vertices);
+    section(h.index_offset, indices);
+    section(h.meshlet_offset, meshlets);
+
+    return static_cast<bool>(file);
+}
+
+// the sections of a file in memory, pointing into it
+struct contents {
+    float           radius        = 0.f;
+    const vertex*   vertices      = nullptr;
+    uint32_t        vertex_count  = 0;
+    const uint32_t* indices       = nullptr;
+    uint32_t        index_count   = 0;
+    const meshlet*  meshlets      = nullptr;
+    uint32_t        meshlet_count = 0;
+};
+
+// checks the header and that every section lies within `size` bytes;
+// indices aren't range-checked, that would cost a pass over the largest
+// section
+inline std::optional<contents>
+parse(const std::byte* data, size_t size) noexcept
+{
+    header h;
+    if (data == nullptr || size < sizeof(h)) { return std::nullopt; }
+    std::memcpy(&h, data, sizeof(h));
+
+    if (h.magic != MAGIC || h.version != VERSION) { return std::nullopt; }
+
+    const auto fits = [size](uint64_t offset, uint64_t count, uint64_t stride) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= size &&
+               count <= (size - offset) / stride;
+    };
+    if (!fits(h.vertex_offset, h.vertex_count, sizeof(vertex)) ||
+        !fits(h.index_offset, h.index_count, sizeof(uint32_t)) ||
+        !fits(h.meshlet_offset, h.meshlet_count, sizeof(meshlet))) {
+        return std::nullopt;
+    }
+
+    contents c;
+    c.radius        = h.radius;
+    c.vertices      = reinterpret_cast<const vertex*>(data + h.vertex_offset);
+    c.vertex_count  = h.vertex_count;
+    c.indices       = reinterpret_cast<const uint32_t*>(data + h.index_offset);
+    c.index_count   = h.index_count;
+    c.meshlets      = reinterpret_cast<const meshlet*>(data + h.meshlet_offset);
+    c.meshlet_count = h.meshlet_count;
+    return c;
+}
+
+// a read-only view of a whole file; mmap()ed where available, read into
+// memory elsewhere
+class mapped_file {
+    const std::byte* _data = nullptr;
+    size_t           _size = 0;
+
+#ifndef MATERIALIST_MESH_FILE_MMAP
+    std::vector<std::byte> _buffer;
+#endif
+
+public:
+    mapped_file() noexcept = default;
+
+    mapped_file(const mapped_file&) = delete;
+
+    mapped_file(mapped_file&& other) noexcept
+        : _data(std::exchange(other._data, nullptr)),
+          _size(std::exchange(other._size, 0))
+#ifndef MATERIALIST_MESH_FILE_MMAP
+          ,
+          _buffer(std::move(other._buffer))
+#endif
+    {}
+
+    ~mapped_file() noexcept
+    {
+#ifdef MATERIALIST_MESH_FILE_MMAP
+        if (_data != nullptr) {
+            munmap(const_cast<std::byte*>(_data), _size);
+        }
+#endif
+    }
+
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    mapped_file&
+    operator=(mapped_file&& other) noexcept
+    {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+#ifndef MATERIALIST_MESH_FILE_MMAP
+        std::swap(_buffer, other._buffer);
+#endif
+        return *this;
+    }
+
+    // `populate` reads the whole file in right away, otherwise pages are
+    // read as they are first touched
+    static std::optional<mapped_file>
+    open(const std::string& path, bool populate = true) noexcept
+    {
+        mapped_file file;
+
+#ifdef MATERIALIST_MESH_FILE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) { return std::nullopt; }
+
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+            close(fd);
+            return std::nullopt;
+        }
+
+        file._size = size_t(status.st_size);
+        if (file._size != 0) {
+            // populating up front replaces a page fault per 4KiB during the
+            // copy with one bulk walk of the page cache
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if (populate) { flags |= MAP_POPULATE; }
+#endif
+            void* mapping =
+                mmap(nullptr, file._size, PROT_READ, flags, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                return std::nullopt;
+            }
+            file._data = static_cast<const std::byte*>(mapping);
+        }
+
+        close(fd);
+#else
+        static_cast<void>(populate);
+
+        std::ifstream stream(path, std::ios::ate | std::ios::binary);
+        if (!stream) { return std::nullopt; }
+
+        file._buffer.resize(size_t(stream.tellg()));
+        stream.seekg(0);
+        stream.read(
+            reinterpret_cast<char*>(file._buffer.data()),
+            std::streamsize(file._buffer.size()));
+        file._data = file._buffer.data();
+        file._size = file._buffer.size();
+#endif
+
+        return file;
+    }
+
+    const std::byte*
+    data() const noexcept
+    {
+        return _data;
+    }
+
+    size_t
+    size() const noexcept
+    {
+        return _size;
+    }
+};
+
+} // namespace mesh_file
+
+#endif // MATERIALIST_MESH_FILE_HPP
@@ -0,0 +1,147 @@
+#ifndef MATERIALIST_OBJ_HPP
+#define MATERIALIST_OBJ_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib> // std::strtof, std::strtol
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash.hpp"
+
+// Wavefront OBJ meshes: positions, uvs, normals and polygonal faces,
+// triangulated as fans; everything else in the file is ignored
+namespace obj {
+
+// a face corner: 0-based position, uv and normal indices, -1 for none
+struct corner {
+    int32_t position = -1;
+    int32_t uv       = -1;
+    int32_t normal   = -1;
+
+    bool
+    operator==(const corner& other) const noexcept
+    {
+        return position == other.position && uv == other.uv &&
+               normal == other.normal;
+    }
+};
+
+struct corner_hash {
+    size_t
+    operator()(const corner& c) const noexcept
+    {
+        return size_t(hash::fnv1a(&c, sizeof(c)));
+    }
+};
+
+struct mesh {
+    std::vector<std::array<float, 3>> positions;
+    std::vector<std::array<float, 2>> uvs;
+    std::vector<std::array<float, 3>> normals;
+
+    // three per triangle
+    std::vector<corner> corners;
+};
+
+namespace detail {
+
+// OBJ indices are 1-based, negative ones count back from the last element
+inline int32_t
+resolve_index(long index, size_t count) noexcept
+{
+    if (index < 0) { return int32_t(long(count) + index); }
+    return int32_t(index - 1);
+}
+
+template <size_t N>
+std::array<float, N>
+parse_floats(const char* text) noexcept
+{
+    std::array<float, N> values = {};
+    for (auto& value : values) {
+        char* end = nullptr;
+        value     = std::strtof(text, &end);
+        text      = end;
+    }
+    return values;
+}
+
+} // namespace detail
+
+// "p", "p/t", "p//n" or "p/t/n", resolved against what `m` read so far
+inline corner
+parse_corner(const char* text, const mesh& m) noexcept
+{
+    corner c;
+
+    char* end = nullptr;
+    c.position =
+        detail::resolve_index(std::strtol(text, &end, 10), m.positions.size());
+    if (*end != '/') { return c; }
+
+    // an empty uv leaves `end` on the slash in front of the normal
+    ++end;
+    if (*end != '/') {
+        c.uv = detail::resolve_index(std::strtol(end, &end, 10), m.uvs.size());
+    }
+    if (*end != '/') { return c; }
+
+    c.normal = detail::resolve_index(
+        std::strtol(end + 1, nullptr, 10), m.normals.size());
+    return c;
+}
+
+// nullopt if a face references a vertex the file doesn't have
+inline std::optional<mesh>
+parse(std::istream& in)
+{
+    mesh m;
+
+    std::vector<corner> polygon;
+    std::string         line;
+    while (std::getline(in, line)) {
+        const std::string_view view(line);
+        const char*            text = line.c_str();
+
+        if (view.substr(0, 2) == "v ") {
+            m.positions.push_back(detail::parse_floats<3>(text + 2));
+        } else if (view.substr(0, 3) == "vt ") {
+            const auto uv = detail::parse_floats<2>(text + 3);
+            // OBJ puts v = 0 at the bottom, Vulkan samples it at the top
+            m.uvs.push_back({uv[0], 1.f - uv[1]});
+        } else if (view.substr(0, 3) == "vn ") {
+            m.normals.push_back(detail::parse_floats<3>(text + 3));
+        } else if (view.substr(0, 2) == "f ") {
+            polygon.clear();
+            for (size_t i = 1; i < view.size(); ++i) {
+                if (view[i - 1] == ' ' && view[i] != ' ') {
+                    polygon.push_back(parse_corner(text + i, m));
+                }
+            }
+
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                m.corners.insert(
+                    end(m.corners), {polygon[0], polygon[i - 1], polygon[i]});
+            }
+        }
+    }
+
+    for (const auto& c : m.corners) {
+        if (c.position < 0 || size_t(c.position) >= m.positions.size() ||
+            (c.uv >= 0 && size_t(c.uv) >= m.uvs.size()) ||
+            (c.normal >= 0 && size_t(c.normal) >= m.normals.size())) {
+            return std::nullopt;
+        }
+    }
+
+    return m;
+}
+
+} // namespace obj
+
+#endif // MATERIALIST_OBJ_HPP
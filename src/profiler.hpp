@@ -0,0 +1,51 @@
+#ifndef MATERIALIST_PROFILER_HPP
+#define MATERIALIST_PROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <vulkan/vulkan.hpp>
+
+namespace profiler {
+
+struct gpu;
+
+struct summary;
+
+void initialize(
+    gpu&,
+    vk::Device,
+    size_t,
+    float,
+    uint32_t,
+    vk::Buffer,
+    const std::byte*) noexcept;
+
+void begin_frame(gpu&, vk::CommandBuffer, size_t) noexcept;
+
+uint32_t begin_zone(gpu&, vk::CommandBuffer, const char*) noexcept;
+
+void end_zone(gpu&, vk::CommandBuffer, uint32_t) noexcept;
+
+void record_counter(
+    gpu&,
+    vk::CommandBuffer,
+    const char*,
+    vk::Buffer,
+    vk::DeviceSize) noexcept;
+
+void end_frame(gpu&) noexcept;
+
+std::optional<double> last_ms(const gpu&, std::string_view) noexcept;
+
+std::optional<uint32_t> last_count(const gpu&, std::string_view) noexcept;
+
+std::optional<summary> summarize(const gpu&, std::string_view) noexcept;
+
+void log_summary(const gpu&) noexcept;
+
+} // namespace profiler
+
+#endif // MATERIALIST_PROFILER_HPP
@@ -0,0 +1,325 @@
+namespace profiler {
+
+struct summary {
+    double min_ms;
+    double average_ms;
+    double p99_ms;
+    size_t samples;
+};
+
+// a named interval measured by a pair of timestamps
+struct zone {
+    const char* name;
+    uint32_t    first_query;
+};
+
+// one query pool per frame in flight; a frame's results are read back the
+// next time its slot comes around, after its fence was waited, so reading
+// them never stalls. Counters are copied to the frame's slots of the counter
+// buffer and read back the same way
+struct frame_queries {
+    vk::UniqueQueryPool      pool;
+    std::vector<zone>        zones;
+    std::vector<const char*> counters;
+};
+
+struct gpu {
+    vk::Device device;
+    bool       enabled = false;
+
+    // nanoseconds per timestamp tick and the bits the queue actually writes
+    double   timestamp_period = 1.0;
+    uint64_t timestamp_mask   = ~uint64_t(0);
+
+    uint32_t                   max_zones = 64;
+    std::vector<frame_queries> frames;
+    frame_queries*             current       = nullptr;
+    size_t                     current_index = 0;
+
+    // host-visible, `max_counters` uint32_t slots per frame in flight
+    uint32_t         max_counters = 16;
+    vk::Buffer       counter_buffer;
+    const std::byte* counter_mapped = nullptr;
+
+    std::map<std::string, sample_window, std::less<>> history;
+    std::map<std::string, double, std::less<>>        last;
+    std::map<std::string, sample_window, std::less<>> counter_history;
+    std::map<std::string, uint32_t, std::less<>>      last_counts;
+
+    std::chrono::seconds                  summary_interval{5};
+    std::chrono::steady_clock::time_point last_summary;
+
+    std::vector<uint64_t> results;
+};
+
+namespace /* anonymous */ {
+
+void
+read_back_counters(gpu& g, size_t frame_index) noexcept
+{
+    auto& frame = g.frames[frame_index];
+
+    for (size_t i = 0; i != frame.counters.size(); ++i) {
+        uint32_t value;
+        std::memcpy(
+            &value,
+            g.counter_mapped +
+                (frame_index * g.max_counters + i) * sizeof(uint32_t),
+            sizeof(value));
+
+        auto it = g.counter_history.find(frame.counters[i]);
+        if (it == end(g.counter_history)) {
+            it = g.counter_history.emplace(frame.counters[i], sample_window())
+                     .first;
+        }
+        it->second.add(value);
+        g.last_counts[frame.counters[i]] = value;
+    }
+
+    frame.counters.clear();
+}
+
+// counters are recorded inside the frame's zones, so a frame without zones
+// has no counters either
+void
+read_back(gpu& g, size_t frame_index) noexcept
+{
+    auto& frame = g.frames[frame_index];
+    if (frame.zones.empty()) { return; }
+
+    const auto query_count = gsl::narrow<uint32_t>(frame.zones.size() * 2);
+    g.results.resize(query_count);
+
+    const auto result = g.device.getQueryPoolResults(
+        *frame.pool,
+        0,
+        query_count,
+        g.results.size() * sizeof(uint64_t),
+        g.results.data(),
+        sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64);
+
+    // the frame was never submitted (e.g. the swapchain went out of date)
+    if (result != vk::Result::eSuccess) {
+        frame.zones.clear();
+        frame.counters.clear();
+        return;
+    }
+
+    for (const auto& z : frame.zones) {
+        const auto begin_ticks = g.results[z.first_query] & g.timestamp_mask;
+        const auto end_ticks = g.results[z.first_query + 1] & g.timestamp_mask;
+        const auto ticks     = (end_ticks - begin_ticks) & g.timestamp_mask;
+        const auto ms =
+            static_cast<double>(ticks) * g.timestamp_period / 1'000'000.0;
+
+        auto it = g.history.find(z.name);
+        if (it == end(g.history)) {
+            it = g.history.emplace(z.name, sample_window()).first;
+        }
+        it->second.add(ms);
+        g.last[z.name] = ms;
+    }
+
+    frame.zones.clear();
+
+    read_back_counters(g, frame_index);
+}
+
+} // namespace
+
+// `valid_bits` is the graphics family's timestampValidBits; 0 disables the
+// profiler, since the queue can't write timestamps. `counter_buffer` is
+// host-visible and coherent, mapped at `counter_mapped`, with room for
+// frames_in_flight * max_counters uint32_t
+void
+initialize(
+    gpu&             g,
+    vk::Device       device,
+    size_t           frames_in_flight,
+    float            timestamp_period,
+    uint32_t         valid_bits,
+    vk::Buffer       counter_buffer,
+    const std::byte* counter_mapped) noexcept
+{
+    g.device         = device;
+    g.enabled        = valid_bits != 0;
+    g.counter_buffer = counter_buffer;
+    g.counter_mapped = counter_mapped;
+    if (!g.enabled) {
+        spdlog::info("gpu profiler disabled: queue has no timestamp support");
+        return;
+    }
+
+    g.timestamp_period = static_cast<double>(timestamp_period);
+    g.timestamp_mask =
+        valid_bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << valid_bits) - 1;
+
+    g.frames.resize(frames_in_flight);
+    for (auto& frame : g.frames) {
+        vk::QueryPoolCreateInfo qpci(
+            {}, vk::QueryType::eTimestamp, g.max_zones * 2);
+
+        auto [result, pool] = device.createQueryPoolUnique(qpci);
+        if (result != vk::Result::eSuccess) {
+            ERROR("failed to create timestamp query pool");
+        }
+        frame.pool = std::move(pool);
+    }
+
+    g.last_summary = std::chrono::steady_clock::now();
+}
+
+// collects the results left in this frame slot and starts recording new
+// ones; the slot's previous submission must have completed
+void
+begin_frame(gpu& g, vk::CommandBuffer command_buffer, size_t frame) noexcept
+{
+    if (!g.enabled) { return; }
+
+    g.current       = &g.frames[frame];
+    g.current_index = frame;
+    read_back(g, frame);
+
+    command_buffer.resetQueryPool(*g.current->pool, 0, g.max_zones * 2);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - g.last_summary >= g.summary_interval) {
+        log_summary(g);
+        g.last_summary = now;
+    }
+}
+
+// zones must be opened and closed outside of render passes or around whole
+// ones, in the primary command buffer
+uint32_t
+begin_zone(
+    gpu& g, vk::CommandBuffer command_buffer, const char* name) noexcept
+{
+    if (!g.enabled || g.current->zones.size() == g.max_zones) {
+        return std::numeric_limits<uint32_t>::max();
+    }
+
+    const auto index = gsl::narrow<uint32_t>(g.current->zones.size());
+    g.current->zones.push_back({name, index * 2});
+
+    command_buffer.writeTimestamp(
+        vk::PipelineStageFlagBits::eTopOfPipe, *g.current->pool, index * 2);
+
+    return index;
+}
+
+void
+end_zone(gpu& g, vk::CommandBuffer command_buffer, uint32_t index) noexcept
+{
+    if (index == std::numeric_limits<uint32_t>::max()) { return; }
+
+    command_buffer.writeTimestamp(
+        vk::PipelineStageFlagBits::eBottomOfPipe,
+        *g.current->pool,
+        index * 2 + 1);
+}
+
+// copies the uint32_t at `offset` of `source` into the frame's counter
+// slots; the value is read back with the frame's zones. The write to
+// `source` must be visible to transfers
+void
+record_counter(
+    gpu&              g,
+    vk::CommandBuffer command_buffer,
+    const char*       name,
+    vk::Buffer        source,
+    vk::DeviceSize    offset) noexcept
+{
+    if (!g.enabled || g.current->counters.size() == g.max_counters) {
+        return;
+    }
+
+    const auto slot = g.current_index * g.max_counters +
+                      g.current->counters.size();
+    g.current->counters.push_back(name);
+
+    command_buffer.copyBuffer(
+        source,
+        g.counter_buffer,
+        vk::BufferCopy(offset, slot * sizeof(uint32_t), sizeof(uint32_t)));
+
+    vk::MemoryBarrier barrier(
+        vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+    command_buffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eHost,
+        {},
+        barrier,
+        nullptr,
+        nullptr);
+}
+
+void
+end_frame(gpu& g) noexcept
+{
+    g.current = nullptr;
+}
+
+// most recent measurement of `name`, `frames_in_flight` frames old
+std::optional<double>
+last_ms(const gpu& g, std::string_view name) noexcept
+{
+    auto it = g.last.find(name);
+    if (it == end(g.last)) { return std::nullopt; }
+
+    return it->second;
+}
+
+std::optional<summary>
+summarize(const gpu& g, std::string_view name) noexcept
+{
+    auto it = g.history.find(name);
+    if (it == end(g.history) || it->second.empty()) { return std::nullopt; }
+
+    const auto& window = it->second;
+    return summary{window.min(),
+                   window.average(),
+                   window.percentile(99),
+                   window.size()};
+}
+
+// most recent value of counter `name`, `frames_in_flight` frames old
+std::optional<uint32_t>
+last_count(const gpu& g, std::string_view name) noexcept
+{
+    auto it = g.last_counts.find(name);
+    if (it == end(g.last_counts)) { return std::nullopt; }
+
+    return it->second;
+}
+
+void
+log_summary(const gpu& g) noexcept
+{
+    for (const auto& [name, window] : g.history) {
+        if (window.empty()) { continue; }
+
+        spdlog::info(
+            "gpu {}: min {:.3f}ms avg {:.3f}ms p99 {:.3f}ms ({} frames)",
+            name,
+            window.min(),
+            window.average(),
+            window.percentile(99),
+            window.size());
+    }
+
+    for (const auto& [name, window] : g.counter_history) {
+        if (window.empty()) { continue; }
+
+        spdlog::info(
+            "gpu {}: min {:.0f} avg {:.1f} max {:.0f} ({} frames)",
+            name,
+            window.min(),
+            window.average(),
+            window.max(),
+            window.size());
+    }
+}
+
+} // namespace profiler
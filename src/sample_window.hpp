@@ -0,0 +1,98 @@
+#ifndef MATERIALIST_SAMPLE_WINDOW_HPP
+#define MATERIALIST_SAMPLE_WINDOW_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+// keeps the most recent `capacity` samples of a measurement and summarizes
+// them; used for frame and pass timings
+class sample_window {
+    std::vector<double> _samples;
+    size_t              _capacity;
+    size_t              _next = 0;
+
+public:
+    explicit sample_window(size_t capacity = 512) : _capacity(capacity)
+    {
+        assert(capacity != 0);
+        _samples.reserve(capacity);
+    }
+
+    void
+    add(double sample)
+    {
+        if (_samples.size() != _capacity) {
+            _samples.push_back(sample);
+        } else {
+            _samples[_next] = sample;
+        }
+        _next = (_next + 1) % _capacity;
+    }
+
+    void
+    clear() noexcept
+    {
+        _samples.clear();
+        _next = 0;
+    }
+
+    size_t
+    size() const noexcept
+    {
+        return _samples.size();
+    }
+
+    bool
+    empty() const noexcept
+    {
+        return _samples.empty();
+    }
+
+    double
+    min() const noexcept
+    {
+        if (empty()) { return 0.0; }
+
+        return *std::min_element(begin(_samples), end(_samples));
+    }
+
+    double
+    max() const noexcept
+    {
+        if (empty()) { return 0.0; }
+
+        return *std::max_element(begin(_samples), end(_samples));
+    }
+
+    double
+    average() const noexcept
+    {
+        if (empty()) { return 0.0; }
+
+        return std::accumulate(begin(_samples), end(_samples), 0.0) /
+               static_cast<double>(_samples.size());
+    }
+
+    // nearest-rank percentile, `p` in [0, 100]
+    double
+    percentile(double p) const
+    {
+        if (empty()) { return 0.0; }
+
+        auto sorted = _samples;
+        const auto rank = static_cast<size_t>(
+            std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+        const auto nth = begin(sorted) +
+                         static_cast<std::ptrdiff_t>(
+                             std::clamp<size_t>(rank, 1, sorted.size()) - 1);
+        std::nth_element(begin(sorted), nth, end(sorted));
+
+        return *nth;
+    }
+};
+
+#endif // MATERIALIST_SAMPLE_WINDOW_HPP
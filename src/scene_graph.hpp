@@ -0,0 +1,479 @@
+#ifndef MATERIALIST_SCENE_GRAPH_HPP
+#define MATERIALIST_SCENE_GRAPH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define MATERIALIST_SCENE_GRAPH_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MATERIALIST_SCENE_GRAPH_SSE2 1
+#endif
+
+namespace scene {
+
+constexpr uint32_t NO_PARENT = ~0u;
+
+// row-major 3x4 affine transform: the linear part in the first three
+// columns, the translation in the last
+using affine = std::array<float, 12>;
+
+constexpr affine IDENTITY = {1.f, 0.f, 0.f, 0.f, //
+                             0.f, 1.f, 0.f, 0.f, //
+                             0.f, 0.f, 1.f, 0.f};
+
+struct aabb {
+    std::array<float, 3> min = {0.f, 0.f, 0.f};
+    std::array<float, 3> max = {0.f, 0.f, 0.f};
+};
+
+namespace simd {
+
+// one node per lane; the fallback for nodes whose parent is updated in the
+// same batch, and for targets without SIMD
+struct scalar {
+    static constexpr size_t WIDTH = 1;
+
+    using floats  = float;
+    using indices = uint32_t;
+
+    static floats
+    load(const float* p) noexcept
+    {
+        return *p;
+    }
+
+    static void
+    store(float* p, floats a) noexcept
+    {
+        *p = a;
+    }
+
+    static indices
+    load_indices(const uint32_t* p) noexcept
+    {
+        return *p;
+    }
+
+    static floats
+    gather(const float* base, indices i) noexcept
+    {
+        return base[i];
+    }
+
+    static floats
+    fma(floats a, floats b, floats c) noexcept
+    {
+        return a * b + c;
+    }
+
+    static floats
+    abs(floats a) noexcept
+    {
+        return std::fabs(a);
+    }
+};
+
+#if defined(MATERIALIST_SCENE_GRAPH_AVX2)
+
+struct wide {
+    static constexpr size_t WIDTH = 8;
+
+    struct floats {
+        __m256 v;
+    };
+
+    using indices = __m256i;
+
+    static floats
+    load(const float* p) noexcept
+    {
+        return {_mm256_loadu_ps(p)};
+    }
+
+    static void
+    store(float* p, floats a) noexcept
+    {
+        _mm256_storeu_ps(p, a.v);
+    }
+
+    static indices
+    load_indices(const uint32_t* p) noexcept
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+
+    static floats
+    gather(const float* base, indices i) noexcept
+    {
+        return {_mm256_i32gather_ps(base, i, sizeof(float))};
+    }
+
+    static floats
+    fma(floats a, floats b, floats c) noexcept
+    {
+        return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+    }
+
+    static floats
+    abs(floats a) noexcept
+    {
+        return {_mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v)};
+    }
+};
+
+inline wide::floats
+operator+(wide::floats a, wide::floats b) noexcept
+{
+    return {_mm256_add_ps(a.v, b.v)};
+}
+
+inline wide::floats
+operator-(wide::floats a, wide::floats b) noexcept
+{
+    return {_mm256_sub_ps(a.v, b.v)};
+}
+
+inline wide::floats
+operator*(wide::floats a, wide::floats b) noexcept
+{
+    return {_mm256_mul_ps(a.v, b.v)};
+}
+
+#elif defined(MATERIALIST_SCENE_GRAPH_SSE2)
+
+struct wide {
+    static constexpr size_t WIDTH = 4;
+
+    struct floats {
+        __m128 v;
+    };
+
+    // no gather instruction, lanes are loaded one by one
+    using indices = const uint32_t*;
+
+    static floats
+    load(const float* p) noexcept
+    {
+        return {_mm_loadu_ps(p)};
+    }
+
+    static void
+    store(float* p, floats a) noexcept
+    {
+        _mm_storeu_ps(p, a.v);
+    }
+
+    static indices
+    load_indices(const uint32_t* p) noexcept
+    {
+        return p;
+    }
+
+    static floats
+    gather(const float* base, indices i) noexcept
+    {
+        return {_mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]])};
+    }
+
+    static floats
+    fma(floats a, floats b, floats c) noexcept
+    {
+        return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)};
+    }
+
+    static floats
+    abs(floats a) noexcept
+    {
+        return {_mm_andnot_ps(_mm_set1_ps(-0.f), a.v)};
+    }
+};
+
+inline wide::floats
+operator+(wide::floats a, wide::floats b) noexcept
+{
+    return {_mm_add_ps(a.v, b.v)};
+}
+
+inline wide::floats
+operator-(wide::floats a, wide::floats b) noexcept
+{
+    return {_mm_sub_ps(a.v, b.v)};
+}
+
+inline wide::floats
+operator*(wide::floats a, wide::floats b) noexcept
+{
+    return {_mm_mul_ps(a.v, b.v)};
+}
+
+#else
+
+using wide = scalar;
+
+#endif
+
+} // namespace simd
+
+// transform hierarchy in structure-of-arrays layout, one array per matrix
+// element, so that world transforms and bounds of consecutive nodes are
+// computed a SIMD batch at a time
+//
+// nodes are stored in depth-first pre-order: parents come before their
+// children and every subtree is the contiguous range from its root to
+// subtree_end(). Changing a local transform marks its subtree dirty, and
+// update() recomputes the dirty subtrees only
+class hierarchy {
+    // storage slot 0 is an implicit identity root, the parent of every
+    // top-level node, so node n lives in slot n + 1 and every slot has a
+    // parent slot to gather from
+    std::vector<uint32_t>              _parents;
+    std::vector<uint32_t>              _subtree_ends;
+    std::array<std::vector<float>, 12> _local;
+    std::array<std::vector<float>, 12> _world;
+
+    // local bounds as center and half extent, world bounds as min and max
+    std::array<std::vector<float>, 3> _centers;
+    std::array<std::vector<float>, 3> _extents;
+    std::array<std::vector<float>, 3> _world_min;
+    std::array<std::vector<float>, 3> _world_max;
+
+    // nodes whose local transform changed since the last update()
+    std::vector<uint32_t> _dirty;
+    size_t                _updated = 0;
+
+    void
+    push(uint32_t parent_slot, const affine& local, const aabb& bounds)
+    {
+        _parents.push_back(parent_slot);
+        _subtree_ends.push_back(uint32_t(_parents.size()));
+        for (size_t k = 0; k != 12; ++k) {
+            _local[k].push_back(local[k]);
+            _world[k].push_back(local[k]);
+        }
+        for (size_t k = 0; k != 3; ++k) {
+            _centers[k].push_back((bounds.min[k] + bounds.max[k]) * .5f);
+            _extents[k].push_back((bounds.max[k] - bounds.min[k]) * .5f);
+            _world_min[k].push_back(bounds.min[k]);
+            _world_max[k].push_back(bounds.max[k]);
+        }
+    }
+
+    // world = parent world * local, and the local bounds moved to world
+    // space, for the Ops::WIDTH slots from `slot` on
+    template <typename Ops>
+    void
+    compute(size_t slot) noexcept
+    {
+        using floats = typename Ops::floats;
+
+        const auto parents = Ops::load_indices(&_parents[slot]);
+
+        std::array<floats, 12> p;
+        std::array<floats, 12> l;
+        for (size_t k = 0; k != 12; ++k) {
+            p[k] = Ops::gather(_world[k].data(), parents);
+            l[k] = Ops::load(&_local[k][slot]);
+        }
+
+        std::array<floats, 12> w;
+        for (size_t r = 0; r != 3; ++r) {
+            for (size_t c = 0; c != 4; ++c) {
+                auto v = p[r * 4] * l[c];
+                v      = Ops::fma(p[r * 4 + 1], l[4 + c], v);
+                v      = Ops::fma(p[r * 4 + 2], l[8 + c], v);
+                if (c == 3) { v = v + p[r * 4 + 3]; }
+
+                w[r * 4 + c] = v;
+                Ops::store(&_world[r * 4 + c][slot], v);
+            }
+        }
+
+        const std::array<floats, 3> center = {Ops::load(&_centers[0][slot]),
+                                              Ops::load(&_centers[1][slot]),
+                                              Ops::load(&_centers[2][slot])};
+        const std::array<floats, 3> extent = {Ops::load(&_extents[0][slot]),
+                                              Ops::load(&_extents[1][slot]),
+                                              Ops::load(&_extents[2][slot])};
+
+        for (size_t r = 0; r != 3; ++r) {
+            auto c = Ops::fma(w[r * 4], center[0], w[r * 4 + 3]);
+            c      = Ops::fma(w[r * 4 + 1], center[1], c);
+            c      = Ops::fma(w[r * 4 + 2], center[2], c);
+
+            auto e = Ops::abs(w[r * 4]) * extent[0];
+            e      = Ops::fma(Ops::abs(w[r * 4 + 1]), extent[1], e);
+            e      = Ops::fma(Ops::abs(w[r * 4 + 2]), extent[2], e);
+
+            Ops::store(&_world_min[r][slot], c - e);
+            Ops::store(&_world_max[r][slot], c + e);
+        }
+    }
+
+    // a batch can be computed at once when none of its parents is part of
+    // it, which in pre-order means they all precede it
+    bool
+    is_independent(size_t slot, size_t width) const noexcept
+    {
+        uint32_t max_parent = 0;
+        for (size_t i = slot; i != slot + width; ++i) {
+            max_parent = std::max(max_parent, _parents[i]);
+        }
+        return max_parent < slot;
+    }
+
+    void
+    update_slots(size_t begin, size_t end) noexcept
+    {
+        constexpr auto WIDTH = simd::wide::WIDTH;
+
+        auto slot = begin;
+        while (slot != end) {
+            if (end - slot >= WIDTH && is_independent(slot, WIDTH)) {
+                compute<simd::wide>(slot);
+                slot += WIDTH;
+            } else {
+                compute<simd::scalar>(slot);
+                ++slot;
+            }
+        }
+        _updated += end - begin;
+    }
+
+public:
+    hierarchy()
+    {
+        push(0, IDENTITY, aabb());
+    }
+
+    size_t
+    size() const noexcept
+    {
+        return _parents.size() - 1;
+    }
+
+    void
+    reserve(size_t count)
+    {
+        _parents.reserve(count + 1);
+        _subtree_ends.reserve(count + 1);
+        for (auto* arrays : {&_local, &_world}) {
+            for (auto& a : *arrays) { a.reserve(count + 1); }
+        }
+        for (auto* arrays :
+             {&_centers, &_extents, &_world_min, &_world_max}) {
+            for (auto& a : *arrays) { a.reserve(count + 1); }
+        }
+    }
+
+    // appends a node with local `bounds`; to keep the pre-order, `parent`
+    // must be NO_PARENT or a node whose subtree ends at the new node, i.e.
+    // the last node or one of its ancestors
+    uint32_t
+    add(uint32_t parent, const affine& local, const aabb& bounds)
+    {
+        const auto node        = uint32_t(size());
+        const auto parent_slot = parent == NO_PARENT ? 0 : parent + 1;
+        assert(_subtree_ends[parent_slot] == node + 1);
+
+        push(parent_slot, local, bounds);
+        for (auto s = parent_slot; s != 0; s = _parents[s]) {
+            ++_subtree_ends[s];
+        }
+        ++_subtree_ends[0];
+
+        _dirty.push_back(node);
+        return node;
+    }
+
+    uint32_t
+    parent(uint32_t node) const noexcept
+    {
+        const auto slot = _parents[node + 1];
+        return slot == 0 ? NO_PARENT : slot - 1;
+    }
+
+    // one past the last node of the subtree rooted at `node`
+    uint32_t
+    subtree_end(uint32_t node) const noexcept
+    {
+        return _subtree_ends[node + 1] - 1;
+    }
+
+    affine
+    local(uint32_t node) const noexcept
+    {
+        affine m;
+        for (size_t k = 0; k != 12; ++k) { m[k] = _local[k][node + 1]; }
+        return m;
+    }
+
+    void
+    set_local(uint32_t node, const affine& m) noexcept
+    {
+        for (size_t k = 0; k != 12; ++k) { _local[k][node + 1] = m[k]; }
+        _dirty.push_back(node);
+    }
+
+    // as of the last update()
+    affine
+    world(uint32_t node) const noexcept
+    {
+        affine m;
+        for (size_t k = 0; k != 12; ++k) { m[k] = _world[k][node + 1]; }
+        return m;
+    }
+
+    // the local bounds transformed by world(), as of the last update()
+    aabb
+    world_bounds(uint32_t node) const noexcept
+    {
+        aabb b;
+        for (size_t k = 0; k != 3; ++k) {
+            b.min[k] = _world_min[k][node + 1];
+            b.max[k] = _world_max[k][node + 1];
+        }
+        return b;
+    }
+
+    // recomputes world transforms and bounds of every subtree with a
+    // changed local transform; unchanged subtrees aren't touched
+    void
+    update() noexcept
+    {
+        _updated = 0;
+
+        // sorted, a dirty node inside an already updated subtree comes
+        // right after its root and is skipped
+        std::sort(begin(_dirty), end(_dirty));
+
+        size_t covered = 0;
+        for (auto node : _dirty) {
+            const auto slot = size_t(node) + 1;
+            if (slot < covered) { continue; }
+
+            covered = _subtree_ends[slot];
+            update_slots(slot, covered);
+        }
+
+        _dirty.clear();
+    }
+
+    // nodes recomputed by the last update()
+    size_t
+    updated_count() const noexcept
+    {
+        return _updated;
+    }
+};
+
+} // namespace scene
+
+#endif // MATERIALIST_SCENE_GRAPH_HPP
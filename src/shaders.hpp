@@ -0,0 +1,34 @@
+#ifndef MATERIALIST_SHADERS_HPP
+#define MATERIALIST_SHADERS_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <gsl/gsl>
+#include <vulkan/vulkan.hpp>
+
+namespace shaders {
+
+struct cache;
+
+// SPIR-V generated into the binary by the compile_shaders target, looked up
+// by source file name (e.g. "shader.vert"); empty if there is no such shader
+gsl::span<const uint32_t> embedded(std::string_view) noexcept;
+
+vk::UniqueShaderModule
+create_module(vk::Device, gsl::span<const uint32_t>) noexcept;
+
+gsl::span<const uint32_t> code(const cache&, std::string_view) noexcept;
+
+void replace(cache&, std::string_view, std::vector<uint32_t>) noexcept;
+
+vk::ShaderModule load(cache&, vk::Device, std::string_view) noexcept;
+
+vk::ShaderModule get(cache&, vk::Device, gsl::span<const uint32_t>) noexcept;
+
+void log_statistics(const cache&) noexcept;
+
+} // namespace shaders
+
+#endif // MATERIALIST_SHADERS_HPP
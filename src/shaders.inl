@@ -0,0 +1,114 @@
+namespace shaders {
+
+// a module and a copy of the code it was created from, compared on a hash
+// hit; a copy, as replace() drops the code the module may have come from
+struct module_entry {
+    std::vector<uint32_t>  code;
+    vk::UniqueShaderModule module;
+};
+
+// shader modules keyed by a hash of their code, so rebuilding a pipeline
+// reuses the modules of the previous one; modules live as long as the cache.
+// Code colliding in its hash chains under it
+struct cache {
+    std::unordered_multimap<uint64_t, module_entry> modules;
+
+    // code replacing the embedded one, e.g. recompiled by hot_reload
+    std::map<std::string, std::vector<uint32_t>, std::less<>> replaced;
+
+    size_t hits   = 0;
+    size_t misses = 0;
+};
+
+vk::UniqueShaderModule
+create_module(vk::Device device, gsl::span<const uint32_t> spirv) noexcept
+{
+    TRACE_ZONE("create shader module");
+
+    vk::ShaderModuleCreateInfo smci({}, spirv.size_bytes(), spirv.data());
+
+    auto [result, shader_module] = device.createShaderModuleUnique(smci);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create shader module");
+    }
+
+    return std::move(shader_module);
+}
+
+namespace /* anonymous */ {
+
+bool
+same_code(const module_entry& e, gsl::span<const uint32_t> spirv) noexcept
+{
+    return std::equal(begin(e.code), end(e.code), spirv.begin(), spirv.end());
+}
+
+// the module created from exactly `spirv`, end(c.modules) if there is none
+auto
+find_module(cache& c, gsl::span<const uint32_t> spirv) noexcept
+{
+    const auto [first, last] =
+        c.modules.equal_range(hash::fnv1a(spirv.data(), spirv.size_bytes()));
+    const auto it = std::find_if(first, last, [spirv](const auto& entry) {
+        return same_code(entry.second, spirv);
+    });
+    return it != last ? it : end(c.modules);
+}
+
+} // namespace
+
+// the current code of shader `name`: the embedded one unless replace()d
+gsl::span<const uint32_t>
+code(const cache& c, std::string_view name) noexcept
+{
+    auto it = c.replaced.find(name);
+    if (it != end(c.replaced)) { return it->second; }
+
+    const auto spirv = embedded(name);
+    if (spirv.empty()) { ERROR("shader {} is not embedded", name); }
+
+    return spirv;
+}
+
+// pipelines created from now on use `spirv` for shader `name`; the module of
+// the code it replaces is dropped, existing pipelines don't need it
+void
+replace(cache& c, std::string_view name, std::vector<uint32_t> spirv) noexcept
+{
+    const auto previous = find_module(c, code(c, name));
+    if (previous != end(c.modules)) { c.modules.erase(previous); }
+
+    c.replaced.insert_or_assign(std::string(name), std::move(spirv));
+}
+
+vk::ShaderModule
+load(cache& c, vk::Device device, std::string_view name) noexcept
+{
+    return get(c, device, code(c, name));
+}
+
+vk::ShaderModule
+get(cache& c, vk::Device device, gsl::span<const uint32_t> spirv) noexcept
+{
+    auto it = find_module(c, spirv);
+    if (it != end(c.modules)) {
+        ++c.hits;
+        return *it->second.module;
+    }
+
+    ++c.misses;
+    module_entry entry;
+    entry.code.assign(spirv.begin(), spirv.end());
+    entry.module = create_module(device, spirv);
+
+    const auto key = hash::fnv1a(spirv.data(), spirv.size_bytes());
+    return *c.modules.emplace(key, std::move(entry))->second.module;
+}
+
+void
+log_statistics(const cache& c) noexcept
+{
+    spdlog::debug("shader modules: {} created, {} reused", c.misses, c.hits);
+}
+
+} // namespace shaders
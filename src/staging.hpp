@@ -0,0 +1,55 @@
+#ifndef MATERIALIST_STAGING_HPP
+#define MATERIALIST_STAGING_HPP
+
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+namespace staging {
+
+struct ring;
+
+struct statistics;
+
+void initialize(
+    ring&,
+    vk::Device,
+    vk::Queue,
+    uint32_t,
+    uint32_t,
+    vk::Buffer,
+    std::byte*,
+    vk::DeviceSize) noexcept;
+
+void upload(
+    ring&,
+    vk::Buffer,
+    vk::DeviceSize,
+    const void*,
+    vk::DeviceSize) noexcept;
+
+void upload_image(
+    ring&,
+    vk::Image,
+    uint32_t,
+    vk::Extent2D,
+    uint32_t,
+    const void*,
+    vk::DeviceSize) noexcept;
+
+void flush(ring&) noexcept;
+
+void retire(ring&) noexcept;
+
+std::vector<vk::Semaphore>
+acquire(ring&, vk::CommandBuffer, vk::Semaphore, uint64_t) noexcept;
+
+vk::PipelineStageFlags consumer_stages() noexcept;
+
+void wait_idle(ring&) noexcept;
+
+void log_statistics(const ring&) noexcept;
+
+} // namespace staging
+
+#endif // MATERIALIST_STAGING_HPP
@@ -0,0 +1,613 @@
+namespace staging {
+
+// one submission worth of copies; `end` is the ring position up to which the
+// submission reads, so the ring tail can move there once the fence signals
+struct batch {
+    vk::UniqueCommandBuffer command_buffer;
+    vk::UniqueFence         fence;
+    vk::UniqueSemaphore     semaphore;
+    vk::DeviceSize          end = 0;
+
+    // timeline value signaled by the submission that waits on `semaphore`;
+    // the batch can't be reused (and the semaphore signaled again) before
+    // that submission completes. 0 while no submission took it yet
+    bool     awaiting_consumer = false;
+    uint64_t consumer_value    = 0;
+};
+
+struct statistics {
+    uint64_t                 bytes       = 0;
+    uint64_t                 copies      = 0;
+    uint64_t                 submissions = 0;
+    uint64_t                 handoffs    = 0;
+    uint64_t                 stalls      = 0;
+    std::chrono::nanoseconds stall_time  = std::chrono::nanoseconds::zero();
+};
+
+struct pending_copy {
+    vk::Buffer     destination;
+    vk::BufferCopy region;
+};
+
+// a band of rows of one mip level; the level goes to the transfer layout
+// before its first band and to the shader read-only layout after its last
+struct pending_image_copy {
+    vk::Image           destination;
+    vk::BufferImageCopy region;
+    bool                first;
+    bool                last;
+};
+
+// persistently mapped host-visible ring; head and tail grow monotonically and
+// are taken modulo capacity when addressing the buffer
+//
+// copies run on `queue`; when it belongs to another family than the one
+// using the data (`owner_family`), every flush releases the written ranges
+// and signals a semaphore, and acquire() records the matching acquire side
+struct ring {
+    vk::Device     device;
+    vk::Queue      queue;
+    uint32_t       queue_family = 0;
+    uint32_t       owner_family = 0;
+    vk::Buffer     buffer;
+    std::byte*     mapped   = nullptr;
+    vk::DeviceSize capacity = 0;
+    vk::DeviceSize head     = 0;
+    vk::DeviceSize tail     = 0;
+
+    vk::UniqueCommandPool           command_pool;
+    std::deque<batch>               inflight;
+    std::vector<batch>              consuming;
+    std::vector<batch>              idle;
+    std::vector<pending_copy>       copies;
+    std::vector<pending_image_copy> image_copies;
+
+    std::vector<vk::BufferMemoryBarrier> acquires;
+    std::vector<vk::ImageMemoryBarrier>  image_acquires;
+    std::vector<vk::Semaphore>           waits;
+    vk::Semaphore                        consumer_timeline;
+
+    statistics stats;
+};
+
+namespace /* anonymous */ {
+
+// where the owner family may first read uploaded data
+constexpr auto g_consumer_stages = vk::PipelineStageFlagBits::eVertexInput |
+                                   vk::PipelineStageFlagBits::eVertexShader |
+                                   vk::PipelineStageFlagBits::eFragmentShader |
+                                   vk::PipelineStageFlagBits::eComputeShader;
+
+constexpr auto g_consumer_access = vk::AccessFlagBits::eVertexAttributeRead |
+                                   vk::AccessFlagBits::eIndexRead |
+                                   vk::AccessFlagBits::eShaderRead;
+
+bool
+transfers_ownership(const ring& r) noexcept
+{
+    return r.queue_family != r.owner_family;
+}
+
+std::optional<vk::DeviceSize>
+try_reserve(ring& r, vk::DeviceSize size, vk::DeviceSize alignment) noexcept
+{
+    auto head     = memory::align_up(r.head, alignment);
+    auto position = head % r.capacity;
+
+    // never straddle the end of the buffer, skip to its start instead
+    if (position + size > r.capacity) {
+        head += r.capacity - position;
+        position = 0;
+    }
+
+    if (head + size - r.tail > r.capacity) { return std::nullopt; }
+
+    r.head = head + size;
+    return position;
+}
+
+void
+wait_oldest(ring& r) noexcept
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    auto& oldest = r.inflight.front();
+    r.device.waitForFences(
+        1u, &*oldest.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+    ++r.stats.stalls;
+    r.stats.stall_time += std::chrono::steady_clock::now() - start;
+
+    retire(r);
+}
+
+vk::DeviceSize
+reserve(ring& r, vk::DeviceSize size, vk::DeviceSize alignment) noexcept
+{
+    if (size > r.capacity) {
+        ERROR("{} bytes don't fit the staging ring", size);
+    }
+
+    for (;;) {
+        if (auto position = try_reserve(r, size, alignment)) {
+            return *position;
+        }
+
+        retire(r);
+        if (r.inflight.empty() && r.copies.empty() &&
+            r.image_copies.empty()) {
+            // nothing is in use, restart at the beginning of the buffer
+            r.head = r.tail = memory::align_up(r.head, r.capacity);
+        }
+        if (auto position = try_reserve(r, size, alignment)) {
+            return *position;
+        }
+
+        // the ring is full: submit what we have and wait for the oldest batch
+        flush(r);
+        wait_oldest(r);
+    }
+}
+
+batch
+acquire_batch(ring& r) noexcept
+{
+    if (!r.idle.empty()) {
+        auto b = std::move(r.idle.back());
+        r.idle.pop_back();
+        return b;
+    }
+
+    batch b;
+
+    vk::CommandBufferAllocateInfo cbai(
+        *r.command_pool, vk::CommandBufferLevel::ePrimary, 1);
+    auto [cbresult, command_buffers] =
+        r.device.allocateCommandBuffersUnique(cbai);
+    if (cbresult != vk::Result::eSuccess) {
+        ERROR("failed to allocate upload command buffer");
+    }
+    b.command_buffer = std::move(command_buffers.front());
+
+    auto [fresult, fence] = r.device.createFenceUnique(vk::FenceCreateInfo());
+    if (fresult != vk::Result::eSuccess) {
+        ERROR("failed to create upload fence");
+    }
+    b.fence = std::move(fence);
+
+    auto [sresult, semaphore] =
+        r.device.createSemaphoreUnique(vk::SemaphoreCreateInfo());
+    if (sresult != vk::Result::eSuccess) {
+        ERROR("failed to create upload semaphore");
+    }
+    b.semaphore = std::move(semaphore);
+
+    return b;
+}
+
+vk::ImageMemoryBarrier
+level_barrier(
+    const pending_image_copy& copy,
+    vk::AccessFlags           src_access,
+    vk::AccessFlags           dst_access,
+    vk::ImageLayout           old_layout,
+    vk::ImageLayout           new_layout) noexcept
+{
+    return vk::ImageMemoryBarrier(
+        src_access,
+        dst_access,
+        old_layout,
+        new_layout,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        copy.destination,
+        vk::ImageSubresourceRange(
+            vk::ImageAspectFlagBits::eColor,
+            copy.region.imageSubresource.mipLevel,
+            1,
+            0,
+            1));
+}
+
+// records the image copies of a flush between the layout transitions of
+// the levels they write; levels finished here are released to the owner
+// family, or made visible to the shaders when there is no transfer
+void
+record_image_copies(ring& r, vk::CommandBuffer command_buffer) noexcept
+{
+    std::vector<vk::ImageMemoryBarrier> transitions;
+    for (const auto& copy : r.image_copies) {
+        if (copy.first) {
+            transitions.push_back(level_barrier(
+                copy,
+                {},
+                vk::AccessFlagBits::eTransferWrite,
+                vk::ImageLayout::eUndefined,
+                vk::ImageLayout::eTransferDstOptimal));
+        }
+    }
+    if (!transitions.empty()) {
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTopOfPipe,
+            vk::PipelineStageFlagBits::eTransfer,
+            {},
+            nullptr,
+            nullptr,
+            transitions);
+    }
+
+    for (const auto& copy : r.image_copies) {
+        command_buffer.copyBufferToImage(
+            r.buffer,
+            copy.destination,
+            vk::ImageLayout::eTransferDstOptimal,
+            copy.region);
+    }
+
+    transitions.clear();
+    for (const auto& copy : r.image_copies) {
+        if (!copy.last) { continue; }
+
+        auto barrier = level_barrier(
+            copy,
+            vk::AccessFlagBits::eTransferWrite,
+            vk::AccessFlagBits::eShaderRead,
+            vk::ImageLayout::eTransferDstOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal);
+        if (transfers_ownership(r)) {
+            barrier.srcQueueFamilyIndex = r.queue_family;
+            barrier.dstQueueFamilyIndex = r.owner_family;
+            barrier.dstAccessMask       = {};
+            transitions.push_back(barrier);
+
+            // the acquire repeats the layout transition
+            barrier.srcAccessMask = {};
+            barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+            r.image_acquires.push_back(barrier);
+        } else {
+            transitions.push_back(barrier);
+        }
+    }
+    if (!transitions.empty()) {
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            transfers_ownership(r) ? vk::PipelineStageFlagBits::eBottomOfPipe :
+                                     g_consumer_stages,
+            {},
+            nullptr,
+            nullptr,
+            transitions);
+    }
+}
+
+} // namespace
+
+void
+initialize(
+    ring&          r,
+    vk::Device     device,
+    vk::Queue      queue,
+    uint32_t       queue_family,
+    uint32_t       owner_family,
+    vk::Buffer     buffer,
+    std::byte*     mapped,
+    vk::DeviceSize capacity) noexcept
+{
+    r.device       = device;
+    r.queue        = queue;
+    r.queue_family = queue_family;
+    r.owner_family = owner_family;
+    r.buffer       = buffer;
+    r.mapped       = mapped;
+    r.capacity     = capacity;
+
+    vk::CommandPoolCreateInfo cpci(
+        vk::CommandPoolCreateFlagBits::eResetCommandBuffer |
+            vk::CommandPoolCreateFlagBits::eTransient,
+        queue_family);
+
+    auto [result, command_pool] = device.createCommandPoolUnique(cpci);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create upload command pool");
+    }
+
+    r.command_pool = std::move(command_pool);
+}
+
+// copies `data` into the ring and queues a copy into `destination`; nothing
+// is submitted until flush(), so many small uploads share one submission
+void
+upload(
+    ring&          r,
+    vk::Buffer     destination,
+    vk::DeviceSize destination_offset,
+    const void*    data,
+    vk::DeviceSize size) noexcept
+{
+    const auto* bytes = static_cast<const std::byte*>(data);
+    const auto  chunk = r.capacity / 2;
+
+    while (size != 0) {
+        const auto part     = std::min(size, chunk);
+        const auto position = reserve(r, part, 16);
+
+        std::memcpy(r.mapped + position, bytes, part);
+
+        auto& copies = r.copies;
+        if (!copies.empty() && copies.back().destination == destination &&
+            copies.back().region.srcOffset + copies.back().region.size ==
+                position &&
+            copies.back().region.dstOffset + copies.back().region.size ==
+                destination_offset) {
+            copies.back().region.size += part;
+        } else {
+            copies.push_back(
+                {destination,
+                 vk::BufferCopy(position, destination_offset, part)});
+        }
+
+        r.stats.bytes += part;
+        ++r.stats.copies;
+
+        bytes += part;
+        destination_offset += part;
+        size -= part;
+    }
+}
+
+// copies one mip level (`extent` texels, `size` bytes of rows of blocks
+// `block_height` texels high) into the ring and queues its copy into
+// `destination`, whose other levels the copy leaves alone; levels larger
+// than half the ring go out in bands of rows, so any level fits. The level
+// is in shader read-only layout once the copies are flushed and acquired
+void
+upload_image(
+    ring&          r,
+    vk::Image      destination,
+    uint32_t       level,
+    vk::Extent2D   extent,
+    uint32_t       block_height,
+    const void*    data,
+    vk::DeviceSize size) noexcept
+{
+    const auto* bytes    = static_cast<const std::byte*>(data);
+    const auto  rows     = (extent.height + block_height - 1) / block_height;
+    const auto  row_size = size / rows;
+    const auto  band =
+        std::max<vk::DeviceSize>(r.capacity / 2 / row_size, 1);
+
+    for (uint32_t row = 0; row != rows;) {
+        const auto count =
+            uint32_t(std::min<vk::DeviceSize>(band, rows - row));
+        const auto part = count * row_size;
+
+        // 16 covers the texel block size of every format
+        const auto position = reserve(r, part, 16);
+        std::memcpy(r.mapped + position, bytes + row * row_size, part);
+
+        const auto top = row * block_height;
+        vk::BufferImageCopy region(
+            position,
+            0,
+            0,
+            vk::ImageSubresourceLayers(
+                vk::ImageAspectFlagBits::eColor, level, 0, 1),
+            vk::Offset3D(0, int32_t(top), 0),
+            vk::Extent3D(
+                extent.width,
+                std::min(count * block_height, extent.height - top),
+                1));
+        r.image_copies.push_back(
+            {destination, region, row == 0, row + count == rows});
+
+        r.stats.bytes += part;
+        ++r.stats.copies;
+
+        row += count;
+    }
+}
+
+void
+flush(ring& r) noexcept
+{
+    if (r.copies.empty() && r.image_copies.empty()) { return; }
+
+    auto b = acquire_batch(r);
+    auto command_buffer = *b.command_buffer;
+
+    vk::CommandBufferBeginInfo cbbi(
+        vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    if (command_buffer.begin(cbbi) != vk::Result::eSuccess) {
+        ERROR("failed to begin recording upload command buffer");
+    }
+
+    // one copy command per destination buffer
+    std::stable_sort(
+        begin(r.copies), end(r.copies), [](const auto& lhs, const auto& rhs) {
+            return lhs.destination < rhs.destination;
+        });
+
+    std::vector<vk::BufferCopy> regions;
+    for (auto it = begin(r.copies); it != end(r.copies);) {
+        const auto destination = it->destination;
+
+        regions.clear();
+        for (; it != end(r.copies) && it->destination == destination; ++it) {
+            regions.push_back(it->region);
+        }
+
+        command_buffer.copyBuffer(r.buffer, destination, regions);
+    }
+
+    record_image_copies(r, command_buffer);
+
+    if (transfers_ownership(r)) {
+        // release the written ranges to the owner family, which acquires
+        // them with the same barriers after waiting on the batch semaphore
+        std::vector<vk::BufferMemoryBarrier> releases;
+        releases.reserve(r.copies.size());
+        for (const auto& copy : r.copies) {
+            vk::BufferMemoryBarrier barrier(
+                vk::AccessFlagBits::eTransferWrite,
+                {},
+                r.queue_family,
+                r.owner_family,
+                copy.destination,
+                copy.region.dstOffset,
+                copy.region.size);
+            releases.push_back(barrier);
+
+            barrier.srcAccessMask = {};
+            barrier.dstAccessMask = g_consumer_access;
+            r.acquires.push_back(barrier);
+        }
+
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eBottomOfPipe,
+            {},
+            nullptr,
+            releases,
+            nullptr);
+    } else {
+        // later submissions on the queue may read the uploaded data anywhere
+        vk::MemoryBarrier barrier(
+            vk::AccessFlagBits::eTransferWrite,
+            vk::AccessFlagBits::eMemoryRead);
+        command_buffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eAllCommands,
+            {},
+            barrier,
+            nullptr,
+            nullptr);
+    }
+
+    if (command_buffer.end() != vk::Result::eSuccess) {
+        ERROR("failed to record upload command buffer");
+    }
+
+    vk::SubmitInfo submit_info;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers    = &command_buffer;
+
+    if (transfers_ownership(r)) {
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores    = &*b.semaphore;
+
+        b.awaiting_consumer = true;
+        b.consumer_value    = 0;
+        r.waits.push_back(*b.semaphore);
+    }
+
+    if (r.queue.submit(1, &submit_info, *b.fence) != vk::Result::eSuccess) {
+        ERROR("failed to submit upload command buffer");
+    }
+
+    b.end = r.head;
+    r.inflight.push_back(std::move(b));
+    r.copies.clear();
+    r.image_copies.clear();
+    ++r.stats.submissions;
+}
+
+// recycles finished batches without blocking
+void
+retire(ring& r) noexcept
+{
+    while (!r.inflight.empty() &&
+           r.device.getFenceStatus(*r.inflight.front().fence) ==
+               vk::Result::eSuccess) {
+        auto b = std::move(r.inflight.front());
+        r.inflight.pop_front();
+
+        r.tail = b.end;
+        if (r.device.resetFences(1u, &*b.fence) != vk::Result::eSuccess) {
+            ERROR("failed to reset upload fence");
+        }
+
+        if (b.awaiting_consumer) {
+            r.consuming.push_back(std::move(b));
+        } else {
+            r.idle.push_back(std::move(b));
+        }
+    }
+
+    // before the first acquire() there is no consumer timeline to query
+    handoff::recycle_consumed(r.consuming, r.idle, [&r] {
+        auto [result, completed] =
+            r.device.getSemaphoreCounterValueKHR(r.consumer_timeline);
+        if (result != vk::Result::eSuccess) {
+            ERROR("failed to query consumer timeline");
+        }
+        return completed;
+    });
+}
+
+// records the acquire half of the ownership transfers flushed so far into
+// `command_buffer` and returns the semaphores its submission has to wait on
+// (at g_consumer_stages); that submission must signal `value` on `timeline`
+std::vector<vk::Semaphore>
+acquire(
+    ring&             r,
+    vk::CommandBuffer command_buffer,
+    vk::Semaphore     timeline,
+    uint64_t          value) noexcept
+{
+    if (r.waits.empty()) { return {}; }
+
+    command_buffer.pipelineBarrier(
+        g_consumer_stages,
+        g_consumer_stages,
+        {},
+        nullptr,
+        r.acquires,
+        r.image_acquires);
+    r.acquires.clear();
+    r.image_acquires.clear();
+
+    r.consumer_timeline = timeline;
+
+    const auto hand_off = [value](batch& b) {
+        if (b.awaiting_consumer && b.consumer_value == 0) {
+            b.consumer_value = value;
+        }
+    };
+    std::for_each(begin(r.inflight), end(r.inflight), hand_off);
+    std::for_each(begin(r.consuming), end(r.consuming), hand_off);
+
+    ++r.stats.handoffs;
+    return std::exchange(r.waits, {});
+}
+
+vk::PipelineStageFlags
+consumer_stages() noexcept
+{
+    return g_consumer_stages;
+}
+
+void
+wait_idle(ring& r) noexcept
+{
+    flush(r);
+    while (!r.inflight.empty()) { wait_oldest(r); }
+}
+
+void
+log_statistics(const ring& r) noexcept
+{
+    const std::chrono::duration<double, std::milli> stall_time =
+        r.stats.stall_time;
+
+    spdlog::info(
+        "staging: {:.1f} MiB in {} copies / {} submissions, {} queue "
+        "handoffs, {} stalls ({:.3f}ms)",
+        static_cast<double>(r.stats.bytes) / (1024.0 * 1024.0),
+        r.stats.copies,
+        r.stats.submissions,
+        r.stats.handoffs,
+        r.stats.stalls,
+        stall_time.count());
+}
+
+} // namespace staging
@@ -0,0 +1,307 @@
+#ifndef MATERIALIST_SUBALLOCATOR_HPP
+#define MATERIALIST_SUBALLOCATOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// offset-only allocators used to carve device memory blocks; they never
+// touch the memory they manage
+
+namespace memory {
+
+constexpr uint64_t
+align_up(uint64_t value, uint64_t alignment) noexcept
+{
+    return alignment == 0 ? value :
+                            (value + alignment - 1) / alignment * alignment;
+}
+
+constexpr bool
+is_power_of_two(uint64_t value) noexcept
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+// power-of-two buddy allocator over [0, capacity); blocks of order k are
+// `min_size << k` bytes and aligned to their own size, so any power-of-two
+// alignment up to the rounded size comes for free
+class buddy_allocator {
+    uint64_t _capacity;
+    uint64_t _min_size;
+    uint64_t _used = 0;
+
+    // free block offsets per order
+    std::vector<std::unordered_set<uint64_t>> _free;
+
+    // offset -> order of live allocations
+    std::unordered_map<uint64_t, uint32_t> _allocated;
+
+    uint32_t
+    order_of(uint64_t size) const noexcept
+    {
+        uint32_t order = 0;
+        while ((_min_size << order) < size) { ++order; }
+        return order;
+    }
+
+public:
+    buddy_allocator(uint64_t capacity, uint64_t min_size = 256)
+        : _capacity(capacity), _min_size(min_size)
+    {
+        assert(is_power_of_two(capacity) && is_power_of_two(min_size));
+        assert(min_size <= capacity);
+
+        _free.resize(order_of(capacity) + 1);
+        _free.back().insert(0);
+    }
+
+    std::optional<uint64_t>
+    allocate(uint64_t size, uint64_t alignment = 1)
+    {
+        if (std::max(size, alignment) > _capacity) { return std::nullopt; }
+
+        const auto order = order_of(std::max(size, alignment));
+
+        auto from = order;
+        while (from != _free.size() && _free[from].empty()) { ++from; }
+        if (from == _free.size()) { return std::nullopt; }
+
+        const auto offset = *begin(_free[from]);
+        _free[from].erase(begin(_free[from]));
+
+        // split down, handing the upper halves back to the free lists
+        while (from != order) {
+            --from;
+            _free[from].insert(offset + (_min_size << from));
+        }
+
+        _allocated.emplace(offset, order);
+        _used += _min_size << order;
+
+        return offset;
+    }
+
+    void
+    free(uint64_t offset, uint64_t /* size */)
+    {
+        auto it = _allocated.find(offset);
+        assert(it != end(_allocated));
+
+        auto order = it->second;
+        _allocated.erase(it);
+        _used -= _min_size << order;
+
+        // merge with the buddy for as long as it is free too
+        while (order + 1 != _free.size()) {
+            const auto buddy = offset ^ (_min_size << order);
+            auto       found = _free[order].find(buddy);
+            if (found == end(_free[order])) { break; }
+
+            _free[order].erase(found);
+            offset = std::min(offset, buddy);
+            ++order;
+        }
+
+        _free[order].insert(offset);
+    }
+
+    uint64_t
+    capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    uint64_t
+    used() const noexcept
+    {
+        return _used;
+    }
+
+    size_t
+    allocation_count() const noexcept
+    {
+        return _allocated.size();
+    }
+
+    uint64_t
+    largest_free() const noexcept
+    {
+        for (auto order = _free.size(); order-- != 0;) {
+            if (!_free[order].empty()) { return _min_size << order; }
+        }
+        return 0;
+    }
+};
+
+// bump allocator for transient or write-once data; frees only count down and
+// the whole range is reclaimed once the last allocation is released
+class linear_allocator {
+    uint64_t _capacity;
+    uint64_t _head  = 0;
+    uint64_t _used  = 0;
+    size_t   _count = 0;
+
+public:
+    explicit linear_allocator(uint64_t capacity) : _capacity(capacity) {}
+
+    std::optional<uint64_t>
+    allocate(uint64_t size, uint64_t alignment = 1)
+    {
+        const auto offset = align_up(_head, alignment);
+        if (offset + size > _capacity) { return std::nullopt; }
+
+        _head = offset + size;
+        _used += size;
+        ++_count;
+
+        return offset;
+    }
+
+    void
+    free(uint64_t /* offset */, uint64_t size)
+    {
+        assert(_count != 0 && _used >= size);
+
+        _used -= size;
+        if (--_count == 0) { _head = 0; }
+    }
+
+    uint64_t
+    capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    uint64_t
+    used() const noexcept
+    {
+        return _used;
+    }
+
+    size_t
+    allocation_count() const noexcept
+    {
+        return _count;
+    }
+
+    uint64_t
+    largest_free() const noexcept
+    {
+        return _capacity - _head;
+    }
+};
+
+// first-fit allocator over a list of free ranges, for exactly sized
+// allocations of widely varying size; freed ranges merge with their free
+// neighbors
+class free_list_allocator {
+    uint64_t _capacity;
+    uint64_t _used  = 0;
+    size_t   _count = 0;
+
+    // offset -> size of every free range, none of them adjacent
+    std::map<uint64_t, uint64_t> _free;
+
+public:
+    explicit free_list_allocator(uint64_t capacity) : _capacity(capacity)
+    {
+        if (capacity != 0) { _free.emplace(0, capacity); }
+    }
+
+    std::optional<uint64_t>
+    allocate(uint64_t size, uint64_t alignment = 1)
+    {
+        for (auto it = begin(_free); it != end(_free); ++it) {
+            const auto [start, length] = *it;
+            const auto offset          = align_up(start, alignment);
+            if (offset + size > start + length) { continue; }
+
+            // the alignment padding and the tail stay free
+            _free.erase(it);
+            if (offset != start) { _free.emplace(start, offset - start); }
+            if (offset + size != start + length) {
+                _free.emplace(offset + size, start + length - offset - size);
+            }
+
+            _used += size;
+            ++_count;
+
+            return offset;
+        }
+        return std::nullopt;
+    }
+
+    void
+    free(uint64_t offset, uint64_t size)
+    {
+        assert(_count != 0 && _used >= size);
+
+        _used -= size;
+        --_count;
+
+        auto next = _free.lower_bound(offset);
+        assert(next == end(_free) || offset + size <= next->first);
+        if (next != end(_free) && next->first == offset + size) {
+            size += next->second;
+            next = _free.erase(next);
+        }
+        if (next != begin(_free)) {
+            auto previous = std::prev(next);
+            assert(previous->first + previous->second <= offset);
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                return;
+            }
+        }
+        _free.emplace_hint(next, offset, size);
+    }
+
+    uint64_t
+    capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    uint64_t
+    used() const noexcept
+    {
+        return _used;
+    }
+
+    size_t
+    allocation_count() const noexcept
+    {
+        return _count;
+    }
+
+    uint64_t
+    largest_free() const noexcept
+    {
+        uint64_t largest = 0;
+        for (const auto& range : _free) {
+            largest = std::max(largest, range.second);
+        }
+        return largest;
+    }
+};
+
+// 0 when all free space is one contiguous range, approaching 1 as it gets
+// scattered into small pieces
+inline double
+fragmentation(uint64_t free, uint64_t largest_free) noexcept
+{
+    if (free == 0) { return 0.0; }
+
+    return 1.0 - static_cast<double>(largest_free) / static_cast<double>(free);
+}
+
+} // namespace memory
+
+#endif // MATERIALIST_SUBALLOCATOR_HPP
@@ -0,0 +1,86 @@
+#ifndef MATERIALIST_SWATCH_HPP
+#define MATERIALIST_SWATCH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+namespace swatch {
+
+// per-instance values in the instance buffer, indexed by gl_InstanceIndex;
+// mirrors the std430 instance struct in shader.vert. The mesh is scaled
+// (zw) and moved (xy) in normalized device coordinates
+struct instance {
+    std::array<float, 4>    offset_scale = {0.f, 0.f, 1.f, 1.f};
+    uint32_t                material     = 0;
+    std::array<uint32_t, 3> padding      = {};
+};
+
+static_assert(sizeof(instance) == 32, "must match the std430 layout");
+
+// part of its cell a swatch covers, leaving a gap to its neighbours
+constexpr float FILL = .9f;
+
+// lays out `count` swatches row by row in cells as close to square as the
+// target allows; each swatch is a mesh of radius 1 kept round in pixels
+class grid {
+    uint32_t _columns;
+    uint32_t _rows;
+    float    _scale_x;
+    float    _scale_y;
+
+public:
+    grid(uint32_t count, uint32_t width, uint32_t height)
+    {
+        assert(count != 0 && width != 0 && height != 0);
+
+        const auto aspect = float(width) / float(height);
+        const auto columns =
+            uint32_t(std::ceil(std::sqrt(float(count) * aspect)));
+
+        _columns = std::clamp(columns, 1u, count);
+        _rows    = (count + _columns - 1) / _columns;
+
+        const auto cell = std::min(
+            float(width) / float(_columns), float(height) / float(_rows));
+        _scale_x = FILL * cell / float(width);
+        _scale_y = FILL * cell / float(height);
+    }
+
+    uint32_t
+    columns() const noexcept
+    {
+        return _columns;
+    }
+
+    uint32_t
+    rows() const noexcept
+    {
+        return _rows;
+    }
+
+    // the swatch in cell `index`, counting row by row from the top left
+    instance
+    place(uint32_t index, uint32_t material) const noexcept
+    {
+        assert(index < _columns * _rows);
+
+        const auto column = index % _columns;
+        const auto row    = index / _columns;
+
+        instance i;
+        i.offset_scale = {
+            float(2 * column + 1) / float(_columns) - 1.f,
+            float(2 * row + 1) / float(_rows) - 1.f,
+            _scale_x,
+            _scale_y};
+        i.material = material;
+        return i;
+    }
+};
+
+} // namespace swatch
+
+#endif // MATERIALIST_SWATCH_HPP
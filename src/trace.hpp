@@ -0,0 +1,220 @@
+#ifndef MATERIALIST_TRACE_HPP
+#define MATERIALIST_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// scoped CPU zones recorded into per-thread rings and exported as Chrome
+// trace JSON (chrome://tracing, ui.perfetto.dev); TRACE_ZONE compiles to
+// nothing unless MATERIALIST_TRACE is set
+
+namespace trace {
+
+using clock = std::chrono::steady_clock;
+
+// fields are relaxed atomics so a dump can run while the owning thread keeps
+// recording; entries overwritten during the dump are dropped
+struct event {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t>     begin{0};
+    std::atomic<int64_t>     end{0};
+};
+
+// single-writer ring; only the owning thread advances `head`
+class thread_buffer {
+    std::unique_ptr<event[]> _events;
+    size_t                   _capacity;
+    std::atomic<uint64_t>    _head{0};
+    uint32_t                 _thread_id;
+
+public:
+    thread_buffer(size_t capacity, uint32_t thread_id)
+        : _events(new event[capacity]), _capacity(capacity),
+          _thread_id(thread_id)
+    {}
+
+    void
+    record(const char* name, int64_t begin, int64_t end) noexcept
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        auto&      e    = _events[head % _capacity];
+        e.name.store(name, std::memory_order_relaxed);
+        e.begin.store(begin, std::memory_order_relaxed);
+        e.end.store(end, std::memory_order_relaxed);
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename F>
+    void
+    for_each(F&& f) const
+    {
+        // the writer fills slot `head` before it publishes head + 1, so the
+        // oldest of a full ring may be half overwritten already
+        const auto head  = _head.load(std::memory_order_acquire);
+        const auto first = head >= _capacity ? head - _capacity + 1 : 0;
+
+        for (auto i = first; i != head; ++i) {
+            const auto& e     = _events[i % _capacity];
+            const auto* name  = e.name.load(std::memory_order_relaxed);
+            const auto  begin = e.begin.load(std::memory_order_relaxed);
+            const auto  end   = e.end.load(std::memory_order_relaxed);
+
+            // the writer lapped us while reading this entry
+            const auto now = _head.load(std::memory_order_acquire);
+            if (i + _capacity <= now) { continue; }
+
+            f(name, begin, end);
+        }
+    }
+
+    void
+    clear() noexcept
+    {
+        _head.store(0, std::memory_order_release);
+    }
+
+    uint32_t
+    thread_id() const noexcept
+    {
+        return _thread_id;
+    }
+};
+
+class registry {
+    std::mutex                                  _mutex;
+    std::vector<std::shared_ptr<thread_buffer>> _buffers;
+
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+    static registry&
+    instance()
+    {
+        static registry r;
+        return r;
+    }
+
+    std::shared_ptr<thread_buffer>
+    add_thread()
+    {
+        std::lock_guard lock(_mutex);
+        _buffers.push_back(std::make_shared<thread_buffer>(
+            EVENTS_PER_THREAD, static_cast<uint32_t>(_buffers.size())));
+        return _buffers.back();
+    }
+
+    std::vector<std::shared_ptr<thread_buffer>>
+    buffers()
+    {
+        std::lock_guard lock(_mutex);
+        return _buffers;
+    }
+
+    // all timestamps are relative to this, so they stay small in the JSON
+    clock::time_point origin = clock::now();
+};
+
+inline thread_buffer&
+local_buffer()
+{
+    // the registry keeps the ring alive after the thread exits, so its
+    // events still make it into the dump
+    thread_local auto buffer = registry::instance().add_thread();
+    return *buffer;
+}
+
+inline int64_t
+now() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               clock::now() - registry::instance().origin)
+        .count();
+}
+
+class scope {
+    const char* _name;
+    int64_t     _begin;
+
+public:
+    explicit scope(const char* name) noexcept : _name(name), _begin(now()) {}
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+    ~scope() { local_buffer().record(_name, _begin, now()); }
+};
+
+inline void
+write_escaped(std::ostream& out, std::string_view text)
+{
+    for (auto c : text) {
+        if (c == '"' || c == '\\') { out << '\\'; }
+        out << c;
+    }
+}
+
+// Chrome trace event format, one complete ("X") event per zone
+inline void
+write_json(std::ostream& out)
+{
+    out << "{\"traceEvents\":[";
+
+    bool first = true;
+    for (const auto& buffer : registry::instance().buffers()) {
+        const auto tid = buffer->thread_id();
+        buffer->for_each([&](const char* name, int64_t begin, int64_t end) {
+            if (!first) { out << ','; }
+            first = false;
+
+            out << "{\"name\":\"";
+            write_escaped(out, name ? name : "?");
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << static_cast<double>(begin) / 1000.0
+                << ",\"dur\":" << static_cast<double>(end - begin) / 1000.0
+                << '}';
+        });
+    }
+
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+inline bool
+write_file(const std::string& path)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) { return false; }
+
+    write_json(file);
+    return static_cast<bool>(file);
+}
+
+// only while no other thread is recording
+inline void
+clear()
+{
+    for (const auto& buffer : registry::instance().buffers()) {
+        buffer->clear();
+    }
+}
+
+} // namespace trace
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#if defined(MATERIALIST_TRACE) && MATERIALIST_TRACE
+#define TRACE_ZONE(name)                                                       \
+    ::trace::scope TRACE_CONCAT(trace_zone_, __LINE__) { name }
+#else // MATERIALIST_TRACE
+#define TRACE_ZONE(name) ((void)0)
+#endif // MATERIALIST_TRACE
+
+#endif // MATERIALIST_TRACE_HPP
@@ -1,10 +1,57 @@
 #ifndef MATERIALIST_VULKAN_CONTEXT_HPP
 #define MATERIALIST_VULKAN_CONTEXT_HPP
 
+namespace material {
+
+struct feature_set;
+
+struct parameters;
+
+struct pipeline_state;
+
+} // namespace material
+
+namespace mesh_file {
+
+struct vertex;
+
+} // namespace mesh_file
+
+namespace swatch {
+
+struct instance;
+
+} // namespace swatch
+
 namespace vulkan {
 
+// trades throughput for input latency on windowed runs
+enum class present_policy {
+    // IMMEDIATE, tearing allowed; for benchmarking
+    throughput,
+
+    // FIFO with as few images as possible; the CPU waits for the GPU before
+    // sampling input, see pace_frame()
+    low_latency,
+
+    // MAILBOX, falling back to FIFO
+    smooth
+};
+
 struct context;
 
+struct vertex;
+
+struct mesh_range;
+
+struct scene_object;
+
+struct instance_range;
+
+struct compute_pipeline;
+
+struct texture_data;
+
 void initialize_context(context&, int, int) noexcept;
 
 void resize_window(context&) noexcept;
@@ -21,22 +68,139 @@ void pick_physical_device(context&) noexcept;
 
 void create_logical_device(context&) noexcept;
 
+void create_allocator(context&) noexcept;
+
+void create_pipeline_cache(context&) noexcept;
+
+void save_pipeline_cache(context&) noexcept;
+
 void create_swapchain(context&) noexcept;
 
+void create_offscreen_images(context&) noexcept;
+
 void create_image_views(context&) noexcept;
 
+vk::UniqueRenderPass build_render_pass(vk::Device, vk::Format, bool) noexcept;
+
 void create_render_pass(context&) noexcept;
 
+vk::UniquePipelineLayout
+build_graphics_pipeline_layout(vk::Device, vk::DescriptorSetLayout) noexcept;
+
+vk::UniquePipeline build_graphics_pipeline(
+    vk::Device,
+    vk::PipelineCache,
+    vk::PipelineLayout,
+    vk::RenderPass,
+    vk::ShaderModule,
+    vk::ShaderModule,
+    const material::pipeline_state&) noexcept;
+
 void create_graphics_pipeline(context&) noexcept;
 
+uint32_t add_material(
+    context&,
+    std::string,
+    const material::feature_set&,
+    const material::parameters&) noexcept;
+
+void set_material_parameters(
+    context&,
+    uint32_t,
+    const material::parameters&) noexcept;
+
+void build_materials(context&) noexcept;
+
+compute_pipeline create_compute_pipeline(
+    context&,
+    std::string_view,
+    gsl::span<const vk::DescriptorSetLayoutBinding>,
+    uint32_t) noexcept;
+
 void create_framebuffers(context&) noexcept;
 
-void create_command_pool(context&) noexcept;
+void create_workers(context&) noexcept;
+
+void create_command_pools(context&) noexcept;
 
 void create_command_buffers(context&) noexcept;
 
+void create_profiler(context&) noexcept;
+
+void create_geometry_buffers(context&) noexcept;
+
+void create_staging_ring(context&) noexcept;
+
+void create_bindless_resources(context&) noexcept;
+
+uint32_t add_texture(context&, vk::ImageView) noexcept;
+
+std::optional<texture_data> read_texture(
+    const context&,
+    const std::byte*,
+    size_t,
+    std::string_view) noexcept;
+
+uint32_t upload_texture(context&, const texture_data&) noexcept;
+
+std::optional<uint32_t> load_texture(context&, const std::string&) noexcept;
+
+mesh_range add_packed_mesh(
+    context&,
+    gsl::span<const mesh_file::vertex>,
+    gsl::span<const uint32_t>,
+    float) noexcept;
+
+mesh_range add_mesh(
+    context&,
+    gsl::span<const vertex>,
+    gsl::span<const uint32_t>) noexcept;
+
+std::optional<mesh_range> load_mesh(context&, const std::string&) noexcept;
+
+mesh_range add_sphere_mesh(context&, uint32_t, uint32_t) noexcept;
+
+uint32_t add_instances(context&, gsl::span<const swatch::instance>) noexcept;
+
+void release_instances(context&, const instance_range&) noexcept;
+
+void create_swatch_grid(
+    context&,
+    const mesh_range&,
+    gsl::span<const uint32_t>) noexcept;
+
+void create_culling_resources(context&) noexcept;
+
+void create_scene(
+    context&,
+    gsl::span<const scene_object>,
+    const instance_range&) noexcept;
+
 void create_sync_objects(context&) noexcept;
 
+uint64_t completed_frames(context&) noexcept;
+
+void wait_for_frames(context&, uint64_t) noexcept;
+
+template <typename T>
+void defer_destroy(context&, T&&) noexcept;
+
+void on_frames_retired(context&, uint64_t, std::function<void()>) noexcept;
+
+void run_retired(context&) noexcept;
+
+void set_present_policy(context&, present_policy, uint32_t) noexcept;
+
+void pace_frame(context&) noexcept;
+
+void log_latency(const context&) noexcept;
+
+void begin_frame(context&) noexcept;
+
+void end_frame(context&) noexcept;
+
+void wait_idle(context&) noexcept;
+
 } // namespace vulkan
 
 #endif // MATERIALIST_VULKAN_CONTEXT_HPP
@@ -1,8 +1,199 @@
 namespace vulkan {
 
+// what procedural meshes are built from; add_mesh() packs it into a
+// mesh_file::vertex, the format of the vertex buffer
+struct vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+// where a mesh lives inside the shared vertex and index buffers; `radius`
+// bounds its vertices around the origin
+struct mesh_range {
+    uint32_t first_index;
+    uint32_t index_count;
+    int32_t  vertex_offset;
+    float    radius;
+};
+
+// one object of the GPU-driven scene: `mesh` drawn as instance `instance`
+// of the instance buffer, with the pipeline of `material`
+struct scene_object {
+    mesh_range mesh;
+    uint32_t   instance;
+    uint32_t   material;
+};
+
+// instances [first, first + count) of the instance buffer, as
+// add_instances() returned them
+struct instance_range {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+struct draw_command {
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t  vertex_offset;
+    uint32_t first_instance;
+    uint32_t material = 0;
+};
+
+// an object as cull.comp reads it; a visible object's draw command goes to
+// the first free slot of its batch, from `first_command` on
+struct culling_object {
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t  vertex_offset;
+    uint32_t instance;
+    float    radius;
+    uint32_t batch;
+    uint32_t first_command;
+    uint32_t padding = 0;
+};
+
+static_assert(sizeof(culling_object) == 32, "must match cull.comp");
+
+// objects sharing a material permutation, drawn with one
+// drawIndexedIndirectCount; their commands are
+// [first_command, first_command + capacity)
+struct scene_batch {
+    uint32_t first_command;
+    uint32_t capacity;
+    uint32_t material;
+};
+
+// the scene uploaded by create_scene(), replaced as a whole; it owns the
+// instances its objects draw with
+struct gpu_scene {
+    uint32_t                       object_count = 0;
+    instance_range                 instances;
+    std::vector<scene_batch>       batches;
+    buffer                         objects;
+    vk::UniqueDescriptorPool       descriptor_pool;
+    std::vector<vk::DescriptorSet> descriptor_sets; // [frame in flight]
+};
+
+struct cull_constants {
+    glm::vec4 view;
+    uint32_t  object_count;
+};
+
+// slots of the cull count buffer; the batches' command counts follow
+constexpr uint32_t VISIBLE_COUNT     = 0;
+constexpr uint32_t CULLED_COUNT      = 1;
+constexpr uint32_t FIRST_BATCH_COUNT = 2;
+
+constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+// secondary command buffers recorded by one worker thread for one frame in
+// flight; buffers are kept across frames and only the pool is reset
+struct worker_command_pool {
+    vk::UniqueCommandPool                pool;
+    std::vector<vk::UniqueCommandBuffer> buffers;
+    size_t                               used = 0;
+};
+
+struct compute_pipeline {
+    vk::UniqueDescriptorSetLayout set_layout;
+    vk::UniquePipelineLayout      layout;
+    vk::UniquePipeline            pipeline;
+};
+
+// members are ordered so the handle is destroyed before its memory is freed
+struct buffer {
+    memory::allocation allocation;
+    vk::UniqueBuffer   handle;
+};
+
+struct image {
+    memory::allocation allocation;
+    vk::UniqueImage    handle;
+};
+
+// a sampled image and the view the bindless texture array refers to it by
+struct texture {
+    image               storage;
+    vk::UniqueImageView view;
+};
+
+// a mip chain ready for upload_texture(), largest level first; the levels
+// point into the file it was read from, or into `decoded` when the device
+// can't sample the file's format
+struct texture_data {
+    vk::Format format = vk::Format::eUndefined;
+    uint32_t   width  = 0;
+    uint32_t   height = 0;
+
+    // texels per row of blocks
+    uint32_t block_height = 1;
+
+    std::vector<ktx2::level>          levels;
+    std::vector<std::vector<uint8_t>> decoded;
+};
+
+struct retire_callback {
+    uint64_t              value;
+    std::function<void()> callback;
+};
+
+// objects replaced while frames up to `value` may still use them; the whole
+// batch is destroyed, in the order it was parked, once they retire
+struct retired_objects {
+    uint64_t                           value;
+    std::vector<std::shared_ptr<void>> objects;
+};
+
 struct context {
+    // frames the CPU may record ahead of the GPU
+    uint32_t frames_in_flight = 2;
+
+    // per-frame resources of the frame being recorded: frame_number %
+    // frames_in_flight
     size_t current_frame = 0;
 
+    // frames submitted so far; frame n signals n + 1 on `timeline` when the
+    // GPU is done with it, so the timeline value is the count of retired
+    // frames
+    uint64_t frame_number = 0;
+
+    // render into offscreen images instead of a window swapchain
+    bool headless = false;
+
+    present_policy present = present_policy::smooth;
+
+    // swapchain images to request, 0 lets the present policy decide; clamped
+    // to what the surface supports
+    uint32_t swapchain_image_count = 0;
+
+    // when the input of the frame being recorded was sampled, and the time
+    // from there until its presentKHR returned
+    std::chrono::steady_clock::time_point input_time;
+    sample_window                         input_to_present_ms;
+
+    std::string pipeline_cache_path = "materialist.pipeline_cache";
+
+    // 0 picks std::thread::hardware_concurrency()
+    size_t                      worker_count = 0;
+    std::unique_ptr<jobs::pool> workers;
+
+    std::vector<draw_command> draws;
+
+    // all meshes share one vertex and one index buffer, filled front to back
+    uint32_t vertex_capacity = 1u << 20;
+    uint32_t index_capacity  = 1u << 22;
+    uint32_t vertex_count    = 0;
+    uint32_t index_count     = 0;
+
+    vk::DeviceSize staging_capacity = 32ull << 20;
+
+    // the texture formats the device samples with linear filtering, of
+    // those KTX2 files may hold; read-only once the device is picked, so
+    // loader threads may look formats up
+    std::set<vk::Format> sampled_formats;
+
     glfw::window       window;
     vk::UniqueInstance instance;
 
@@ -13,23 +204,91 @@ struct context {
     vk::UniqueSurfaceKHR                 surface;
     vk::PhysicalDevice                   physical_device;
     vk::UniqueDevice                     device;
+    memory::allocator                    allocator;
+    shaders::cache                       shader_modules;
+    vk::UniquePipelineCache              pipeline_cache;
     vk::Queue                            graphics_queue;
     vk::Queue                            present_queue;
+    vk::Queue                            transfer_queue;
+    vk::Queue                            compute_queue;
     vk::UniqueSwapchainKHR               swapchain;
+    profiler::gpu                        gpu_profiler;
+    buffer                               staging_buffer;
+    staging::ring                        staging;
+    buffer                               vertex_buffer;
+    buffer                               index_buffer;
+
+    // bindless material data: parameters of every material in one storage
+    // buffer and every texture in one sampled image array, both indexed in
+    // the shaders from the material index of the drawn instance
+    uint32_t                      material_capacity = 4096;
+    uint32_t                      texture_capacity  = 4096;
+    uint32_t                      texture_count     = 0;
+    uint32_t                      instance_capacity = 1 << 17;
+    memory::free_list_allocator   instance_ranges{instance_capacity};
+    instance_range                grid_instances;
+    buffer                        material_buffer;
+    buffer                        instance_buffer;
+    vk::UniqueSampler             sampler;
+    vk::UniqueDescriptorSetLayout bindless_set_layout;
+    vk::UniqueDescriptorPool      bindless_pool;
+    vk::DescriptorSet             bindless_set;
+
+    // what upload_texture() created, and the device memory it takes
+    std::vector<texture> textures;
+    vk::DeviceSize       texture_bytes = 0;
+
+    // 2D camera over everything drawn: offset (xy) and zoom (zw) in
+    // normalized device coordinates
+    glm::vec4 view = {0.f, 0.f, 1.f, 1.f};
+
+    // GPU-driven scene: every frame a compute pass culls its objects
+    // against the view and writes the visible ones' draw commands,
+    // compacted per batch, for drawIndexedIndirectCount; the CPU records one
+    // draw per batch, however many objects the scene holds
+    uint32_t            scene_object_capacity = 1 << 17;
+    uint32_t            scene_batch_capacity  = 1024;
+    compute_pipeline    cull_pipeline;
+    std::vector<buffer> cull_commands; // [frame in flight]
+    std::vector<buffer> cull_counts;   // [frame in flight]
+    gpu_scene           scene;
+
+    buffer profiler_counters;
+
+    std::vector<image>                   offscreen_images;
     std::vector<vk::Image>               images;
     vk::Format                           format;
     vk::Extent2D                         extent;
     std::vector<vk::UniqueImageView>     views;
     vk::UniqueRenderPass                 render_pass;
     vk::UniquePipelineLayout             pipeline_layout;
-    vk::UniquePipeline                   graphics_pipeline;
+    material::library                    materials;
+
+    // [permutation], empty until build_materials() compiled it
+    std::vector<vk::UniquePipeline> material_pipelines;
+
     std::vector<vk::UniqueFramebuffer>   framebuffers;
-    vk::UniqueCommandPool                command_pool;
+    std::vector<vk::UniqueCommandPool>   command_pools;
     std::vector<vk::UniqueCommandBuffer> command_buffers;
+
+    // [frame in flight][worker]
+    std::vector<std::vector<worker_command_pool>> worker_pools;
+    std::vector<vk::CommandBuffer>                secondary_buffers;
+
+    // time each worker spent recording the last frame
+    std::vector<std::chrono::nanoseconds> worker_record_times;
     std::vector<vk::UniqueSemaphore>     image_avail_semaphores;
     std::vector<vk::UniqueSemaphore>     render_finished_semaphores;
-    std::vector<vk::UniqueFence>         inflight_fences;
-    std::vector<vk::Fence>               images_inflight;
+    vk::UniqueSemaphore                  timeline;
+
+    // timeline value of the last frame that rendered to each image
+    std::vector<uint64_t> image_frames;
+
+    // CPU work waiting for a frame to retire, ordered by value
+    std::deque<retire_callback> retire_queue;
+
+    // declared last so parked objects go before the device on destruction
+    std::deque<retired_objects> deletion_queue;
 
     context()               = default;
     context(const context&) = delete;
@@ -38,8 +297,6 @@ struct context {
 
 namespace /* anonymous */ {
 
-constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
 #ifndef NDEBUG
 
 constexpr auto g_validation_layers = std::array{"VK_LAYER_KHRONOS_validation",
@@ -56,15 +313,36 @@ constexpr auto g_validation_layers = std::array{"VK_LAYER_KHRONOS_validation",
 
 #endif // NDEBUG
 
-constexpr auto g_device_extensions =
-    std::array{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+std::vector<const char*>
+get_required_device_extensions(bool headless) noexcept
+{
+    std::vector<const char*> extensions{
+        VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+        VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+        VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME};
+    if (!headless) { extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME); }
+
+    return extensions;
+}
+
+constexpr auto g_offscreen_format = vk::Format::eR8G8B8A8Unorm;
+
+const auto g_triangle_vertices = std::array{
+    vertex{{0.f, -.5f, 0.f}, {0.f, 0.f, -1.f}, {1.f, 0.f}},
+    vertex{{.5f, .5f, 0.f}, {0.f, 0.f, -1.f}, {0.f, 1.f}},
+    vertex{{-.5f, .5f, 0.f}, {0.f, 0.f, -1.f}, {0.f, 0.f}}};
+
+constexpr auto g_triangle_indices = std::array<uint32_t, 3>{0, 1, 2};
 
 std::vector<const char*>
-get_required_extensions() noexcept
+get_required_extensions(bool headless) noexcept
 {
     uint32_t     glfw_extension_count = 0;
-    const char** glfw_extensions;
-    glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    const char** glfw_extensions      = nullptr;
+    if (!headless) {
+        glfw_extensions =
+            glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    }
 
     std::vector<const char*> extensions;
     extensions.reserve(
@@ -107,7 +385,47 @@ populate_debug_messenger_create_info() noexcept
 #endif // NDEBUG
 
 bool
-check_device_extension_support(vk::PhysicalDevice physical_device) noexcept
+supports_timeline_semaphores(vk::PhysicalDevice physical_device) noexcept
+{
+    const auto features = physical_device.getFeatures2<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+
+    return features.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>()
+        .timelineSemaphore;
+}
+
+// what the bindless texture array needs: indexing it with a per-draw (or
+// per-instance) index, leaving slots empty and adding textures while it's
+// bound
+bool
+supports_descriptor_indexing(vk::PhysicalDevice physical_device) noexcept
+{
+    const auto features = physical_device.getFeatures2<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+    const auto& indexing =
+        features.get<vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+
+    return indexing.shaderSampledImageArrayNonUniformIndexing &&
+           indexing.descriptorBindingSampledImageUpdateAfterBind &&
+           indexing.descriptorBindingPartiallyBound &&
+           indexing.runtimeDescriptorArray;
+}
+
+// what the GPU-driven scene needs: one indirect call draws many objects,
+// each with its own instance
+bool
+supports_multi_draw_indirect(vk::PhysicalDevice physical_device) noexcept
+{
+    const auto features = physical_device.getFeatures();
+
+    return features.multiDrawIndirect && features.drawIndirectFirstInstance;
+}
+
+bool
+check_device_extension_support(
+    vk::PhysicalDevice physical_device, bool headless) noexcept
 {
     auto [result, available_extensions] =
         physical_device.enumerateDeviceExtensionProperties();
@@ -115,17 +433,21 @@ check_device_extension_support(vk::PhysicalDevice physical_device) noexcept
         ERROR("failed to enumerate device extension properties");
     }
 
+    const auto extensions = get_required_device_extensions(headless);
+
     std::set<std::string> required_extensions(
-        begin(g_device_extensions), end(g_device_extensions));
+        begin(extensions), end(extensions));
     for (const auto& extension : available_extensions) {
         required_extensions.erase(extension.extensionName);
     }
 
-#ifndef NDEBUG
+    // other devices may still qualify, so a missing extension isn't fatal
     for (const auto& extension : required_extensions) {
-        ERROR("extension {} is not supported", extension);
+        spdlog::debug(
+            "{} does not support {}",
+            physical_device.getProperties().deviceName,
+            extension);
     }
-#endif // NDEBUG
 
     return required_extensions.empty();
 }
@@ -133,6 +455,8 @@ check_device_extension_support(vk::PhysicalDevice physical_device) noexcept
 struct queue_family_indices {
     std::optional<uint32_t> graphics_family;
     std::optional<uint32_t> present_family;
+    std::optional<uint32_t> transfer_family;
+    std::optional<uint32_t> compute_family;
 
     operator bool() const { return graphics_family && present_family; }
 };
@@ -145,8 +469,9 @@ struct swapchain_support_details {
     operator bool() const { return !formats.empty() && !present_modes.empty(); }
 };
 
+// without a surface (headless) the graphics family doubles as present family
 queue_family_indices
-find_queue_families(vk::PhysicalDevice physical_device, vk::SurfaceKHR& surface)
+find_queue_families(vk::PhysicalDevice physical_device, vk::SurfaceKHR surface)
 {
     queue_family_indices indices;
 
@@ -164,6 +489,53 @@ find_queue_families(vk::PhysicalDevice physical_device, vk::SurfaceKHR& surface)
             std::distance(begin(queue_families), queue_family_it);
     }
 
+    // prefer a family that can do nothing but transfers (usually backed by
+    // the DMA engines), then one without graphics, then the graphics family
+    // itself; graphics and compute families support transfers implicitly
+    const auto find_transfer_family = [&queue_families](auto excluded) {
+        auto it = std::find_if(
+            begin(queue_families),
+            end(queue_families),
+            [excluded](const auto& queue_family) {
+                return (queue_family.queueFlags &
+                        vk::QueueFlagBits::eTransfer) &&
+                       !(queue_family.queueFlags & excluded);
+            });
+        return it == end(queue_families) ?
+                   std::optional<uint32_t>() :
+                   gsl::narrow<uint32_t>(
+                       std::distance(begin(queue_families), it));
+    };
+
+    indices.transfer_family = find_transfer_family(
+        vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute);
+    if (!indices.transfer_family) {
+        indices.transfer_family =
+            find_transfer_family(vk::QueueFlags(vk::QueueFlagBits::eGraphics));
+    }
+    if (!indices.transfer_family) {
+        indices.transfer_family = indices.graphics_family;
+    }
+
+    // a compute family without graphics runs asynchronously to rendering
+    auto compute_family_it = std::find_if(
+        begin(queue_families),
+        end(queue_families),
+        [](const auto& queue_family) {
+            return (queue_family.queueFlags & vk::QueueFlagBits::eCompute) &&
+                   !(queue_family.queueFlags & vk::QueueFlagBits::eGraphics);
+        });
+    indices.compute_family =
+        compute_family_it == end(queue_families) ?
+            indices.graphics_family :
+            gsl::narrow<uint32_t>(
+                std::distance(begin(queue_families), compute_family_it));
+
+    if (!surface) {
+        indices.present_family = indices.graphics_family;
+        return indices;
+    }
+
     vk::Result result;
     vk::Bool32 present_support = false;
     for (int idx = 0; idx != static_cast<int>(queue_families.size()); ++idx) {
@@ -209,24 +581,37 @@ query_swapchain_support(
 
 bool
 is_device_suitable(
-    vk::PhysicalDevice physical_device, vk::SurfaceKHR& surface) noexcept
+    vk::PhysicalDevice physical_device, vk::SurfaceKHR surface) noexcept
 {
-    auto device_features   = physical_device.getFeatures();
-    auto device_properties = physical_device.getProperties();
-
-    bool extensions_supported = check_device_extension_support(physical_device);
-
     const auto indices = find_queue_families(physical_device, surface);
 
-    swapchain_support_details swapchain_support;
-    if (extensions_supported) {
-        swapchain_support = query_swapchain_support(physical_device, surface);
+    if (!check_device_extension_support(physical_device, !surface) ||
+        !supports_timeline_semaphores(physical_device) ||
+        !supports_descriptor_indexing(physical_device) ||
+        !supports_multi_draw_indirect(physical_device)) {
+        return false;
     }
 
-    return indices &&
-           device_properties.deviceType ==
-               vk::PhysicalDeviceType::eDiscreteGpu &&
-           device_features.geometryShader && swapchain_support;
+    if (!surface) { return indices; }
+
+    const auto swapchain_support =
+        query_swapchain_support(physical_device, surface);
+
+    return indices && swapchain_support;
+}
+
+// discrete GPUs are preferred, but integrated and CPU (e.g. lavapipe)
+// implementations are accepted so we can run on render farm boxes and CI
+int
+device_type_rank(vk::PhysicalDeviceType device_type) noexcept
+{
+    switch (device_type) {
+    case vk::PhysicalDeviceType::eDiscreteGpu: return 4;
+    case vk::PhysicalDeviceType::eIntegratedGpu: return 3;
+    case vk::PhysicalDeviceType::eVirtualGpu: return 2;
+    case vk::PhysicalDeviceType::eCpu: return 1;
+    default: return 0;
+    }
 }
 
 vk::SurfaceFormatKHR
@@ -246,18 +631,71 @@ choose_swap_surface_format(
 
 vk::PresentModeKHR
 choose_swap_present_mode(
-    const std::vector<vk::PresentModeKHR>& available_present_modes)
+    const std::vector<vk::PresentModeKHR>& available_present_modes,
+    present_policy                         policy)
 {
-    auto it = std::find_if(
-        begin(available_present_modes),
-        end(available_present_modes),
-        [](const auto& apm) { return apm == vk::PresentModeKHR::eMailbox; });
+    auto available = [&available_present_modes](vk::PresentModeKHR mode) {
+        return std::find(
+                   begin(available_present_modes),
+                   end(available_present_modes),
+                   mode) != end(available_present_modes);
+    };
 
-    if (it != end(available_present_modes)) { return *it; }
+    switch (policy) {
+    case present_policy::throughput:
+        if (available(vk::PresentModeKHR::eImmediate)) {
+            return vk::PresentModeKHR::eImmediate;
+        }
+        if (available(vk::PresentModeKHR::eMailbox)) {
+            return vk::PresentModeKHR::eMailbox;
+        }
+        break;
+    case present_policy::low_latency:
+        break;
+    case present_policy::smooth:
+        if (available(vk::PresentModeKHR::eMailbox)) {
+            return vk::PresentModeKHR::eMailbox;
+        }
+        break;
+    }
 
+    // the only mode every implementation has to support
     return vk::PresentModeKHR::eFifo;
 }
 
+const char*
+to_string(present_policy policy) noexcept
+{
+    switch (policy) {
+    case present_policy::throughput: return "throughput";
+    case present_policy::low_latency: return "low_latency";
+    case present_policy::smooth: return "smooth";
+    }
+
+    return "unknown";
+}
+
+uint32_t
+choose_swap_image_count(
+    const vk::SurfaceCapabilitiesKHR& capabilities,
+    present_policy                    policy,
+    uint32_t                          requested) noexcept
+{
+    // every image queued for display in FIFO adds a refresh of latency
+    if (requested == 0) {
+        requested = policy == present_policy::low_latency ?
+                        capabilities.minImageCount :
+                        capabilities.minImageCount + 1u;
+    }
+
+    requested = std::max(requested, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0) {
+        requested = std::min(requested, capabilities.maxImageCount);
+    }
+
+    return requested;
+}
+
 vk::Extent2D
 choose_swap_extent(
     GLFWwindow* window, const vk::SurfaceCapabilitiesKHR& capabilities) noexcept
@@ -288,6 +726,8 @@ choose_swap_extent(
 void
 recreate_swapchain(context& ctx) noexcept
 {
+    TRACE_ZONE("recreate_swapchain");
+
     int width = 0, height = 0;
     glfwGetFramebufferSize(*ctx.window, &width, &height);
     while (width == 0 || height == 0) {
@@ -295,153 +735,598 @@ recreate_swapchain(context& ctx) noexcept
         glfwWaitEvents();
     }
 
-    ctx.device->waitIdle();
+    // frames still in flight may reference the old swapchain and its
+    // attachments, which are parked until they retire instead of stalling
+    defer_destroy(ctx, std::move(ctx.framebuffers));
+    defer_destroy(ctx, std::move(ctx.views));
+
+    const auto format = ctx.format;
 
     create_swapchain(ctx);
     create_image_views(ctx);
-    create_render_pass(ctx);
-    create_graphics_pipeline(ctx);
-    create_framebuffers(ctx);
-    create_command_buffers(ctx);
-}
 
-std::vector<char>
-read_file(std::string_view filename) noexcept
-{
-    std::ifstream file(filename.data(), std::ios::ate | std::ios::binary);
-    if (!file) { ERROR("failed to open file {}", filename); }
+    // render pass and pipeline don't depend on the extent, only on the format
+    if (ctx.format != format) {
+        create_render_pass(ctx);
+        create_graphics_pipeline(ctx);
+    }
 
-    const auto        file_size = file.tellg();
-    std::vector<char> buffer(file_size);
-    file.seekg(0);
-    file.read(buffer.data(), file_size);
-    file.close();
+    create_framebuffers(ctx);
 
-    return buffer;
+    ctx.image_frames.assign(ctx.images.size(), 0);
 }
 
-vk::UniqueShaderModule
-create_shader_module(vk::Device& device, const std::vector<char>& code) noexcept
+// headless counterpart of recreate_swapchain(), the format never changes
+void
+resize_offscreen(context& ctx, uint32_t width, uint32_t height) noexcept
 {
-    vk::ShaderModuleCreateInfo smci(
-        {}, code.size(), reinterpret_cast<const uint32_t*>(code.data()));
+    TRACE_ZONE("resize_offscreen");
 
-    auto [result, shader_module] = device.createShaderModuleUnique(smci);
-    if (result != vk::Result::eSuccess) {
-        ERROR("failed to create shader module");
-    }
+    defer_destroy(ctx, std::move(ctx.framebuffers));
+    defer_destroy(ctx, std::move(ctx.views));
 
-    return std::move(shader_module);
+    ctx.extent = vk::Extent2D(width, height);
+    create_offscreen_images(ctx);
+    create_image_views(ctx);
+    create_framebuffers(ctx);
 }
 
-void resize_window_callback(GLFWwindow* window, int width, int height);
+// below this many draws per worker a thread handoff costs more than it saves
+constexpr size_t DRAWS_PER_RECORDING_JOB = 256;
 
+// dynamic state and bindings shared by every draw of the main pass
 void
-resize_window_callback(GLFWwindow* window, int width, int height)
+bind_pass_state(context& ctx, vk::CommandBuffer command_buffer) noexcept
 {
-    if (width == 0 || height == 0) { return; }
+    vk::Viewport viewport(
+        0.f,
+        0.f,
+        static_cast<float>(ctx.extent.width),
+        static_cast<float>(ctx.extent.height),
+        0.f,
+        1.f);
+    command_buffer.setViewport(0, viewport);
 
-    auto pctx = reinterpret_cast<context*>(glfwGetWindowUserPointer(window));
+    vk::Rect2D scissor(vk::Offset2D(0, 0), ctx.extent);
+    command_buffer.setScissor(0, scissor);
 
-    recreate_swapchain(*pctx);
+    // every material and instance is reachable through the one set, per
+    // draw only the instance range changes
+    command_buffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eGraphics,
+        *ctx.pipeline_layout,
+        0,
+        ctx.bindless_set,
+        nullptr);
+
+    const vk::DeviceSize vertex_buffer_offset = 0;
+    command_buffer.bindVertexBuffers(
+        0, 1, &*ctx.vertex_buffer.handle, &vertex_buffer_offset);
+    command_buffer.bindIndexBuffer(
+        *ctx.index_buffer.handle, 0, vk::IndexType::eUint32);
+
+    command_buffer.pushConstants(
+        *ctx.pipeline_layout,
+        vk::ShaderStageFlagBits::eVertex,
+        0,
+        sizeof(ctx.view),
+        &ctx.view);
 }
 
-} // namespace
+void
+record_draws(
+    context&          ctx,
+    vk::CommandBuffer command_buffer,
+    size_t            begin,
+    size_t            end) noexcept
+{
+    bind_pass_state(ctx, command_buffer);
+
+    // consecutive draws of materials sharing a permutation bind it once
+    vk::Pipeline bound_pipeline;
+    for (auto i = begin; i != end; ++i) {
+        const auto& draw = ctx.draws[i];
+
+        const auto permutation = ctx.materials.permutation(draw.material);
+        const auto pipeline    = *ctx.material_pipelines[permutation];
+        if (pipeline != bound_pipeline) {
+            command_buffer.bindPipeline(
+                vk::PipelineBindPoint::eGraphics, pipeline);
+            bound_pipeline = pipeline;
+        }
+
+        command_buffer.drawIndexed(
+            draw.index_count,
+            draw.instance_count,
+            draw.first_index,
+            draw.vertex_offset,
+            draw.first_instance);
+    }
+}
 
+// one indirect draw per batch of the scene, reading what record_culling()
+// wrote for this frame
 void
-initialize(context& ctx, int width, int height) noexcept
+record_scene_draws(context& ctx, vk::CommandBuffer command_buffer) noexcept
 {
-    if (!ctx.window.create("Materialist", width, height)) {
-        ERROR("failed to create window");
+    const auto commands = *ctx.cull_commands[ctx.current_frame].handle;
+    const auto counts   = *ctx.cull_counts[ctx.current_frame].handle;
+
+    vk::Pipeline bound_pipeline;
+    for (uint32_t i = 0; i != ctx.scene.batches.size(); ++i) {
+        const auto& batch = ctx.scene.batches[i];
+
+        const auto permutation = ctx.materials.permutation(batch.material);
+        const auto pipeline    = *ctx.material_pipelines[permutation];
+        if (pipeline != bound_pipeline) {
+            command_buffer.bindPipeline(
+                vk::PipelineBindPoint::eGraphics, pipeline);
+            bound_pipeline = pipeline;
+        }
+
+        command_buffer.drawIndexedIndirectCountKHR(
+            commands,
+            vk::DeviceSize(batch.first_command) *
+                sizeof(vk::DrawIndexedIndirectCommand),
+            counts,
+            vk::DeviceSize(FIRST_BATCH_COUNT + i) * sizeof(uint32_t),
+            batch.capacity,
+            sizeof(vk::DrawIndexedIndirectCommand));
     }
+}
 
-    glfwSetWindowUserPointer(*ctx.window, &ctx);
-    (void)glfwSetFramebufferSizeCallback(*ctx.window, resize_window_callback);
+// culls the scene into this frame's command and count buffers; outside of
+// the render pass, before the draws reading them
+void
+record_culling(context& ctx, vk::CommandBuffer command_buffer) noexcept
+{
+    const auto counts = *ctx.cull_counts[ctx.current_frame].handle;
 
-    create_instance(ctx);
+    command_buffer.fillBuffer(counts, 0, VK_WHOLE_SIZE, 0);
 
-    VULKAN_HPP_DEFAULT_DISPATCHER.init(*ctx.instance);
+    vk::MemoryBarrier clear_barrier(
+        vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    command_buffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eComputeShader,
+        {},
+        clear_barrier,
+        nullptr,
+        nullptr);
 
-#ifndef NDEBUG
-    create_debug_utils_messenger_EXT(ctx);
-#endif // NDEBUG
+    const cull_constants constants{ctx.view, ctx.scene.object_count};
 
-    create_surface(ctx);
+    command_buffer.bindPipeline(
+        vk::PipelineBindPoint::eCompute, *ctx.cull_pipeline.pipeline);
+    command_buffer.bindDescriptorSets(
+        vk::PipelineBindPoint::eCompute,
+        *ctx.cull_pipeline.layout,
+        0,
+        ctx.scene.descriptor_sets[ctx.current_frame],
+        nullptr);
+    command_buffer.pushConstants(
+        *ctx.cull_pipeline.layout,
+        vk::ShaderStageFlagBits::eCompute,
+        0,
+        sizeof(constants),
+        &constants);
+    command_buffer.dispatch(
+        (ctx.scene.object_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    vk::MemoryBarrier cull_barrier(
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eIndirectCommandRead |
+            vk::AccessFlagBits::eTransferRead);
+    command_buffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eDrawIndirect |
+            vk::PipelineStageFlagBits::eTransfer,
+        {},
+        cull_barrier,
+        nullptr,
+        nullptr);
 
-    pick_physical_device(ctx);
+    profiler::record_counter(
+        ctx.gpu_profiler,
+        command_buffer,
+        "visible objects",
+        counts,
+        VISIBLE_COUNT * sizeof(uint32_t));
+    profiler::record_counter(
+        ctx.gpu_profiler,
+        command_buffer,
+        "culled objects",
+        counts,
+        CULLED_COUNT * sizeof(uint32_t));
+}
 
-    create_logical_device(ctx);
+vk::CommandBuffer
+acquire_secondary_buffer(context& ctx, worker_command_pool& wcp) noexcept
+{
+    if (wcp.used == wcp.buffers.size()) {
+        vk::CommandBufferAllocateInfo cbai(
+            *wcp.pool, vk::CommandBufferLevel::eSecondary, 1);
 
-    VULKAN_HPP_DEFAULT_DISPATCHER.init(*ctx.device);
+        auto [result, buffers] = ctx.device->allocateCommandBuffersUnique(cbai);
+        if (result != vk::Result::eSuccess) {
+            ERROR("failed to allocate secondary command buffer");
+        }
+        wcp.buffers.push_back(std::move(buffers.front()));
+    }
 
-    create_swapchain(ctx);
+    return *wcp.buffers[wcp.used++];
+}
 
-    create_image_views(ctx);
+// splits the draw list across the workers, each recording into secondary
+// buffers from its own pool; results land in ctx.secondary_buffers in draw
+// order
+void
+record_secondary_buffers(context& ctx, uint32_t image_index) noexcept
+{
+    auto& worker_pools = ctx.worker_pools[ctx.current_frame];
+    for (auto& wcp : worker_pools) {
+        if (ctx.device->resetCommandPool(*wcp.pool, {}) !=
+            vk::Result::eSuccess) {
+            ERROR("failed to reset worker command pool");
+        }
+        wcp.used = 0;
+    }
 
-    create_render_pass(ctx);
+    std::fill(
+        begin(ctx.worker_record_times),
+        end(ctx.worker_record_times),
+        std::chrono::nanoseconds::zero());
 
-    create_graphics_pipeline(ctx);
+    vk::CommandBufferInheritanceInfo inheritance(
+        *ctx.render_pass, 0, *ctx.framebuffers[image_index]);
 
-    create_framebuffers(ctx);
+    vk::CommandBufferBeginInfo cbbi(
+        vk::CommandBufferUsageFlagBits::eOneTimeSubmit |
+            vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+        &inheritance);
 
-    create_command_pool(ctx);
+    ctx.secondary_buffers.resize(
+        ctx.workers->chunk_count(ctx.draws.size(), DRAWS_PER_RECORDING_JOB));
 
-    create_command_buffers(ctx);
+    ctx.workers->parallel_for(
+        ctx.draws.size(),
+        DRAWS_PER_RECORDING_JOB,
+        [&ctx, &worker_pools, &cbbi](size_t worker, jobs::range r) {
+            TRACE_ZONE("record_draws");
 
-    create_sync_objects(ctx);
-}
+            const auto start = std::chrono::steady_clock::now();
 
-#ifndef NDEBUG
+            auto command_buffer =
+                acquire_secondary_buffer(ctx, worker_pools[worker]);
+            if (command_buffer.begin(cbbi) != vk::Result::eSuccess) {
+                ERROR("failed to begin recording secondary command buffer");
+            }
 
-void
-create_debug_utils_messenger_EXT(context& ctx) noexcept
-{
-    auto& instance = ctx.instance;
-    auto  dmci     = populate_debug_messenger_create_info();
-    auto [result, debug_messenger] =
-        instance->createDebugUtilsMessengerEXTUnique(dmci);
-    if (result != vk::Result::eSuccess) {
-        ERROR("failed to create debug-utils messenger");
-    }
+            record_draws(ctx, command_buffer, r.begin, r.end);
 
-    ctx.debug_messenger = std::move(debug_messenger);
+            if (command_buffer.end() != vk::Result::eSuccess) {
+                ERROR("failed to record secondary command buffer");
+            }
+
+            ctx.secondary_buffers[r.chunk] = command_buffer;
+            ctx.worker_record_times[worker] +=
+                std::chrono::steady_clock::now() - start;
+        });
+
+    // a handful of indirect draws, not worth a job
+    if (ctx.scene.object_count != 0) {
+        auto command_buffer = acquire_secondary_buffer(ctx, worker_pools[0]);
+        if (command_buffer.begin(cbbi) != vk::Result::eSuccess) {
+            ERROR("failed to begin recording secondary command buffer");
+        }
+
+        bind_pass_state(ctx, command_buffer);
+        record_scene_draws(ctx, command_buffer);
+
+        if (command_buffer.end() != vk::Result::eSuccess) {
+            ERROR("failed to record secondary command buffer");
+        }
+
+        ctx.secondary_buffers.push_back(command_buffer);
+    }
 }
 
-bool
-check_validation_layer_support() noexcept
+// resets the current frame's pools and records the frame into its primary
+// buffer; the caller must have waited for the frame's fence
+// `upload_waits` receives the semaphores of uploads first used by this frame;
+// the submission has to wait on them at staging::consumer_stages() and
+// signal frame_number + 1 on the timeline
+vk::CommandBuffer
+record_frame(
+    context&                    ctx,
+    uint32_t                    image_index,
+    std::vector<vk::Semaphore>& upload_waits) noexcept
 {
-    auto [result, available_layers] = vk::enumerateInstanceLayerProperties();
-    if (result != vk::Result::eSuccess) {
-        ERROR("failed to get instance layer properties count");
-    }
+    TRACE_ZONE("record_frame");
 
-    spdlog::debug("available validation layers:");
-    for (const auto& layer_properties : available_layers) {
-        spdlog::debug("\t{}", layer_properties.layerName);
+    if (ctx.device->resetCommandPool(
+            *ctx.command_pools[ctx.current_frame], {}) !=
+        vk::Result::eSuccess) {
+        ERROR("failed to reset command pool");
     }
-    spdlog::debug("");
 
-    for (const char* layer_name : g_validation_layers) {
-        bool layer_found = false;
+    const bool parallel =
+        ctx.workers->chunk_count(ctx.draws.size(), DRAWS_PER_RECORDING_JOB) >
+        1;
+    if (parallel) { record_secondary_buffers(ctx, image_index); }
 
-        for (const auto& layer_properties : available_layers) {
-            if (strcmp(layer_name, layer_properties.layerName) == 0) {
-                layer_found = true;
-                break;
-            }
-        }
+    auto command_buffer = *ctx.command_buffers[ctx.current_frame];
 
-        if (!layer_found) { return false; }
+    vk::CommandBufferBeginInfo cbbi(
+        vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+    if (command_buffer.begin(cbbi) != vk::Result::eSuccess) {
+        ERROR("failed to begin recording command buffer");
     }
 
-    return true;
-}
+    profiler::begin_frame(ctx.gpu_profiler, command_buffer, ctx.current_frame);
+    const auto frame_zone =
+        profiler::begin_zone(ctx.gpu_profiler, command_buffer, "frame");
 
-#endif // NDEBUG
+    staging::retire(ctx.staging);
+    upload_waits = staging::acquire(
+        ctx.staging, command_buffer, *ctx.timeline, ctx.frame_number + 1);
 
-void
+    if (ctx.scene.object_count != 0) {
+        const auto cull_zone =
+            profiler::begin_zone(ctx.gpu_profiler, command_buffer, "culling");
+        record_culling(ctx, command_buffer);
+        profiler::end_zone(ctx.gpu_profiler, command_buffer, cull_zone);
+    }
+
+    const auto pass_zone =
+        profiler::begin_zone(ctx.gpu_profiler, command_buffer, "main pass");
+
+    vk::ClearValue clear_color(std::array<float, 4>{0.f, 0.f, 0.f, 1.f});
+
+    vk::RenderPassBeginInfo render_pass_info(
+        *ctx.render_pass,
+        *ctx.framebuffers[image_index],
+        vk::Rect2D(vk::Offset2D(0, 0), ctx.extent),
+        1,
+        &clear_color);
+
+    if (parallel) {
+        command_buffer.beginRenderPass(
+            render_pass_info, vk::SubpassContents::eSecondaryCommandBuffers);
+        command_buffer.executeCommands(ctx.secondary_buffers);
+    } else {
+        command_buffer.beginRenderPass(
+            render_pass_info, vk::SubpassContents::eInline);
+        record_draws(ctx, command_buffer, 0, ctx.draws.size());
+        if (ctx.scene.object_count != 0) {
+            record_scene_draws(ctx, command_buffer);
+        }
+    }
+
+    command_buffer.endRenderPass();
+
+    profiler::end_zone(ctx.gpu_profiler, command_buffer, pass_zone);
+    profiler::end_zone(ctx.gpu_profiler, command_buffer, frame_zone);
+    profiler::end_frame(ctx.gpu_profiler);
+
+    if (command_buffer.end() != vk::Result::eSuccess) {
+        ERROR("failed to record command buffer");
+    }
+
+    return command_buffer;
+}
+
+std::optional<std::vector<char>>
+try_read_file(std::string_view filename) noexcept
+{
+    std::ifstream file(filename.data(), std::ios::ate | std::ios::binary);
+    if (!file) { return std::nullopt; }
+
+    const auto        file_size = file.tellg();
+    std::vector<char> buffer(file_size);
+    file.seekg(0);
+    file.read(buffer.data(), file_size);
+    file.close();
+
+    return buffer;
+}
+
+bool
+write_file(std::string_view filename, const void* data, size_t size) noexcept
+{
+    std::ofstream file(filename.data(), std::ios::binary | std::ios::trunc);
+    if (!file) { return false; }
+
+    file.write(
+        reinterpret_cast<const char*>(data),
+        gsl::narrow<std::streamsize>(size));
+
+    return static_cast<bool>(file);
+}
+
+// a cache blob is only usable by the exact driver/device that produced it,
+// see VkPipelineCacheHeaderVersionOne
+bool
+is_pipeline_cache_compatible(
+    const std::vector<char>&            data,
+    const vk::PhysicalDeviceProperties& properties) noexcept
+{
+    constexpr size_t header_size = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+    if (data.size() < header_size) { return false; }
+
+    std::array<uint32_t, 4> header;
+    std::memcpy(header.data(), data.data(), sizeof(header));
+
+    const auto [length, version, vendor_id, device_id] = header;
+
+    return length >= header_size &&
+           version ==
+               static_cast<uint32_t>(VK_PIPELINE_CACHE_HEADER_VERSION_ONE) &&
+           vendor_id == properties.vendorID &&
+           device_id == properties.deviceID &&
+           std::memcmp(
+               data.data() + sizeof(header),
+               &properties.pipelineCacheUUID[0],
+               VK_UUID_SIZE) == 0;
+}
+
+void resize_window_callback(GLFWwindow* window, int width, int height);
+
+void
+resize_window_callback(GLFWwindow* window, int width, int height)
+{
+    if (width == 0 || height == 0) { return; }
+
+    auto pctx = reinterpret_cast<context*>(glfwGetWindowUserPointer(window));
+
+    recreate_swapchain(*pctx);
+}
+
+} // namespace
+
+void
+initialize(context& ctx, int width, int height) noexcept
+{
+    TRACE_ZONE("vulkan::initialize");
+
+    if (!ctx.headless) {
+        if (!ctx.window.create("Materialist", width, height)) {
+            ERROR("failed to create window");
+        }
+
+        glfwSetWindowUserPointer(*ctx.window, &ctx);
+        (void)glfwSetFramebufferSizeCallback(
+            *ctx.window, resize_window_callback);
+    }
+
+    create_instance(ctx);
+
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(*ctx.instance);
+
+#ifndef NDEBUG
+    create_debug_utils_messenger_EXT(ctx);
+#endif // NDEBUG
+
+    if (!ctx.headless) { create_surface(ctx); }
+
+    pick_physical_device(ctx);
+
+    create_logical_device(ctx);
+
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(*ctx.device);
+
+    create_allocator(ctx);
+
+    create_pipeline_cache(ctx);
+
+    if (ctx.headless) {
+        ctx.format = g_offscreen_format;
+        ctx.extent = vk::Extent2D(
+            gsl::narrow<uint32_t>(width), gsl::narrow<uint32_t>(height));
+        create_offscreen_images(ctx);
+    } else {
+        create_swapchain(ctx);
+    }
+
+    create_image_views(ctx);
+
+    create_render_pass(ctx);
+
+    create_framebuffers(ctx);
+
+    create_workers(ctx);
+
+    create_command_pools(ctx);
+
+    create_command_buffers(ctx);
+
+    create_profiler(ctx);
+
+    create_geometry_buffers(ctx);
+
+    create_staging_ring(ctx);
+
+    create_bindless_resources(ctx);
+
+    create_culling_resources(ctx);
+
+    add_material(
+        ctx, "default", material::feature_set(), material::parameters());
+
+    create_graphics_pipeline(ctx);
+
+    // instance 0 draws meshes as they are, with the default material
+    add_instances(ctx, std::array{swatch::instance()});
+
+    const auto triangle =
+        add_mesh(ctx, g_triangle_vertices, g_triangle_indices);
+    ctx.draws.push_back(
+        {triangle.index_count,
+         1,
+         triangle.first_index,
+         triangle.vertex_offset,
+         0});
+    staging::flush(ctx.staging);
+
+    create_sync_objects(ctx);
+}
+
+#ifndef NDEBUG
+
+void
+create_debug_utils_messenger_EXT(context& ctx) noexcept
+{
+    TRACE_ZONE("create_debug_utils_messenger_EXT");
+
+    auto& instance = ctx.instance;
+    auto  dmci     = populate_debug_messenger_create_info();
+    auto [result, debug_messenger] =
+        instance->createDebugUtilsMessengerEXTUnique(dmci);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create debug-utils messenger");
+    }
+
+    ctx.debug_messenger = std::move(debug_messenger);
+}
+
+bool
+check_validation_layer_support() noexcept
+{
+    auto [result, available_layers] = vk::enumerateInstanceLayerProperties();
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to get instance layer properties count");
+    }
+
+    spdlog::debug("available validation layers:");
+    for (const auto& layer_properties : available_layers) {
+        spdlog::debug("\t{}", layer_properties.layerName);
+    }
+    spdlog::debug("");
+
+    for (const char* layer_name : g_validation_layers) {
+        bool layer_found = false;
+
+        for (const auto& layer_properties : available_layers) {
+            if (strcmp(layer_name, layer_properties.layerName) == 0) {
+                layer_found = true;
+                break;
+            }
+        }
+
+        if (!layer_found) { return false; }
+    }
+
+    return true;
+}
+
+#endif // NDEBUG
+
+void
 create_instance(context& ctx) noexcept
 {
+    TRACE_ZONE("create_instance");
+
 #ifndef NDEBUG
     if (!check_validation_layer_support()) {
         ERROR("validation layers requested, but not available!");
@@ -451,7 +1336,7 @@ create_instance(context& ctx) noexcept
     vk::ApplicationInfo app_info(
         "Materialist", 1, "No-engine", 1, VK_MAKE_VERSION(1, 1, 0));
 
-    const auto extensions = get_required_extensions();
+    const auto extensions = get_required_extensions(ctx.headless);
 
     vk::InstanceCreateInfo create_info(
         {},
@@ -497,6 +1382,8 @@ create_instance(context& ctx) noexcept
 void
 create_surface(context& ctx) noexcept
 {
+    TRACE_ZONE("create_surface");
+
     VkSurfaceKHR surface_tmp;
     if (glfwCreateWindowSurface(
             *ctx.instance, *ctx.window, nullptr, &surface_tmp) != VK_SUCCESS) {
@@ -508,58 +1395,99 @@ create_surface(context& ctx) noexcept
     ctx.surface = std::move(surface);
 }
 
+namespace /* anonymous */ {
+
+// KTX2 files in any other format are decoded to RGBA8, which every device
+// samples, or rejected when there is no decoder for them
+void
+query_texture_formats(context& ctx) noexcept
+{
+    const auto features = vk::FormatFeatureFlagBits::eSampledImage |
+                          vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+    std::vector<uint32_t> candidates = {
+        ktx2::R8G8B8A8_UNORM, ktx2::R8G8B8A8_SRGB};
+    for (auto f = ktx2::BC1_RGB_UNORM; f <= ktx2::BC7_SRGB; ++f) {
+        candidates.push_back(f);
+    }
+    for (auto f = ktx2::ASTC_4x4_UNORM; f <= ktx2::ASTC_12x12_SRGB; ++f) {
+        candidates.push_back(f);
+    }
+
+    for (auto candidate : candidates) {
+        const auto format = vk::Format(candidate);
+        const auto properties =
+            ctx.physical_device.getFormatProperties(format);
+        if ((properties.optimalTilingFeatures & features) == features) {
+            ctx.sampled_formats.insert(format);
+        }
+    }
+
+    spdlog::info(
+        "textures: BC7 {}, ASTC 4x4 {}",
+        ctx.sampled_formats.count(vk::Format::eBc7SrgbBlock) != 0 ?
+            "sampled" :
+            "decoded",
+        ctx.sampled_formats.count(vk::Format::eAstc4x4SrgbBlock) != 0 ?
+            "sampled" :
+            "unsupported");
+}
+
+} // namespace
+
 void
 pick_physical_device(context& ctx) noexcept
 {
+    TRACE_ZONE("pick_physical_device");
+
     vk::PhysicalDevice physical_device;
     auto [result, devices] = ctx.instance->enumeratePhysicalDevices();
     if (result != vk::Result::eSuccess) {
         ERROR("failed to find GPUs with Vulkan support");
     }
 
-    auto right_device = [&ctx](const auto& device) {
-        return is_device_suitable(device, *ctx.surface);
-    };
+    int best_rank = -1;
+    for (const auto& device : devices) {
+        if (!is_device_suitable(device, *ctx.surface)) { continue; }
 
-    auto suitable_it = std::find_if(begin(devices), end(devices), right_device);
-    if (suitable_it != end(devices)) { physical_device = *suitable_it; }
+        const auto properties = device.getProperties();
+        const auto rank       = device_type_rank(properties.deviceType);
+        if (rank > best_rank) {
+            best_rank       = rank;
+            physical_device = device;
+        }
+    }
 
     if (!physical_device) { ERROR("failed to find suitable GPU"); }
 
+    spdlog::info(
+        "using {} ({})",
+        physical_device.getProperties().deviceName,
+        vk::to_string(physical_device.getProperties().deviceType));
+
     ctx.physical_device = physical_device;
+
+    query_texture_formats(ctx);
 }
 
 void
 create_logical_device(context& ctx) noexcept
 {
-    auto queue_family_properties =
-        ctx.physical_device.getQueueFamilyProperties();
-    auto graphics_queue_family_index = gsl::narrow<uint32_t>(std::distance(
-        begin(queue_family_properties),
-        std::find_if(
-            begin(queue_family_properties),
-            end(queue_family_properties),
-            [](const auto& qfp) {
-                return qfp.queueFlags & vk::QueueFlagBits::eGraphics;
-            })));
-
-    auto [spmresult, present_modes] =
-        ctx.physical_device.getSurfacePresentModesKHR(*ctx.surface);
-    if (spmresult != vk::Result::eSuccess) {
-        ERROR("failed to get surface present modes");
-    }
+    TRACE_ZONE("create_logical_device");
 
-    auto present_queue_family_index =
-        gsl::narrow<uint32_t>(present_modes.size()) <
-                graphics_queue_family_index ?
-            graphics_queue_family_index :
-            0u;
+    const auto indices = find_queue_families(ctx.physical_device, *ctx.surface);
+    const auto graphics_queue_family_index = *indices.graphics_family;
+    const auto present_queue_family_index  = *indices.present_family;
+    const auto transfer_queue_family_index = *indices.transfer_family;
+    const auto compute_queue_family_index  = *indices.compute_family;
 
     std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
-    queue_create_infos.reserve(2);
+    queue_create_infos.reserve(4);
 
     std::set<uint32_t> unique_queue_families = {graphics_queue_family_index,
-                                                present_queue_family_index};
+                                                present_queue_family_index,
+                                                transfer_queue_family_index,
+                                                compute_queue_family_index};
 
     float queue_priority = 1.0f;
     for (uint32_t queue_family : unique_queue_families) {
@@ -569,6 +1497,19 @@ create_logical_device(context& ctx) noexcept
     }
 
     vk::PhysicalDeviceFeatures device_features;
+    device_features.multiDrawIndirect         = VK_TRUE;
+    device_features.drawIndirectFirstInstance = VK_TRUE;
+
+    vk::PhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features;
+    indexing_features.shaderSampledImageArrayNonUniformIndexing    = VK_TRUE;
+    indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexing_features.descriptorBindingPartiallyBound              = VK_TRUE;
+    indexing_features.runtimeDescriptorArray                       = VK_TRUE;
+
+    vk::PhysicalDeviceTimelineSemaphoreFeatures timeline_features(VK_TRUE);
+    timeline_features.setPNext(&indexing_features);
+
+    const auto extensions = get_required_device_extensions(ctx.headless);
 
     vk::DeviceCreateInfo create_info(
         {},
@@ -581,93 +1522,1160 @@ create_logical_device(context& ctx) noexcept
         0,
         nullptr,
 #endif // NDEBUG
-        gsl::narrow<uint32_t>(g_device_extensions.size()),
-        g_device_extensions.data());
+        gsl::narrow<uint32_t>(extensions.size()),
+        extensions.data());
+
+    create_info.setPEnabledFeatures(&device_features);
+    create_info.setPNext(&timeline_features);
+
+    auto [result, device] = ctx.physical_device.createDeviceUnique(create_info);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create logical device!");
+    }
+
+    auto graphics_queue = device->getQueue(graphics_queue_family_index, 0);
+    auto present_queue  = device->getQueue(present_queue_family_index, 0);
+    auto transfer_queue = device->getQueue(transfer_queue_family_index, 0);
+    auto compute_queue  = device->getQueue(compute_queue_family_index, 0);
+    ctx.device          = std::move(device);
+    ctx.graphics_queue  = std::move(graphics_queue);
+    ctx.present_queue   = std::move(present_queue);
+    ctx.transfer_queue  = std::move(transfer_queue);
+    ctx.compute_queue   = std::move(compute_queue);
+
+    if (transfer_queue_family_index != graphics_queue_family_index) {
+        spdlog::info(
+            "uploads run on dedicated transfer queue family {}",
+            transfer_queue_family_index);
+    }
+    if (compute_queue_family_index != graphics_queue_family_index) {
+        spdlog::info(
+            "compute work runs on async compute queue family {}",
+            compute_queue_family_index);
+    }
+}
+
+void
+create_pipeline_cache(context& ctx) noexcept
+{
+    TRACE_ZONE("create_pipeline_cache");
+
+    const auto properties = ctx.physical_device.getProperties();
+
+    auto data = try_read_file(ctx.pipeline_cache_path);
+    if (!data) {
+        spdlog::info(
+            "pipeline cache miss: {} not found", ctx.pipeline_cache_path);
+    } else if (!is_pipeline_cache_compatible(*data, properties)) {
+        spdlog::info(
+            "pipeline cache miss: {} was created by another device or driver",
+            ctx.pipeline_cache_path);
+        data->clear();
+    } else {
+        spdlog::info(
+            "pipeline cache hit: {} bytes loaded from {}",
+            data->size(),
+            ctx.pipeline_cache_path);
+    }
+
+    vk::PipelineCacheCreateInfo pcci(
+        {}, data ? data->size() : 0, data ? data->data() : nullptr);
+
+    auto [result, pipeline_cache] = ctx.device->createPipelineCacheUnique(pcci);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create pipeline cache");
+    }
+
+    ctx.pipeline_cache = std::move(pipeline_cache);
+}
+
+void
+save_pipeline_cache(context& ctx) noexcept
+{
+    auto [result, data] =
+        ctx.device->getPipelineCacheData(*ctx.pipeline_cache);
+    if (result != vk::Result::eSuccess) {
+        spdlog::warn("failed to get pipeline cache data");
+        return;
+    }
+
+    if (!write_file(ctx.pipeline_cache_path, data.data(), data.size())) {
+        spdlog::warn(
+            "failed to write pipeline cache to {}", ctx.pipeline_cache_path);
+        return;
+    }
+
+    spdlog::debug(
+        "pipeline cache: {} bytes written to {}",
+        data.size(),
+        ctx.pipeline_cache_path);
+}
+
+void
+create_swapchain(context& ctx) noexcept
+{
+    TRACE_ZONE("create_swapchain");
+
+    auto swapchain_support =
+        query_swapchain_support(ctx.physical_device, *ctx.surface);
+
+    auto surface_format = choose_swap_surface_format(swapchain_support.formats);
+    auto present_mode = choose_swap_present_mode(
+        swapchain_support.present_modes, ctx.present);
+    auto extent =
+        choose_swap_extent(*ctx.window, swapchain_support.capabilities);
+    auto image_count = choose_swap_image_count(
+        swapchain_support.capabilities,
+        ctx.present,
+        ctx.swapchain_image_count);
+
+    auto      sharing_mode             = vk::SharingMode::eExclusive;
+    auto      queue_family_index_count = 0;
+    uint32_t* queue_family_indices_ptr = nullptr;
+    auto      indices = find_queue_families(ctx.physical_device, *ctx.surface);
+    auto      q_family_indices =
+        std::array{*indices.graphics_family, *indices.present_family};
+
+    if (*indices.graphics_family != *indices.present_family) {
+        sharing_mode             = vk::SharingMode::eConcurrent;
+        queue_family_index_count = 2;
+        queue_family_indices_ptr = q_family_indices.data();
+    } else {
+        sharing_mode = vk::SharingMode::eExclusive;
+    }
+
+    vk::SwapchainCreateInfoKHR create_info(
+        {},
+        *ctx.surface,
+        image_count,
+        surface_format.format,
+        surface_format.colorSpace,
+        extent,
+        1,
+        vk::ImageUsageFlagBits::eColorAttachment,
+        sharing_mode,
+        queue_family_index_count,
+        queue_family_indices_ptr,
+        swapchain_support.capabilities.currentTransform,
+        vk::CompositeAlphaFlagBitsKHR::eOpaque,
+        present_mode,
+        true,
+        *ctx.swapchain);
+
+    auto [csresult, swapchain] =
+        ctx.device->createSwapchainKHRUnique(create_info);
+    if (csresult != vk::Result::eSuccess) {
+        ERROR("failed to create swapchain");
+    }
+    auto [gsiresult, images] = ctx.device->getSwapchainImagesKHR(*swapchain);
+    if (gsiresult != vk::Result::eSuccess) {
+        ERROR("failed to get swapchain images");
+    }
+
+    // the old swapchain was handed over as oldSwapchain but its images may
+    // still be in flight
+    defer_destroy(ctx, std::exchange(ctx.swapchain, std::move(swapchain)));
+    ctx.images = std::move(images);
+    ctx.format = surface_format.format;
+    ctx.extent = extent;
+
+    spdlog::info(
+        "swapchain: {} images, {} present mode",
+        ctx.images.size(),
+        vk::to_string(present_mode));
+}
+
+void
+create_allocator(context& ctx) noexcept
+{
+    TRACE_ZONE("create_allocator");
+
+    memory::initialize(ctx.allocator, ctx.physical_device, *ctx.device);
+}
+
+buffer
+create_buffer(
+    context&                ctx,
+    vk::DeviceSize          size,
+    vk::BufferUsageFlags    usage,
+    vk::MemoryPropertyFlags properties,
+    memory::strategy        strategy) noexcept
+{
+    auto& device = *ctx.device;
+
+    vk::BufferCreateInfo bci({}, size, usage, vk::SharingMode::eExclusive);
+
+    auto [result, handle] = device.createBufferUnique(bci);
+    if (result != vk::Result::eSuccess) { ERROR("failed to create buffer"); }
+
+    auto requirements = device.getBufferMemoryRequirements2<
+        vk::MemoryRequirements2,
+        vk::MemoryDedicatedRequirements>(
+        vk::BufferMemoryRequirementsInfo2(*handle));
+    const auto& dedicated = requirements.get<vk::MemoryDedicatedRequirements>();
+
+    vk::MemoryDedicatedAllocateInfo mdai(vk::Image(), *handle);
+
+    buffer buf;
+    buf.allocation = memory::allocate(
+        ctx.allocator,
+        requirements.get<vk::MemoryRequirements2>().memoryRequirements,
+        properties,
+        strategy,
+        memory::resource_kind::buffer,
+        dedicated.requiresDedicatedAllocation ? &mdai : nullptr);
+
+    if (device.bindBufferMemory(
+            *handle, buf.allocation.memory, buf.allocation.offset) !=
+        vk::Result::eSuccess) {
+        ERROR("failed to bind buffer memory");
+    }
+    buf.handle = std::move(handle);
+
+    return buf;
+}
+
+// images the driver would rather have on their own (typically render
+// targets) and large ones get dedicated allocations, the rest is pooled
+image
+create_image(
+    context&                   ctx,
+    const vk::ImageCreateInfo& ici,
+    vk::MemoryPropertyFlags    properties) noexcept
+{
+    auto& device = *ctx.device;
+
+    auto [result, handle] = device.createImageUnique(ici);
+    if (result != vk::Result::eSuccess) { ERROR("failed to create image"); }
+
+    auto requirements = device.getImageMemoryRequirements2<
+        vk::MemoryRequirements2,
+        vk::MemoryDedicatedRequirements>(
+        vk::ImageMemoryRequirementsInfo2(*handle));
+    const auto& dedicated = requirements.get<vk::MemoryDedicatedRequirements>();
+
+    vk::MemoryDedicatedAllocateInfo mdai(*handle, vk::Buffer());
+
+    image img;
+    img.allocation = memory::allocate(
+        ctx.allocator,
+        requirements.get<vk::MemoryRequirements2>().memoryRequirements,
+        properties,
+        memory::strategy::buddy,
+        memory::resource_kind::image,
+        dedicated.prefersDedicatedAllocation ||
+                dedicated.requiresDedicatedAllocation ?
+            &mdai :
+            nullptr);
+
+    if (device.bindImageMemory(
+            *handle, img.allocation.memory, img.allocation.offset) !=
+        vk::Result::eSuccess) {
+        ERROR("failed to bind image memory");
+    }
+    img.handle = std::move(handle);
+
+    return img;
+}
+
+void
+create_offscreen_images(context& ctx) noexcept
+{
+    TRACE_ZONE("create_offscreen_images");
+
+    std::vector<image>     offscreen_images;
+    std::vector<vk::Image> images;
+    offscreen_images.reserve(ctx.frames_in_flight);
+    images.reserve(ctx.frames_in_flight);
+
+    // one color target per frame in flight, so frames never wait on each
+    // other's image
+    for (size_t i = 0; i != ctx.frames_in_flight; ++i) {
+        vk::ImageCreateInfo ici(
+            {},
+            vk::ImageType::e2D,
+            ctx.format,
+            vk::Extent3D(ctx.extent.width, ctx.extent.height, 1),
+            1,
+            1,
+            vk::SampleCountFlagBits::e1,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eColorAttachment |
+                vk::ImageUsageFlagBits::eTransferSrc,
+            vk::SharingMode::eExclusive,
+            0,
+            nullptr,
+            vk::ImageLayout::eUndefined);
+
+        auto img = create_image(
+            ctx, ici, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+        images.push_back(*img.handle);
+        offscreen_images.push_back(std::move(img));
+    }
+
+    defer_destroy(
+        ctx, std::exchange(ctx.offscreen_images, std::move(offscreen_images)));
+    ctx.images = std::move(images);
+}
+
+void
+create_profiler(context& ctx) noexcept
+{
+    TRACE_ZONE("create_profiler");
+
+    const auto indices = find_queue_families(ctx.physical_device, *ctx.surface);
+
+    const auto properties = ctx.physical_device.getProperties();
+    const auto families   = ctx.physical_device.getQueueFamilyProperties();
+
+    ctx.profiler_counters = create_buffer(
+        ctx,
+        vk::DeviceSize(ctx.frames_in_flight) *
+            ctx.gpu_profiler.max_counters * sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+        memory::strategy::linear);
+
+    profiler::initialize(
+        ctx.gpu_profiler,
+        *ctx.device,
+        ctx.frames_in_flight,
+        properties.limits.timestampPeriod,
+        families[*indices.graphics_family].timestampValidBits,
+        *ctx.profiler_counters.handle,
+        ctx.profiler_counters.allocation.mapped);
+}
+
+void
+create_geometry_buffers(context& ctx) noexcept
+{
+    TRACE_ZONE("create_geometry_buffers");
+
+    ctx.vertex_buffer = create_buffer(
+        ctx,
+        vk::DeviceSize(ctx.vertex_capacity) * sizeof(mesh_file::vertex),
+        vk::BufferUsageFlagBits::eVertexBuffer |
+            vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        memory::strategy::buddy);
+
+    ctx.index_buffer = create_buffer(
+        ctx,
+        vk::DeviceSize(ctx.index_capacity) * sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eIndexBuffer |
+            vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        memory::strategy::buddy);
+}
+
+void
+create_staging_ring(context& ctx) noexcept
+{
+    TRACE_ZONE("create_staging_ring");
+
+    ctx.staging_buffer = create_buffer(
+        ctx,
+        ctx.staging_capacity,
+        vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible |
+            vk::MemoryPropertyFlagBits::eHostCoherent,
+        memory::strategy::linear);
+
+    const auto indices = find_queue_families(ctx.physical_device, *ctx.surface);
+
+    staging::initialize(
+        ctx.staging,
+        *ctx.device,
+        ctx.transfer_queue,
+        *indices.transfer_family,
+        *indices.graphics_family,
+        *ctx.staging_buffer.handle,
+        ctx.staging_buffer.allocation.mapped,
+        ctx.staging_capacity);
+}
+
+void
+create_bindless_resources(context& ctx) noexcept
+{
+    TRACE_ZONE("create_bindless_resources");
+
+    auto& device = *ctx.device;
+
+    const auto properties = ctx.physical_device.getProperties2<
+        vk::PhysicalDeviceProperties2,
+        vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+    const auto& indexing =
+        properties.get<vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+    ctx.texture_capacity = std::min(
+        {ctx.texture_capacity,
+         indexing.maxDescriptorSetUpdateAfterBindSampledImages,
+         indexing.maxPerStageDescriptorUpdateAfterBindSampledImages});
+
+    ctx.material_buffer = create_buffer(
+        ctx,
+        vk::DeviceSize(ctx.material_capacity) * sizeof(material::parameters),
+        vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        memory::strategy::buddy);
+
+    ctx.instance_buffer = create_buffer(
+        ctx,
+        vk::DeviceSize(ctx.instance_capacity) * sizeof(swatch::instance),
+        vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        memory::strategy::buddy);
+
+    vk::SamplerCreateInfo sci(
+        {},
+        vk::Filter::eLinear,
+        vk::Filter::eLinear,
+        vk::SamplerMipmapMode::eLinear,
+        vk::SamplerAddressMode::eRepeat,
+        vk::SamplerAddressMode::eRepeat,
+        vk::SamplerAddressMode::eRepeat,
+        0.f,
+        VK_FALSE,
+        1.f,
+        VK_FALSE,
+        vk::CompareOp::eNever,
+        0.f,
+        VK_LOD_CLAMP_NONE);
+
+    auto [sresult, sampler] = device.createSamplerUnique(sci);
+    if (sresult != vk::Result::eSuccess) { ERROR("failed to create sampler"); }
+    ctx.sampler = std::move(sampler);
+
+    const auto bindings = std::array{
+        vk::DescriptorSetLayoutBinding(
+            0,
+            vk::DescriptorType::eStorageBuffer,
+            1,
+            vk::ShaderStageFlagBits::eFragment),
+        vk::DescriptorSetLayoutBinding(
+            1,
+            vk::DescriptorType::eCombinedImageSampler,
+            ctx.texture_capacity,
+            vk::ShaderStageFlagBits::eFragment),
+        vk::DescriptorSetLayoutBinding(
+            2,
+            vk::DescriptorType::eStorageBuffer,
+            1,
+            vk::ShaderStageFlagBits::eVertex)};
+
+    // texture slots are filled as textures arrive, while frames using the
+    // set are in flight
+    const auto binding_flags = std::array{
+        vk::DescriptorBindingFlagsEXT(),
+        vk::DescriptorBindingFlagsEXT(
+            vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind |
+            vk::DescriptorBindingFlagBitsEXT::ePartiallyBound),
+        vk::DescriptorBindingFlagsEXT()};
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT dslbfci(
+        gsl::narrow<uint32_t>(binding_flags.size()), binding_flags.data());
+
+    vk::DescriptorSetLayoutCreateInfo dslci(
+        vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT,
+        gsl::narrow<uint32_t>(bindings.size()),
+        bindings.data());
+    dslci.setPNext(&dslbfci);
+
+    auto [dslresult, set_layout] =
+        device.createDescriptorSetLayoutUnique(dslci);
+    if (dslresult != vk::Result::eSuccess) {
+        ERROR("failed to create bindless descriptor set layout");
+    }
+    ctx.bindless_set_layout = std::move(set_layout);
+
+    const auto pool_sizes = std::array{
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, 2),
+        vk::DescriptorPoolSize(
+            vk::DescriptorType::eCombinedImageSampler, ctx.texture_capacity)};
+
+    vk::DescriptorPoolCreateInfo dpci(
+        vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT,
+        1,
+        gsl::narrow<uint32_t>(pool_sizes.size()),
+        pool_sizes.data());
+
+    auto [dpresult, descriptor_pool] = device.createDescriptorPoolUnique(dpci);
+    if (dpresult != vk::Result::eSuccess) {
+        ERROR("failed to create bindless descriptor pool");
+    }
+    ctx.bindless_pool = std::move(descriptor_pool);
+
+    vk::DescriptorSetAllocateInfo dsai(
+        *ctx.bindless_pool, 1, &*ctx.bindless_set_layout);
+    auto [dsresult, descriptor_sets] = device.allocateDescriptorSets(dsai);
+    if (dsresult != vk::Result::eSuccess) {
+        ERROR("failed to allocate bindless descriptor set");
+    }
+    ctx.bindless_set = descriptor_sets.front();
+
+    vk::DescriptorBufferInfo material_info(
+        *ctx.material_buffer.handle, 0, VK_WHOLE_SIZE);
+    vk::DescriptorBufferInfo instance_info(
+        *ctx.instance_buffer.handle, 0, VK_WHOLE_SIZE);
+    const auto writes = std::array{
+        vk::WriteDescriptorSet(
+            ctx.bindless_set,
+            0,
+            0,
+            1,
+            vk::DescriptorType::eStorageBuffer,
+            nullptr,
+            &material_info),
+        vk::WriteDescriptorSet(
+            ctx.bindless_set,
+            2,
+            0,
+            1,
+            vk::DescriptorType::eStorageBuffer,
+            nullptr,
+            &instance_info)};
+    device.updateDescriptorSets(writes, nullptr);
+
+    spdlog::debug(
+        "bindless: {} materials, {} textures, {} instances",
+        ctx.material_capacity,
+        ctx.texture_capacity,
+        ctx.instance_capacity);
+}
+
+// puts `view` (in shader read-only layout) into the next free slot of the
+// texture array, sampled with the shared sampler; returns the slot for
+// material::parameters
+uint32_t
+add_texture(context& ctx, vk::ImageView view) noexcept
+{
+    if (ctx.texture_count == ctx.texture_capacity) {
+        ERROR("bindless texture array is full");
+    }
+
+    const auto slot = ctx.texture_count++;
+
+    vk::DescriptorImageInfo image_info(
+        *ctx.sampler, view, vk::ImageLayout::eShaderReadOnlyOptimal);
+    vk::WriteDescriptorSet write(
+        ctx.bindless_set,
+        1,
+        slot,
+        1,
+        vk::DescriptorType::eCombinedImageSampler,
+        &image_info);
+    ctx.device->updateDescriptorSets(write, nullptr);
+
+    return slot;
+}
+
+// parses a KTX2 file and picks how to upload it: as is when the device
+// samples its format, decoded to RGBA8 when it doesn't and bcn has a
+// decoder for it; nullopt, with a warning naming `name`, otherwise. Only
+// reads the context, so any thread may call it
+std::optional<texture_data>
+read_texture(
+    const context&   ctx,
+    const std::byte* file,
+    size_t           size,
+    std::string_view name) noexcept
+{
+    TRACE_ZONE("read_texture");
+
+    const auto t = ktx2::parse(file, size);
+    if (!t) {
+        spdlog::warn("{} is not a 2D KTX2 texture", name);
+        return std::nullopt;
+    }
+
+    // BasisLZ and UASTC payloads would need a Basis Universal transcoder,
+    // Zstandard and zlib ones an inflater first
+    if (t->format == ktx2::FORMAT_UNDEFINED) {
+        spdlog::warn("{}: Basis Universal textures are not supported", name);
+        return std::nullopt;
+    }
+    if (t->supercompression != ktx2::SUPERCOMPRESSION_NONE) {
+        spdlog::warn(
+            "{}: supercompressed KTX2 textures (scheme {}) are not supported",
+            name,
+            t->supercompression);
+        return std::nullopt;
+    }
+
+    const auto block = ktx2::shape(t->format);
+    if (!block) {
+        spdlog::warn(
+            "{}: {} textures are not supported",
+            name,
+            vk::to_string(vk::Format(t->format)));
+        return std::nullopt;
+    }
+
+    texture_data data;
+    data.width  = t->width;
+    data.height = t->height;
+
+    if (ctx.sampled_formats.count(vk::Format(t->format)) != 0) {
+        data.format       = vk::Format(t->format);
+        data.block_height = block->height;
+        data.levels       = t->levels;
+        return data;
+    }
+
+    const auto decodable = ktx2::decodable(t->format);
+    if (!decodable) {
+        spdlog::warn(
+            "{}: the device can't sample {} textures",
+            name,
+            vk::to_string(vk::Format(t->format)));
+        return std::nullopt;
+    }
+
+    TRACE_ZONE("decode texture");
+
+    data.format = ktx2::is_srgb(t->format) ? vk::Format::eR8G8B8A8Srgb :
+                                             vk::Format::eR8G8B8A8Unorm;
+    data.decoded.resize(t->levels.size());
+    for (size_t i = 0; i != t->levels.size(); ++i) {
+        const auto& level = t->levels[i];
+        auto&       rgba  = data.decoded[i];
+
+        // parse() checked the level sizes already
+        bcn::decode_image(
+            *decodable,
+            level.data,
+            level.size,
+            level.width,
+            level.height,
+            rgba);
+        data.levels.push_back(
+            {reinterpret_cast<const std::byte*>(rgba.data()),
+             rgba.size(),
+             level.width,
+             level.height});
+    }
+    return data;
+}
+
+// creates a device-local image for the mip chain, queues every level on
+// the staging ring and puts the image into the bindless texture array;
+// returns its slot. Sampling it is safe once the copies are flushed and
+// the frame acquiring them retired, see on_frames_retired()
+uint32_t
+upload_texture(context& ctx, const texture_data& data) noexcept
+{
+    TRACE_ZONE("upload_texture");
+
+    const auto levels = gsl::narrow<uint32_t>(data.levels.size());
+
+    vk::ImageCreateInfo ici(
+        {},
+        vk::ImageType::e2D,
+        data.format,
+        vk::Extent3D(data.width, data.height, 1),
+        levels,
+        1,
+        vk::SampleCountFlagBits::e1,
+        vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eSampled |
+            vk::ImageUsageFlagBits::eTransferDst,
+        vk::SharingMode::eExclusive,
+        0,
+        nullptr,
+        vk::ImageLayout::eUndefined);
+
+    texture t;
+    t.storage =
+        create_image(ctx, ici, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+    for (uint32_t i = 0; i != levels; ++i) {
+        const auto& level = data.levels[i];
+        staging::upload_image(
+            ctx.staging,
+            *t.storage.handle,
+            i,
+            vk::Extent2D(level.width, level.height),
+            data.block_height,
+            level.data,
+            level.size);
+    }
+
+    vk::ImageViewCreateInfo ivci(
+        {},
+        *t.storage.handle,
+        vk::ImageViewType::e2D,
+        data.format,
+        vk::ComponentMapping(),
+        vk::ImageSubresourceRange(
+            vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1));
+
+    auto [result, view] = ctx.device->createImageViewUnique(ivci);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create texture view");
+    }
+    t.view = std::move(view);
+
+    const auto slot = add_texture(ctx, *t.view);
+    ctx.texture_bytes += t.storage.allocation.size;
+    ctx.textures.push_back(std::move(t));
+
+    return slot;
+}
+
+// maps a KTX2 file and uploads it with upload_texture(); the copies go out
+// with the next staging::flush()
+std::optional<uint32_t>
+load_texture(context& ctx, const std::string& path) noexcept
+{
+    TRACE_ZONE("load_texture");
+
+    const auto file = mesh_file::mapped_file::open(path);
+    if (!file) { return std::nullopt; }
+
+    const auto data = read_texture(ctx, file->data(), file->size(), path);
+    if (!data) { return std::nullopt; }
+
+    return upload_texture(ctx, *data);
+}
+
+// appends packed vertices and their indices to the shared geometry buffers
+// through the staging ring; the copies go out with the next
+// staging::flush()
+mesh_range
+add_packed_mesh(
+    context&                           ctx,
+    gsl::span<const mesh_file::vertex> vertices,
+    gsl::span<const uint32_t>          indices,
+    float                              radius) noexcept
+{
+    const auto vertex_count = gsl::narrow<uint32_t>(vertices.size());
+    const auto index_count  = gsl::narrow<uint32_t>(indices.size());
+
+    if (ctx.vertex_capacity - ctx.vertex_count < vertex_count ||
+        ctx.index_capacity - ctx.index_count < index_count) {
+        ERROR("geometry buffers are full");
+    }
+
+    const mesh_range range{
+        ctx.index_count,
+        index_count,
+        gsl::narrow<int32_t>(ctx.vertex_count),
+        radius};
+
+    staging::upload(
+        ctx.staging,
+        *ctx.vertex_buffer.handle,
+        vk::DeviceSize(ctx.vertex_count) * sizeof(mesh_file::vertex),
+        vertices.data(),
+        vertices.size_bytes());
+
+    staging::upload(
+        ctx.staging,
+        *ctx.index_buffer.handle,
+        vk::DeviceSize(ctx.index_count) * sizeof(uint32_t),
+        indices.data(),
+        indices.size_bytes());
+
+    ctx.vertex_count += vertex_count;
+    ctx.index_count += index_count;
+
+    return range;
+}
+
+// positions are expected within [-1, 1], see mesh_file::vertex
+mesh_range
+add_mesh(
+    context&                  ctx,
+    gsl::span<const vertex>   vertices,
+    gsl::span<const uint32_t> indices) noexcept
+{
+    std::vector<mesh_file::vertex> packed;
+    packed.reserve(vertices.size());
+
+    float radius = 0.f;
+    for (const auto& v : vertices) {
+        packed.push_back(mesh_file::pack(
+            {v.position.x, v.position.y, v.position.z},
+            {v.normal.x, v.normal.y, v.normal.z},
+            {v.uv.x, v.uv.y}));
+        radius = std::max(radius, glm::length(v.position));
+    }
+
+    return add_packed_mesh(ctx, packed, indices, radius);
+}
+
+// maps a mesh_file and copies its vertex and index sections from the
+// mapping straight into the staging ring; the mapping is released before
+// returning, the copies go out with the next staging::flush()
+std::optional<mesh_range>
+load_mesh(context& ctx, const std::string& path) noexcept
+{
+    TRACE_ZONE("load_mesh");
+
+    const auto file = mesh_file::mapped_file::open(path);
+    if (!file) { return std::nullopt; }
+
+    const auto contents = mesh_file::parse(file->data(), file->size());
+    if (!contents) {
+        spdlog::warn("{} is not a mesh file", path);
+        return std::nullopt;
+    }
+
+    return add_packed_mesh(
+        ctx,
+        {contents->vertices, contents->vertex_count},
+        {contents->indices, contents->index_count},
+        contents->radius);
+}
+
+// a sphere of radius 1 around the origin, uv wrapping around it; the
+// front (-z) half winds clockwise on screen like the triangle
+mesh_range
+add_sphere_mesh(context& ctx, uint32_t segments, uint32_t rings) noexcept
+{
+    std::vector<vertex> vertices;
+    vertices.reserve(size_t(segments + 1) * (rings + 1));
+    for (uint32_t ring = 0; ring <= rings; ++ring) {
+        const auto v     = float(ring) / float(rings);
+        const auto theta = v * glm::pi<float>();
+        for (uint32_t segment = 0; segment <= segments; ++segment) {
+            const auto u   = float(segment) / float(segments);
+            const auto phi = u * glm::two_pi<float>();
+
+            const glm::vec3 p(
+                std::sin(theta) * std::cos(phi),
+                -std::cos(theta),
+                std::sin(theta) * std::sin(phi));
+            vertices.push_back({p, p, {u, v}});
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(size_t(segments) * rings * 6);
+    for (uint32_t ring = 0; ring != rings; ++ring) {
+        for (uint32_t segment = 0; segment != segments; ++segment) {
+            const auto top_left     = ring * (segments + 1) + segment;
+            const auto top_right    = top_left + 1;
+            const auto bottom_left  = top_left + segments + 1;
+            const auto bottom_right = bottom_left + 1;
+
+            indices.insert(
+                end(indices),
+                {top_left,
+                 top_right,
+                 bottom_right,
+                 top_left,
+                 bottom_right,
+                 bottom_left});
+        }
+    }
+
+    return add_mesh(ctx, vertices, indices);
+}
+
+// writes to a free range of the instance buffer through the staging ring,
+// returns the first_instance of the range; the copies go out with the next
+// staging::flush(). The range stays taken until release_instances()
+uint32_t
+add_instances(
+    context& ctx, gsl::span<const swatch::instance> instances) noexcept
+{
+    const auto count = gsl::narrow<uint32_t>(instances.size());
+    const auto first = ctx.instance_ranges.allocate(count);
+    if (!first) { ERROR("instance buffer is full"); }
+
+    staging::upload(
+        ctx.staging,
+        *ctx.instance_buffer.handle,
+        vk::DeviceSize(*first) * sizeof(swatch::instance),
+        instances.data(),
+        instances.size_bytes());
+
+    return gsl::narrow<uint32_t>(*first);
+}
+
+// hands `range` back to add_instances() once the frames submitted so far,
+// which may still read it, retired
+void
+release_instances(context& ctx, const instance_range& range) noexcept
+{
+    if (range.count == 0) { return; }
+
+    on_frames_retired(ctx, ctx.frame_number, [&ctx, range] {
+        ctx.instance_ranges.free(range.first, range.count);
+    });
+}
+
+// replaces the draw list with a grid of `mesh` swatches, one per entry of
+// `materials` in order; swatches sharing a permutation are drawn with one
+// instanced draw, so the draw count is bounded by the permutation count
+// rather than the swatch count. The previous grid's instances are released
+void
+create_swatch_grid(
+    context&                  ctx,
+    const mesh_range&         mesh,
+    gsl::span<const uint32_t> materials) noexcept
+{
+    TRACE_ZONE("create_swatch_grid");
+
+    const auto count = gsl::narrow<uint32_t>(materials.size());
+    release_instances(ctx, std::exchange(ctx.grid_instances, {}));
+    if (count == 0) {
+        ctx.draws.clear();
+        return;
+    }
+
+    std::vector<uint32_t> order(count);
+    std::iota(begin(order), end(order), 0u);
+    std::stable_sort(begin(order), end(order), [&](auto lhs, auto rhs) {
+        return ctx.materials.permutation(materials[lhs]) <
+               ctx.materials.permutation(materials[rhs]);
+    });
 
-    create_info.setPEnabledFeatures(&device_features);
+    const swatch::grid grid(count, ctx.extent.width, ctx.extent.height);
 
-    auto [result, device] = ctx.physical_device.createDeviceUnique(create_info);
-    if (result != vk::Result::eSuccess) {
-        ERROR("failed to create logical device!");
+    std::vector<swatch::instance> instances;
+    instances.reserve(count);
+    for (auto cell : order) {
+        instances.push_back(grid.place(cell, materials[cell]));
     }
 
-    auto graphics_queue = device->getQueue(graphics_queue_family_index, 0);
-    auto present_queue  = device->getQueue(present_queue_family_index, 0);
-    ctx.device          = std::move(device);
-    ctx.graphics_queue  = std::move(graphics_queue);
-    ctx.present_queue   = std::move(present_queue);
+    const auto first_instance = add_instances(ctx, instances);
+    ctx.grid_instances        = {first_instance, count};
+
+    ctx.draws.clear();
+    for (uint32_t i = 0; i != count; ++i) {
+        const auto material    = instances[i].material;
+        const auto permutation = ctx.materials.permutation(material);
+        if (!ctx.draws.empty() &&
+            ctx.materials.permutation(ctx.draws.back().material) ==
+                permutation) {
+            ++ctx.draws.back().instance_count;
+            continue;
+        }
+
+        ctx.draws.push_back(
+            {mesh.index_count,
+             1,
+             mesh.first_index,
+             mesh.vertex_offset,
+             first_instance + i,
+             material});
+    }
+
+    spdlog::debug(
+        "swatch grid: {} swatches in {}x{}, {} draws",
+        count,
+        grid.columns(),
+        grid.rows(),
+        ctx.draws.size());
 }
 
+// the cull pipeline and the per-frame buffers it writes; the scene itself
+// comes with create_scene()
 void
-create_swapchain(context& ctx) noexcept
+create_culling_resources(context& ctx) noexcept
 {
-    auto swapchain_support =
-        query_swapchain_support(ctx.physical_device, *ctx.surface);
+    TRACE_ZONE("create_culling_resources");
 
-    auto surface_format = choose_swap_surface_format(swapchain_support.formats);
-    auto present_mode =
-        choose_swap_present_mode(swapchain_support.present_modes);
-    auto extent =
-        choose_swap_extent(*ctx.window, swapchain_support.capabilities);
+    const auto bindings = std::array{
+        vk::DescriptorSetLayoutBinding(
+            0,
+            vk::DescriptorType::eStorageBuffer,
+            1,
+            vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(
+            1,
+            vk::DescriptorType::eStorageBuffer,
+            1,
+            vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(
+            2,
+            vk::DescriptorType::eStorageBuffer,
+            1,
+            vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(
+            3,
+            vk::DescriptorType::eStorageBuffer,
+            1,
+            vk::ShaderStageFlagBits::eCompute)};
+
+    ctx.cull_pipeline = create_compute_pipeline(
+        ctx, "cull.comp", bindings, sizeof(cull_constants));
+
+    ctx.cull_commands.clear();
+    ctx.cull_counts.clear();
+    for (size_t i = 0; i != ctx.frames_in_flight; ++i) {
+        ctx.cull_commands.push_back(create_buffer(
+            ctx,
+            vk::DeviceSize(ctx.scene_object_capacity) *
+                sizeof(vk::DrawIndexedIndirectCommand),
+            vk::BufferUsageFlagBits::eStorageBuffer |
+                vk::BufferUsageFlagBits::eIndirectBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            memory::strategy::buddy));
+        ctx.cull_counts.push_back(create_buffer(
+            ctx,
+            vk::DeviceSize(FIRST_BATCH_COUNT + ctx.scene_batch_capacity) *
+                sizeof(uint32_t),
+            vk::BufferUsageFlagBits::eStorageBuffer |
+                vk::BufferUsageFlagBits::eIndirectBuffer |
+                vk::BufferUsageFlagBits::eTransferSrc |
+                vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            memory::strategy::buddy));
+    }
+}
+
+namespace /* anonymous */ {
 
-    uint32_t image_count = swapchain_support.capabilities.minImageCount + 1u;
-    if (swapchain_support.capabilities.maxImageCount > 0 &&
-        image_count > swapchain_support.capabilities.maxImageCount) {
-        image_count = swapchain_support.capabilities.maxImageCount;
+// parks the current scene until the frames drawing it retired, releasing
+// its instances unless `scene` draws with the same ones
+void
+replace_scene(context& ctx, gpu_scene scene) noexcept
+{
+    const auto& old = ctx.scene.instances;
+    if (old.first != scene.instances.first ||
+        old.count != scene.instances.count) {
+        release_instances(ctx, old);
     }
 
-    auto      sharing_mode             = vk::SharingMode::eExclusive;
-    auto      queue_family_index_count = 0;
-    uint32_t* queue_family_indices_ptr = nullptr;
-    auto      indices = find_queue_families(ctx.physical_device, *ctx.surface);
-    auto      q_family_indices =
-        std::array{*indices.graphics_family, *indices.present_family};
+    defer_destroy(ctx, std::exchange(ctx.scene, std::move(scene)));
+}
 
-    if (*indices.graphics_family != *indices.present_family) {
-        sharing_mode             = vk::SharingMode::eConcurrent;
-        queue_family_index_count = 2;
-        queue_family_indices_ptr = q_family_indices.data();
-    } else {
-        sharing_mode = vk::SharingMode::eExclusive;
+} // namespace
+
+// replaces the GPU-driven scene; objects are grouped into one batch per
+// material permutation and draw with `instances`, which the scene owns
+// from now on. The object data goes out with the next staging::flush(),
+// the replaced scene is parked until the frames drawing it retired
+void
+create_scene(
+    context&                      ctx,
+    gsl::span<const scene_object> objects,
+    const instance_range&         instances) noexcept
+{
+    TRACE_ZONE("create_scene");
+
+    const auto count = gsl::narrow<uint32_t>(objects.size());
+    if (count > ctx.scene_object_capacity) {
+        ERROR("scene has more than {} objects", ctx.scene_object_capacity);
     }
 
-    vk::SwapchainCreateInfoKHR create_info(
-        {},
-        *ctx.surface,
-        image_count,
-        surface_format.format,
-        surface_format.colorSpace,
-        extent,
-        1,
-        vk::ImageUsageFlagBits::eColorAttachment,
-        sharing_mode,
-        queue_family_index_count,
-        queue_family_indices_ptr,
-        swapchain_support.capabilities.currentTransform,
-        vk::CompositeAlphaFlagBitsKHR::eOpaque,
-        present_mode,
-        true,
-        nullptr);
+    gpu_scene scene;
+    scene.object_count = count;
+    scene.instances    = instances;
 
-    auto [csresult, swapchain] =
-        ctx.device->createSwapchainKHRUnique(create_info);
-    if (csresult != vk::Result::eSuccess) {
-        ERROR("failed to create swapchain");
+    if (count == 0) {
+        replace_scene(ctx, std::move(scene));
+        return;
     }
-    auto [gsiresult, images] = ctx.device->getSwapchainImagesKHR(*swapchain);
-    if (gsiresult != vk::Result::eSuccess) {
-        ERROR("failed to get swapchain images");
+
+    std::vector<uint32_t> order(count);
+    std::iota(begin(order), end(order), 0u);
+    std::stable_sort(begin(order), end(order), [&](auto lhs, auto rhs) {
+        return ctx.materials.permutation(objects[lhs].material) <
+               ctx.materials.permutation(objects[rhs].material);
+    });
+
+    std::vector<culling_object> culling_objects;
+    culling_objects.reserve(count);
+    for (uint32_t i = 0; i != count; ++i) {
+        const auto& o           = objects[order[i]];
+        const auto  permutation = ctx.materials.permutation(o.material);
+        if (scene.batches.empty() ||
+            ctx.materials.permutation(scene.batches.back().material) !=
+                permutation) {
+            scene.batches.push_back({i, 0, o.material});
+        }
+        ++scene.batches.back().capacity;
+
+        culling_objects.push_back(
+            {o.mesh.index_count,
+             o.mesh.first_index,
+             o.mesh.vertex_offset,
+             o.instance,
+             o.mesh.radius,
+             gsl::narrow<uint32_t>(scene.batches.size() - 1),
+             scene.batches.back().first_command});
+    }
+
+    if (scene.batches.size() > ctx.scene_batch_capacity) {
+        ERROR("scene has more than {} batches", ctx.scene_batch_capacity);
+    }
+
+    scene.objects = create_buffer(
+        ctx,
+        vk::DeviceSize(count) * sizeof(culling_object),
+        vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        memory::strategy::buddy);
+
+    staging::upload(
+        ctx.staging,
+        *scene.objects.handle,
+        0,
+        culling_objects.data(),
+        culling_objects.size() * sizeof(culling_object));
+
+    vk::DescriptorPoolSize pool_size(
+        vk::DescriptorType::eStorageBuffer, 4 * ctx.frames_in_flight);
+    vk::DescriptorPoolCreateInfo dpci({}, ctx.frames_in_flight, 1, &pool_size);
+    auto [dpresult, descriptor_pool] =
+        ctx.device->createDescriptorPoolUnique(dpci);
+    if (dpresult != vk::Result::eSuccess) {
+        ERROR("failed to create scene descriptor pool");
+    }
+    scene.descriptor_pool = std::move(descriptor_pool);
+
+    const std::vector<vk::DescriptorSetLayout> set_layouts(
+        ctx.frames_in_flight, *ctx.cull_pipeline.set_layout);
+    vk::DescriptorSetAllocateInfo dsai(
+        *scene.descriptor_pool,
+        gsl::narrow<uint32_t>(set_layouts.size()),
+        set_layouts.data());
+    auto [dsresult, descriptor_sets] = ctx.device->allocateDescriptorSets(dsai);
+    if (dsresult != vk::Result::eSuccess) {
+        ERROR("failed to allocate scene descriptor sets");
     }
+    scene.descriptor_sets = std::move(descriptor_sets);
+
+    for (size_t i = 0; i != ctx.frames_in_flight; ++i) {
+        const auto buffer_infos = std::array{
+            vk::DescriptorBufferInfo(
+                *ctx.instance_buffer.handle, 0, VK_WHOLE_SIZE),
+            vk::DescriptorBufferInfo(*scene.objects.handle, 0, VK_WHOLE_SIZE),
+            vk::DescriptorBufferInfo(
+                *ctx.cull_commands[i].handle, 0, VK_WHOLE_SIZE),
+            vk::DescriptorBufferInfo(
+                *ctx.cull_counts[i].handle, 0, VK_WHOLE_SIZE)};
+
+        vk::WriteDescriptorSet write(
+            scene.descriptor_sets[i],
+            0,
+            0,
+            gsl::narrow<uint32_t>(buffer_infos.size()),
+            vk::DescriptorType::eStorageBuffer,
+            nullptr,
+            buffer_infos.data());
+        ctx.device->updateDescriptorSets(write, nullptr);
+    }
+
+    spdlog::debug(
+        "scene: {} objects in {} batches", count, scene.batches.size());
 
-    ctx.swapchain = std::move(swapchain);
-    ctx.images    = std::move(images);
-    ctx.format    = surface_format.format;
-    ctx.extent    = extent;
+    replace_scene(ctx, std::move(scene));
 }
 
 void
 create_image_views(context& ctx) noexcept
 {
+    TRACE_ZONE("create_image_views");
+
     std::vector<vk::UniqueImageView> views;
     views.reserve(ctx.images.size());
     vk::ComponentMapping component_mapping(
@@ -696,19 +2704,22 @@ create_image_views(context& ctx) noexcept
     ctx.views = std::move(views);
 }
 
-void
-create_render_pass(context& ctx) noexcept
+// render passes built from the same format are compatible, so pipelines
+// created against one can be used with any other
+vk::UniqueRenderPass
+build_render_pass(vk::Device device, vk::Format format, bool headless) noexcept
 {
     vk::AttachmentDescription attachment_desc(
         {},
-        ctx.format,
+        format,
         vk::SampleCountFlagBits::e1,
         vk::AttachmentLoadOp::eClear,
         vk::AttachmentStoreOp::eStore,
         vk::AttachmentLoadOp::eDontCare,
         vk::AttachmentStoreOp::eDontCare,
         vk::ImageLayout::eUndefined,
-        vk::ImageLayout::ePresentSrcKHR);
+        headless ? vk::ImageLayout::eTransferSrcOptimal :
+                   vk::ImageLayout::ePresentSrcKHR);
 
     vk::AttachmentReference color_ref(
         0, vk::ImageLayout::eColorAttachmentOptimal);
@@ -728,56 +2739,117 @@ create_render_pass(context& ctx) noexcept
     vk::RenderPassCreateInfo rpci(
         {}, 1, &attachment_desc, 1, &subpass, 1, &dependency);
 
-    auto [result, render_pass] = ctx.device->createRenderPassUnique(rpci);
+    auto [result, render_pass] = device.createRenderPassUnique(rpci);
     if (result != vk::Result::eSuccess) {
         ERROR("failed to create render pass");
     }
 
-    ctx.render_pass = std::move(render_pass);
+    return std::move(render_pass);
 }
 
 void
-create_graphics_pipeline(context& ctx) noexcept
+create_render_pass(context& ctx) noexcept
+{
+    TRACE_ZONE("create_render_pass");
+
+    defer_destroy(
+        ctx,
+        std::exchange(
+            ctx.render_pass,
+            build_render_pass(*ctx.device, ctx.format, ctx.headless)));
+}
+
+// the bindless set plus the view pushed once per command buffer
+vk::UniquePipelineLayout
+build_graphics_pipeline_layout(
+    vk::Device device, vk::DescriptorSetLayout bindless_set_layout) noexcept
 {
-    auto vert_shader_code = read_file("shaders/shader.vert.spv");
-    auto frag_shader_code = read_file("shaders/shader.frag.spv");
+    vk::PushConstantRange push_constant_range(
+        vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::vec4));
+
+    vk::PipelineLayoutCreateInfo plci(
+        {}, 1, &bindless_set_layout, 1, &push_constant_range);
+
+    auto [result, pipeline_layout] = device.createPipelineLayoutUnique(plci);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to create pipeline layout");
+    }
 
-    auto&       device = *ctx.device;
-    const auto& extent = ctx.extent;
+    return std::move(pipeline_layout);
+}
+
+// depends on nothing but its arguments, so it can run on any thread; layout
+// and render pass only have to be compatible with the ones the pipeline is
+// used with
+vk::UniquePipeline
+build_graphics_pipeline(
+    vk::Device                      device,
+    vk::PipelineCache               pipeline_cache,
+    vk::PipelineLayout              pipeline_layout,
+    vk::RenderPass                  render_pass,
+    vk::ShaderModule                vert_shader_module,
+    vk::ShaderModule                frag_shader_module,
+    const material::pipeline_state& state) noexcept
+{
+    // constant i lives at word i of state.constants
+    std::array<vk::SpecializationMapEntry, material::CONSTANT_COUNT>
+        specialization_entries;
+    for (uint32_t i = 0; i != specialization_entries.size(); ++i) {
+        specialization_entries[i] = vk::SpecializationMapEntry(
+            i, i * uint32_t(sizeof(uint32_t)), sizeof(uint32_t));
+    }
 
-    vk::UniqueShaderModule vert_shader_module =
-        create_shader_module(device, vert_shader_code);
-    vk::UniqueShaderModule frag_shader_module =
-        create_shader_module(device, frag_shader_code);
+    vk::SpecializationInfo specialization(
+        specialization_entries.size(),
+        specialization_entries.data(),
+        sizeof(state.constants),
+        state.constants.data());
 
     vk::PipelineShaderStageCreateInfo vert_pssci(
-        {}, vk::ShaderStageFlagBits::eVertex, *vert_shader_module, "main");
+        {}, vk::ShaderStageFlagBits::eVertex, vert_shader_module, "main");
 
     vk::PipelineShaderStageCreateInfo frag_pssci(
-        {}, vk::ShaderStageFlagBits::eFragment, *frag_shader_module, "main");
-
-    vk::PipelineVertexInputStateCreateInfo   pvisci;
+        {},
+        vk::ShaderStageFlagBits::eFragment,
+        frag_shader_module,
+        "main",
+        &specialization);
+
+    // all three formats are mandatory vertex buffer formats
+    using packed = mesh_file::vertex;
+    vk::VertexInputBindingDescription binding(
+        0, sizeof(packed), vk::VertexInputRate::eVertex);
+
+    auto attributes = std::array{
+        vk::VertexInputAttributeDescription(
+            0,
+            0,
+            vk::Format::eR16G16B16A16Snorm,
+            offsetof(packed, position)),
+        vk::VertexInputAttributeDescription(
+            1, 0, vk::Format::eR16G16Snorm, offsetof(packed, normal)),
+        vk::VertexInputAttributeDescription(
+            2, 0, vk::Format::eR16G16Sfloat, offsetof(packed, uv))};
+
+    vk::PipelineVertexInputStateCreateInfo pvisci(
+        {},
+        1,
+        &binding,
+        gsl::narrow<uint32_t>(attributes.size()),
+        attributes.data());
     vk::PipelineInputAssemblyStateCreateInfo piasci(
         {}, vk::PrimitiveTopology::eTriangleList);
 
-    vk::Viewport viewport(
-        0.f,
-        0.f,
-        gsl::narrow<float>(extent.width),
-        gsl::narrow<float>(extent.height),
-        0.f,
-        1.f);
-
-    vk::Rect2D scissor(vk::Offset2D(0, 0), extent);
-
-    vk::PipelineViewportStateCreateInfo pvsci({}, 1, &viewport, 1, &scissor);
+    // viewport and scissor are dynamic so resizing doesn't touch the pipeline
+    vk::PipelineViewportStateCreateInfo pvsci({}, 1, nullptr, 1, nullptr);
 
     vk::PipelineRasterizationStateCreateInfo rasterizer(
         {},
         false,
         false,
         vk::PolygonMode::eFill,
-        vk::CullModeFlagBits::eBack,
+        state.double_sided ? vk::CullModeFlagBits::eNone :
+                             vk::CullModeFlagBits::eBack,
         vk::FrontFace::eClockwise,
         false,
         0.f,
@@ -794,13 +2866,14 @@ create_graphics_pipeline(context& ctx) noexcept
         VK_FALSE,
         VK_FALSE);
 
+    // straight alpha "over" for alpha-blended materials
     vk::PipelineColorBlendAttachmentState color_blend_attachment(
-        VK_FALSE,
-        vk::BlendFactor::eOne,
-        vk::BlendFactor::eZero,
+        state.blend,
+        vk::BlendFactor::eSrcAlpha,
+        vk::BlendFactor::eOneMinusSrcAlpha,
         vk::BlendOp::eAdd,
         vk::BlendFactor::eOne,
-        vk::BlendFactor::eZero,
+        vk::BlendFactor::eOneMinusSrcAlpha,
         vk::BlendOp::eAdd,
         vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
             vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
@@ -815,20 +2888,12 @@ create_graphics_pipeline(context& ctx) noexcept
         blend_constants);
 
     auto dynamic_states =
-        std::array{vk::DynamicState::eViewport, vk::DynamicState::eLineWidth};
+        std::array{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
 
     vk::PipelineDynamicStateCreateInfo dynamic_state = {};
     dynamic_state.dynamicStateCount                  = dynamic_states.size();
     dynamic_state.pDynamicStates                     = dynamic_states.data();
 
-    auto [cplresult, pipeline_layout] =
-        device.createPipelineLayoutUnique(vk::PipelineLayoutCreateInfo());
-    if (cplresult != vk::Result::eSuccess) {
-        ERROR("failed to create pipeline layout");
-    }
-
-    ctx.pipeline_layout = std::move(pipeline_layout);
-
     auto shader_stages = std::array{vert_pssci, frag_pssci};
 
     vk::GraphicsPipelineCreateInfo gpci(
@@ -843,22 +2908,194 @@ create_graphics_pipeline(context& ctx) noexcept
         &multisampling,
         nullptr,
         &color_blending,
-        nullptr,
-        *ctx.pipeline_layout,
-        *ctx.render_pass);
+        &dynamic_state,
+        pipeline_layout,
+        render_pass);
 
-    auto [cgpresult, graphics_pipeline] =
-        device.createGraphicsPipelinesUnique(nullptr, gpci);
-    if (cgpresult != vk::Result::eSuccess) {
+    auto [result, graphics_pipeline] =
+        device.createGraphicsPipelinesUnique(pipeline_cache, gpci);
+    if (result != vk::Result::eSuccess) {
         ERROR("failed to create graphics pipeline");
     }
 
-    ctx.graphics_pipeline = std::move(graphics_pipeline.front());
+    return std::move(graphics_pipeline.front());
+}
+
+// rebuilds every pipeline permutation, e.g. after the render pass changed
+void
+create_graphics_pipeline(context& ctx) noexcept
+{
+    TRACE_ZONE("create_graphics_pipeline");
+
+    defer_destroy(
+        ctx,
+        std::exchange(
+            ctx.pipeline_layout,
+            build_graphics_pipeline_layout(
+                *ctx.device, *ctx.bindless_set_layout)));
+    defer_destroy(ctx, std::move(ctx.material_pipelines));
+    ctx.material_pipelines.clear();
+
+    build_materials(ctx);
+}
+
+// registers a material; its permutation is compiled by the next
+// build_materials() unless another material already needs the same state,
+// its parameters go out with the next staging::flush()
+uint32_t
+add_material(
+    context&                     ctx,
+    std::string                  name,
+    const material::feature_set& features,
+    const material::parameters&  params) noexcept
+{
+    if (ctx.materials.size() == ctx.material_capacity) {
+        ERROR("material buffer is full");
+    }
+
+    const auto index = ctx.materials.add(std::move(name), features, params);
+
+    staging::upload(
+        ctx.staging,
+        *ctx.material_buffer.handle,
+        vk::DeviceSize(index) * sizeof(material::parameters),
+        &params,
+        sizeof(params));
+
+    return index;
+}
+
+// replaces the parameters of a material, e.g. with the slots of textures
+// that arrived after it; frames in flight may read either version until the
+// copy goes out with the next staging::flush()
+void
+set_material_parameters(
+    context& ctx, uint32_t index, const material::parameters& params) noexcept
+{
+    ctx.materials.set_parameters(index, params);
+
+    staging::upload(
+        ctx.staging,
+        *ctx.material_buffer.handle,
+        vk::DeviceSize(index) * sizeof(material::parameters),
+        &params,
+        sizeof(params));
+}
+
+// compiles the permutations that have no pipeline yet, in parallel on the
+// worker threads
+void
+build_materials(context& ctx) noexcept
+{
+    TRACE_ZONE("build_materials");
+
+    const auto& states = ctx.materials.states();
+    ctx.material_pipelines.resize(states.size());
+
+    std::vector<uint32_t> pending;
+    for (uint32_t i = 0; i != states.size(); ++i) {
+        if (!ctx.material_pipelines[i]) { pending.push_back(i); }
+    }
+    if (pending.empty()) { return; }
+
+    // the module cache isn't thread-safe, modules are looked up up front
+    auto&      device = *ctx.device;
+    const auto vert_shader_module =
+        shaders::load(ctx.shader_modules, device, "shader.vert");
+    const auto frag_shader_module =
+        shaders::load(ctx.shader_modules, device, "shader.frag");
+
+    const auto start = std::chrono::steady_clock::now();
+
+    ctx.workers->parallel_for(
+        pending.size(),
+        1,
+        [&ctx, &states, &pending, vert_shader_module, frag_shader_module](
+            size_t, jobs::range r) {
+            for (auto i = r.begin; i != r.end; ++i) {
+                TRACE_ZONE("build permutation");
+
+                ctx.material_pipelines[pending[i]] = build_graphics_pipeline(
+                    *ctx.device,
+                    *ctx.pipeline_cache,
+                    *ctx.pipeline_layout,
+                    *ctx.render_pass,
+                    vert_shader_module,
+                    frag_shader_module,
+                    states[pending[i]]);
+            }
+        });
+
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    spdlog::info(
+        "{} pipeline permutations for {} materials created in {:.3f}ms",
+        pending.size(),
+        ctx.materials.size(),
+        elapsed.count());
+}
+
+// single descriptor set layout built from `bindings` plus an optional push
+// constant block visible to the compute stage
+compute_pipeline
+create_compute_pipeline(
+    context&                                        ctx,
+    std::string_view                                shader,
+    gsl::span<const vk::DescriptorSetLayoutBinding> bindings,
+    uint32_t                                        push_constants) noexcept
+{
+    auto& device = *ctx.device;
+
+    const auto shader_module =
+        shaders::load(ctx.shader_modules, device, shader);
+
+    compute_pipeline cp;
+
+    vk::DescriptorSetLayoutCreateInfo dslci(
+        {}, gsl::narrow<uint32_t>(bindings.size()), bindings.data());
+    auto [dslresult, set_layout] =
+        device.createDescriptorSetLayoutUnique(dslci);
+    if (dslresult != vk::Result::eSuccess) {
+        ERROR("failed to create compute descriptor set layout");
+    }
+    cp.set_layout = std::move(set_layout);
+
+    vk::PushConstantRange push_constant_range(
+        vk::ShaderStageFlagBits::eCompute, 0, push_constants);
+
+    vk::PipelineLayoutCreateInfo plci(
+        {},
+        1,
+        &*cp.set_layout,
+        push_constants == 0 ? 0 : 1,
+        &push_constant_range);
+    auto [plresult, layout] = device.createPipelineLayoutUnique(plci);
+    if (plresult != vk::Result::eSuccess) {
+        ERROR("failed to create compute pipeline layout");
+    }
+    cp.layout = std::move(layout);
+
+    vk::ComputePipelineCreateInfo cpci(
+        {},
+        vk::PipelineShaderStageCreateInfo(
+            {}, vk::ShaderStageFlagBits::eCompute, shader_module, "main"),
+        *cp.layout);
+
+    auto [cpresult, pipelines] =
+        device.createComputePipelinesUnique(*ctx.pipeline_cache, cpci);
+    if (cpresult != vk::Result::eSuccess) {
+        ERROR("failed to create compute pipeline {}", shader);
+    }
+    cp.pipeline = std::move(pipelines.front());
+
+    return cp;
 }
 
 void
 create_framebuffers(context& ctx) noexcept
 {
+    TRACE_ZONE("create_framebuffers");
+
     std::vector<vk::UniqueFramebuffer> framebuffers;
     framebuffers.reserve(ctx.views.size());
 
@@ -884,61 +3121,79 @@ create_framebuffers(context& ctx) noexcept
 }
 
 void
-create_command_pool(context& ctx) noexcept
+create_workers(context& ctx) noexcept
 {
-    auto indices = find_queue_families(ctx.physical_device, *ctx.surface);
+    TRACE_ZONE("create_workers");
 
-    vk::CommandPoolCreateInfo cpci({}, *indices.graphics_family);
+    const size_t worker_count = ctx.worker_count != 0 ?
+                                    ctx.worker_count :
+                                    std::thread::hardware_concurrency();
 
-    auto [result, command_pool] = ctx.device->createCommandPoolUnique(cpci);
-    if (result != vk::Result::eSuccess) {
-        ERROR("failed to create command pool");
-    }
+    ctx.workers = std::make_unique<jobs::pool>(worker_count);
+    ctx.worker_record_times.assign(
+        ctx.workers->size(), std::chrono::nanoseconds::zero());
 
-    ctx.command_pool = std::move(command_pool);
+    spdlog::debug("{} worker threads", ctx.workers->size());
 }
 
 void
-create_command_buffers(context& ctx) noexcept
+create_command_pools(context& ctx) noexcept
 {
-    vk::CommandBufferAllocateInfo cbai(
-        *ctx.command_pool,
-        vk::CommandBufferLevel::ePrimary,
-        gsl::narrow<uint32_t>(ctx.framebuffers.size()));
+    TRACE_ZONE("create_command_pools");
 
-    auto [result, command_buffers] =
-        ctx.device->allocateCommandBuffersUnique(cbai);
-    if (result != vk::Result::eSuccess) {
-        ERROR("failed to allocate command buffers");
-    }
+    auto indices = find_queue_families(ctx.physical_device, *ctx.surface);
 
-    vk::ClearValue clear_color(std::array<float, 4>{0.f, 0.f, 0.f, 1.f});
+    // command buffers are re-recorded every frame, so each frame in flight
+    // gets its own transient pool that is reset wholesale
+    vk::CommandPoolCreateInfo cpci(
+        vk::CommandPoolCreateFlagBits::eTransient, *indices.graphics_family);
 
-    for (size_t i = 0; i != command_buffers.size(); ++i) {
-        result = command_buffers[i]->begin(vk::CommandBufferBeginInfo());
+    std::vector<vk::UniqueCommandPool> command_pools;
+    command_pools.reserve(ctx.frames_in_flight);
+
+    for (size_t i = 0; i != ctx.frames_in_flight; ++i) {
+        auto [result, command_pool] = ctx.device->createCommandPoolUnique(cpci);
         if (result != vk::Result::eSuccess) {
-            ERROR("failed to begin recording command buffer");
+            ERROR("failed to create command pool");
         }
+        command_pools.push_back(std::move(command_pool));
+    }
 
-        vk::RenderPassBeginInfo render_pass_info(
-            *ctx.render_pass,
-            *ctx.framebuffers[i],
-            vk::Rect2D(vk::Offset2D(0.f, 0.f), ctx.extent),
-            1,
-            &clear_color);
+    std::vector<std::vector<worker_command_pool>> worker_pools(
+        ctx.frames_in_flight);
 
-        command_buffers[i]->beginRenderPass(
-            render_pass_info, vk::SubpassContents::eInline);
+    for (auto& frame_pools : worker_pools) {
+        frame_pools.resize(ctx.workers->size());
+        for (auto& wcp : frame_pools) {
+            auto [result, pool] = ctx.device->createCommandPoolUnique(cpci);
+            if (result != vk::Result::eSuccess) {
+                ERROR("failed to create worker command pool");
+            }
+            wcp.pool = std::move(pool);
+        }
+    }
 
-        command_buffers[i]->bindPipeline(
-            vk::PipelineBindPoint::eGraphics, *ctx.graphics_pipeline);
+    ctx.command_pools = std::move(command_pools);
+    ctx.worker_pools  = std::move(worker_pools);
+}
+
+void
+create_command_buffers(context& ctx) noexcept
+{
+    TRACE_ZONE("create_command_buffers");
+
+    std::vector<vk::UniqueCommandBuffer> command_buffers;
+    command_buffers.reserve(ctx.command_pools.size());
 
-        command_buffers[i]->draw(3, 1, 0, 0);
-        command_buffers[i]->endRenderPass();
+    for (const auto& command_pool : ctx.command_pools) {
+        vk::CommandBufferAllocateInfo cbai(
+            *command_pool, vk::CommandBufferLevel::ePrimary, 1);
 
-        if (command_buffers[i]->end() != vk::Result::eSuccess) {
-            ERROR("failed to record command buffer");
+        auto [result, buffers] = ctx.device->allocateCommandBuffersUnique(cbai);
+        if (result != vk::Result::eSuccess) {
+            ERROR("failed to allocate command buffers");
         }
+        command_buffers.push_back(std::move(buffers.front()));
     }
 
     ctx.command_buffers = std::move(command_buffers);
@@ -947,21 +3202,20 @@ create_command_buffers(context& ctx) noexcept
 void
 create_sync_objects(context& ctx) noexcept
 {
-    vk::SemaphoreCreateInfo sci;
+    TRACE_ZONE("create_sync_objects");
 
-    vk::FenceCreateInfo fci(vk::FenceCreateFlagBits::eSignaled);
+    vk::SemaphoreCreateInfo sci;
 
+    // acquire and present only take binary semaphores, everything else
+    // synchronizes on the timeline
     std::vector<vk::UniqueSemaphore> image_avail_semaphores;
-    image_avail_semaphores.reserve(MAX_FRAMES_IN_FLIGHT);
+    image_avail_semaphores.reserve(ctx.frames_in_flight);
     std::vector<vk::UniqueSemaphore> render_finished_semaphores;
-    render_finished_semaphores.reserve(MAX_FRAMES_IN_FLIGHT);
-    std::vector<vk::UniqueFence> inflight_fences;
-    inflight_fences.reserve(MAX_FRAMES_IN_FLIGHT);
-    std::vector<vk::Fence> images_inflight(ctx.images.size());
+    render_finished_semaphores.reserve(ctx.frames_in_flight);
 
     auto& device = *ctx.device;
 
-    for (size_t i = 0; i != MAX_FRAMES_IN_FLIGHT; ++i) {
+    for (size_t i = 0; i != ctx.frames_in_flight; ++i) {
         auto [iaresult, ia_semaphore] = device.createSemaphoreUnique(sci);
         if (iaresult != vk::Result::eSuccess) {
             ERROR("failed to create semaphore");
@@ -974,19 +3228,177 @@ create_sync_objects(context& ctx) noexcept
 
         image_avail_semaphores.push_back(std::move(ia_semaphore));
         render_finished_semaphores.push_back(std::move(rf_semaphore));
+    }
 
-        auto [ifresult, if_fence] = device.createFenceUnique(fci);
-        if (ifresult != vk::Result::eSuccess) {
-            ERROR("failed to create fence");
-        }
+    vk::SemaphoreTypeCreateInfo stci(
+        vk::SemaphoreType::eTimeline, ctx.frame_number);
+    vk::SemaphoreCreateInfo timeline_sci;
+    timeline_sci.setPNext(&stci);
 
-        inflight_fences.push_back(std::move(if_fence));
+    auto [tresult, timeline] = device.createSemaphoreUnique(timeline_sci);
+    if (tresult != vk::Result::eSuccess) {
+        ERROR("failed to create timeline semaphore");
     }
 
     ctx.image_avail_semaphores     = std::move(image_avail_semaphores);
     ctx.render_finished_semaphores = std::move(render_finished_semaphores);
-    ctx.inflight_fences            = std::move(inflight_fences);
-    ctx.images_inflight            = std::move(images_inflight);
+    ctx.timeline                   = std::move(timeline);
+    ctx.image_frames.assign(ctx.images.size(), 0);
+}
+
+uint64_t
+completed_frames(context& ctx) noexcept
+{
+    auto [result, value] =
+        ctx.device->getSemaphoreCounterValueKHR(*ctx.timeline);
+    if (result != vk::Result::eSuccess) {
+        ERROR("failed to query frame timeline");
+    }
+
+    return value;
+}
+
+// blocks until `value` frames have retired
+void
+wait_for_frames(context& ctx, uint64_t value) noexcept
+{
+    if (value == 0) { return; }
+
+    vk::SemaphoreWaitInfo swi({}, 1, &*ctx.timeline, &value);
+    if (ctx.device->waitSemaphoresKHR(
+            swi, std::numeric_limits<uint64_t>::max()) !=
+        vk::Result::eSuccess) {
+        ERROR("failed to wait for frame {}", value);
+    }
+}
+
+// parks `object` (a handle, resource or container of them) until every frame
+// submitted so far has retired; use it instead of reassigning or clearing
+// anything a frame in flight may still reference
+template <typename T>
+void
+defer_destroy(context& ctx, T&& object) noexcept
+{
+    static_assert(!std::is_lvalue_reference_v<T>, "move the object in");
+
+    // frames submitted from now on can't see the object anymore
+    if (ctx.deletion_queue.empty() ||
+        ctx.deletion_queue.back().value != ctx.frame_number) {
+        ctx.deletion_queue.push_back({ctx.frame_number, {}});
+    }
+    ctx.deletion_queue.back().objects.push_back(
+        std::make_shared<T>(std::move(object)));
+}
+
+// runs `callback` from the render thread once `value` frames have retired,
+// e.g. to release resources the GPU may still be reading
+void
+on_frames_retired(
+    context& ctx, uint64_t value, std::function<void()> callback) noexcept
+{
+    auto it = std::upper_bound(
+        begin(ctx.retire_queue),
+        end(ctx.retire_queue),
+        value,
+        [](uint64_t v, const retire_callback& rc) { return v < rc.value; });
+    ctx.retire_queue.insert(it, {value, std::move(callback)});
+}
+
+void
+run_retired(context& ctx) noexcept
+{
+    if (ctx.retire_queue.empty() && ctx.deletion_queue.empty()) { return; }
+
+    const auto completed = completed_frames(ctx);
+    while (!ctx.retire_queue.empty() &&
+           ctx.retire_queue.front().value <= completed) {
+        auto callback = std::move(ctx.retire_queue.front().callback);
+        ctx.retire_queue.pop_front();
+        callback();
+    }
+
+    while (!ctx.deletion_queue.empty() &&
+           ctx.deletion_queue.front().value <= completed) {
+        TRACE_ZONE("destroy retired objects");
+        for (auto& object : ctx.deletion_queue.front().objects) {
+            object.reset();
+        }
+        ctx.deletion_queue.pop_front();
+    }
+}
+
+// switches present mode and image count at runtime; `image_count` 0 lets the
+// policy decide
+void
+set_present_policy(
+    context& ctx, present_policy policy, uint32_t image_count) noexcept
+{
+    ctx.present               = policy;
+    ctx.swapchain_image_count = image_count;
+    ctx.input_to_present_ms.clear();
+
+    if (!ctx.headless && ctx.swapchain) { recreate_swapchain(ctx); }
+}
+
+// to be called right before sampling input; with the low_latency policy the
+// CPU waits for the GPU to drain first, so input is read as late as possible
+// at the cost of CPU/GPU overlap
+void
+pace_frame(context& ctx) noexcept
+{
+    if (ctx.present == present_policy::low_latency) {
+        TRACE_ZONE("pace_frame");
+        wait_for_frames(ctx, ctx.frame_number);
+    }
+
+    ctx.input_time = std::chrono::steady_clock::now();
+}
+
+// the time from sampling input to presentKHR returning; images already
+// queued for display add up to one refresh each on top of it
+void
+log_latency(const context& ctx) noexcept
+{
+    const auto& window = ctx.input_to_present_ms;
+    if (window.empty()) { return; }
+
+    spdlog::info(
+        "input to present ({}): avg {:.3f}ms p50 {:.3f}ms p99 {:.3f}ms "
+        "({} frames)",
+        to_string(ctx.present),
+        window.average(),
+        window.percentile(50),
+        window.percentile(99),
+        window.size());
+}
+
+// waits until the per-frame resources of the next frame are free again,
+// i.e. until the frame that used them `frames_in_flight` frames ago retired
+void
+begin_frame(context& ctx) noexcept
+{
+    ctx.current_frame = ctx.frame_number % ctx.frames_in_flight;
+
+    if (ctx.frame_number >= ctx.frames_in_flight) {
+        wait_for_frames(ctx, ctx.frame_number - ctx.frames_in_flight + 1);
+    }
+
+    run_retired(ctx);
+}
+
+// to be called after the frame's submission, which signals
+// `frame_number + 1` on the timeline
+void
+end_frame(context& ctx) noexcept
+{
+    ++ctx.frame_number;
+}
+
+void
+wait_idle(context& ctx) noexcept
+{
+    wait_for_frames(ctx, ctx.frame_number);
+    run_retired(ctx);
 }
 
 } // namespace vulkan
@@ -0,0 +1,195 @@
+#include <gmock/gmock.h>
+
+#include "bcn.hpp"
+
+namespace {
+
+// packs fields least significant bit first, as BC7 blocks are read
+class bit_writer {
+    std::array<std::byte, 16> _block{};
+    size_t                    _position = 0;
+
+public:
+    void
+    write(uint32_t value, size_t count)
+    {
+        for (size_t i = 0; i != count; ++i, ++_position) {
+            if ((value >> i & 1) != 0) {
+                _block[_position / 8] |= std::byte(1 << (_position % 8));
+            }
+        }
+    }
+
+    const std::array<std::byte, 16>&
+    block() const
+    {
+        return _block;
+    }
+};
+
+std::array<uint8_t, 4>
+texel(const bcn::texels& t, size_t i)
+{
+    return {t[i * 4], t[i * 4 + 1], t[i * 4 + 2], t[i * 4 + 3]};
+}
+
+TEST(bcn_test, bc1_interpolates_and_cuts_out)
+{
+    // red and blue endpoints; texel i uses index i % 4
+    std::array<std::byte, 8> block = {
+        std::byte(0x00),
+        std::byte(0xf8),
+        std::byte(0x1f),
+        std::byte(0x00),
+        std::byte(0xe4),
+        std::byte(0xe4),
+        std::byte(0xe4),
+        std::byte(0xe4)};
+
+    bcn::texels t;
+    bcn::decode_block(bcn::format::bc1, block.data(), t);
+    EXPECT_THAT(texel(t, 0), testing::ElementsAre(255, 0, 0, 255));
+    EXPECT_THAT(texel(t, 1), testing::ElementsAre(0, 0, 255, 255));
+    EXPECT_THAT(texel(t, 2), testing::ElementsAre(170, 0, 85, 255));
+    EXPECT_THAT(texel(t, 3), testing::ElementsAre(85, 0, 170, 255));
+
+    // swapped endpoints select three colors and transparent black
+    std::swap(block[0], block[2]);
+    std::swap(block[1], block[3]);
+    bcn::decode_block(bcn::format::bc1, block.data(), t);
+    EXPECT_THAT(texel(t, 2), testing::ElementsAre(127, 0, 127, 255));
+    EXPECT_THAT(texel(t, 3), testing::ElementsAre(0, 0, 0, 0));
+
+    // BC2 and BC3 colors always interpolate four
+    std::array<std::byte, 16> bc2{};
+    std::copy(begin(block), end(block), begin(bc2) + 8);
+    bcn::decode_block(bcn::format::bc2, bc2.data(), t);
+    EXPECT_THAT(texel(t, 3), testing::ElementsAre(170, 0, 85, 0));
+}
+
+TEST(bcn_test, bc1_without_alpha_decodes_opaque_black)
+{
+    // blue and red endpoints, so three colors; texel i uses index i % 4
+    std::array<std::byte, 8> block = {
+        std::byte(0x1f),
+        std::byte(0x00),
+        std::byte(0x00),
+        std::byte(0xf8),
+        std::byte(0xe4),
+        std::byte(0xe4),
+        std::byte(0xe4),
+        std::byte(0xe4)};
+
+    bcn::texels t;
+    bcn::decode_block(bcn::format::bc1_rgb, block.data(), t);
+    EXPECT_THAT(texel(t, 2), testing::ElementsAre(127, 0, 127, 255));
+    EXPECT_THAT(texel(t, 3), testing::ElementsAre(0, 0, 0, 255));
+    EXPECT_EQ(bcn::block_size(bcn::format::bc1_rgb), 8u);
+}
+
+TEST(bcn_test, alpha_blocks_have_eight_and_six_value_palettes)
+{
+    // a0 > a1: six interpolated values; texel i uses index i % 8
+    std::array<std::byte, 8> block = {
+        std::byte(255),
+        std::byte(3),
+        std::byte(0x88),
+        std::byte(0xc6),
+        std::byte(0xfa),
+        std::byte(0x88),
+        std::byte(0xc6),
+        std::byte(0xfa)};
+
+    bcn::texels t;
+    bcn::decode_block(bcn::format::bc4, block.data(), t);
+    std::array<uint8_t, 8> values;
+    for (size_t i = 0; i != 8; ++i) { values[i] = t[i * 4]; }
+    EXPECT_THAT(
+        values, testing::ElementsAre(255, 3, 219, 183, 147, 111, 75, 39));
+    EXPECT_THAT(texel(t, 0), testing::ElementsAre(255, 0, 0, 255));
+
+    // a0 <= a1: four interpolated values, then 0 and 255
+    std::swap(block[0], block[1]);
+    bcn::decode_block(bcn::format::bc4, block.data(), t);
+    for (size_t i = 0; i != 8; ++i) { values[i] = t[i * 4]; }
+    EXPECT_THAT(
+        values, testing::ElementsAre(3, 255, 53, 103, 154, 204, 0, 255));
+}
+
+TEST(bcn_test, bc7_mode_6_interpolates_with_pbits)
+{
+    // mode 6: red to green endpoints, opaque, p-bits 1 and 0
+    bit_writer w;
+    w.write(1 << 6, 7);
+    for (auto value : {127u, 0u, 0u, 127u, 0u, 0u, 127u, 127u}) {
+        w.write(value, 7);
+    }
+    w.write(1, 1);
+    w.write(0, 1);
+
+    // the anchor texel 0 has 3 index bits, every other one 4
+    w.write(0, 3);
+    for (uint32_t i = 1; i != 16; ++i) { w.write(i, 4); }
+
+    bcn::texels t;
+    bcn::decode_block(bcn::format::bc7, w.block().data(), t);
+
+    // p-bit 1 turns the first endpoint's zeros into ones
+    EXPECT_THAT(texel(t, 0), testing::ElementsAre(255, 1, 1, 255));
+    EXPECT_THAT(texel(t, 15), testing::ElementsAre(0, 254, 0, 254));
+
+    // weight 34 of 64 at index 8
+    EXPECT_THAT(texel(t, 8), testing::ElementsAre(120, 135, 0, 254));
+}
+
+TEST(bcn_test, bc7_mode_5_rotates_alpha_into_a_color_channel)
+{
+    // mode 5, rotation 1 (alpha and red swap); black to white color,
+    // constant alpha 64
+    bit_writer w;
+    w.write(1 << 5, 6);
+    w.write(1, 2);
+    for (auto value : {0u, 127u, 0u, 127u, 0u, 127u}) { w.write(value, 7); }
+    w.write(64, 8);
+    w.write(64, 8);
+    w.write(0, 1);
+    for (uint32_t i = 1; i != 16; ++i) { w.write(3, 2); }
+    w.write(0, 1);
+    for (uint32_t i = 1; i != 16; ++i) { w.write(0, 2); }
+
+    bcn::texels t;
+    bcn::decode_block(bcn::format::bc7, w.block().data(), t);
+    EXPECT_THAT(texel(t, 0), testing::ElementsAre(64, 0, 0, 0));
+    EXPECT_THAT(texel(t, 1), testing::ElementsAre(64, 255, 255, 255));
+
+    // the reserved mode 8
+    const std::array<std::byte, 16> reserved{};
+    bcn::decode_block(bcn::format::bc7, reserved.data(), t);
+    EXPECT_THAT(texel(t, 0), testing::ElementsAre(0, 0, 0, 0));
+}
+
+TEST(bcn_test, images_crop_their_edge_blocks)
+{
+    // two BC5 blocks, the first all red, the second all green
+    std::vector<std::byte> blocks(32);
+    blocks[0]  = std::byte(255);
+    blocks[1]  = std::byte(255);
+    blocks[24] = std::byte(255);
+    blocks[25] = std::byte(255);
+
+    std::vector<uint8_t> rgba;
+    ASSERT_TRUE(bcn::decode_image(
+        bcn::format::bc5, blocks.data(), blocks.size(), 5, 3, rgba));
+    ASSERT_EQ(rgba.size(), 5u * 3 * 4);
+    EXPECT_THAT(
+        std::vector<uint8_t>(begin(rgba) + 12, begin(rgba) + 20),
+        testing::ElementsAre(255, 0, 0, 255, 0, 255, 0, 255));
+    EXPECT_THAT(
+        std::vector<uint8_t>(end(rgba) - 4, end(rgba)),
+        testing::ElementsAre(0, 255, 0, 255));
+
+    EXPECT_FALSE(bcn::decode_image(
+        bcn::format::bc5, blocks.data(), blocks.size(), 9, 3, rgba));
+}
+
+} // namespace
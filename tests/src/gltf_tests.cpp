@@ -0,0 +1,352 @@
+#include <cstdio>
+#include <fstream>
+
+#include <gmock/gmock.h>
+
+#include "gltf.hpp"
+
+namespace {
+
+std::string
+encode_base64(const std::vector<std::byte>& data)
+{
+    constexpr std::string_view ALPHABET =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string text;
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t bits = 0;
+        for (size_t k = 0; k != 3; ++k) {
+            bits = bits << 8 |
+                   (i + k < data.size() ? uint32_t(data[i + k]) : 0u);
+        }
+        for (size_t k = 0; k != 4; ++k) {
+            text += i * 4 / 3 + k <= data.size() * 4 / 3 ?
+                        ALPHABET[bits >> (18 - 6 * k) & 63] :
+                        '=';
+        }
+    }
+    return text;
+}
+
+// positions (0, 0, 0), (1, 0, 0), (0, 1, 0) as floats, then the indices
+// 0, 1, 2 as unsigned shorts
+std::vector<std::byte>
+triangle_buffer()
+{
+    const std::array<float, 9>    positions = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+    const std::array<uint16_t, 3> indices   = {0, 1, 2};
+
+    std::vector<std::byte> data(sizeof(positions) + sizeof(indices));
+    std::memcpy(data.data(), positions.data(), sizeof(positions));
+    std::memcpy(
+        data.data() + sizeof(positions), indices.data(), sizeof(indices));
+    return data;
+}
+
+// a document drawing the triangle once, with the given node properties
+std::string
+triangle_json(const std::string& uri, const std::string& node = "")
+{
+    return R"({
+        "asset": {"version": "2.0"},
+        "buffers": [{)" +
+           uri + R"("byteLength": 42}],
+        "bufferViews": [
+            {"buffer": 0, "byteLength": 36},
+            {"buffer": 0, "byteOffset": 36, "byteLength": 6}],
+        "accessors": [
+            {"bufferView": 0, "componentType": 5126, "count": 3,
+             "type": "VEC3", "min": [0, 0, 0], "max": [1, 1, 0]},
+            {"bufferView": 1, "componentType": 5123, "count": 3,
+             "type": "SCALAR"}],
+        "meshes": [{"primitives": [
+            {"attributes": {"POSITION": 0}, "indices": 1}]}],
+        "nodes": [{"mesh": 0)" +
+           node + R"(}],
+        "scenes": [{"nodes": [0]}]
+    })";
+}
+
+void
+write_file(const std::string& path, const std::string& contents)
+{
+    std::ofstream(path, std::ios::binary) << contents;
+}
+
+std::array<float, 3>
+position(const gltf::decoded_mesh& m, size_t i)
+{
+    return mesh_file::unpack_position(m.vertices[i]);
+}
+
+std::array<float, 3>
+normal(const gltf::decoded_mesh& m, size_t i)
+{
+    return mesh_file::decode_octahedral(m.vertices[i].normal);
+}
+
+TEST(gltf_test, decodes_base64)
+{
+    const auto text = [](std::string_view encoded) {
+        const auto decoded = gltf::decode_base64(encoded);
+        return decoded ? std::string(
+                             reinterpret_cast<const char*>(decoded->data()),
+                             decoded->size()) :
+                         std::string("<invalid>");
+    };
+
+    EXPECT_EQ(text("TWFu"), "Man");
+    EXPECT_EQ(text("TWE="), "Ma");
+    EXPECT_EQ(text("TQ=="), "M");
+    EXPECT_EQ(text("TQ"), "M");
+    EXPECT_EQ(text(""), "");
+    EXPECT_EQ(text("TW#u"), "<invalid>");
+
+    const auto data = triangle_buffer();
+    EXPECT_EQ(gltf::decode_base64(encode_base64(data)), data);
+
+    EXPECT_TRUE(gltf::decode_data_uri(
+        "data:application/octet-stream;base64," + encode_base64(data)));
+    EXPECT_FALSE(gltf::decode_data_uri("triangle.bin"));
+    EXPECT_FALSE(gltf::decode_data_uri("data:text/plain,abc"));
+}
+
+TEST(gltf_test, parse_rejects_unsupported_documents)
+{
+    const auto parse = [](const std::string& text) {
+        const auto root = json::parse(text);
+        return root ? gltf::parse(*root) : std::nullopt;
+    };
+
+    EXPECT_TRUE(parse(triangle_json(R"("uri": "triangle.bin", )")));
+
+    EXPECT_FALSE(parse(R"({"asset": {"version": "1.0"}})"));
+    EXPECT_FALSE(parse(
+        R"({"asset": {"version": "2.0"},
+            "extensionsRequired": ["KHR_draco_mesh_compression"]})"));
+    EXPECT_TRUE(parse(
+        R"({"asset": {"version": "2.0"},
+            "extensionsRequired": ["KHR_mesh_quantization"]})"));
+    EXPECT_FALSE(parse(
+        R"({"asset": {"version": "2.0"}, "nodes": [{"mesh": 0}]})"));
+    EXPECT_FALSE(parse(
+        R"({"asset": {"version": "2.0"}, "nodes": [{"children": [1]}]})"));
+}
+
+TEST(gltf_test, textures_prefer_their_ktx2_images)
+{
+    const auto root = json::parse(R"({
+        "asset": {"version": "2.0"},
+        "extensionsRequired": ["KHR_texture_basisu"],
+        "buffers": [{"byteLength": 8}],
+        "bufferViews": [{"buffer": 0, "byteOffset": 2, "byteLength": 4}],
+        "images": [
+            {"uri": "albedo.png"},
+            {"bufferView": 0, "mimeType": "image/ktx2"}],
+        "textures": [
+            {"source": 0,
+             "extensions": {"KHR_texture_basisu": {"source": 1}}},
+            {"source": 0}],
+        "materials": [{"normalTexture": {"index": 0}}, {}]
+    })");
+    ASSERT_TRUE(root);
+    const auto doc = gltf::parse(*root);
+    ASSERT_TRUE(doc);
+
+    EXPECT_EQ(doc->textures[0].image, 1u);
+    EXPECT_EQ(doc->textures[1].image, 0u);
+    EXPECT_TRUE(doc->surfaces[0].features.normal_map);
+    EXPECT_FALSE(doc->surfaces[1].features.normal_map);
+
+    const std::array<std::byte, 8> buffer = {
+        std::byte(0),
+        std::byte(1),
+        std::byte(2),
+        std::byte(3),
+        std::byte(4),
+        std::byte(5),
+        std::byte(6),
+        std::byte(7)};
+    gltf::asset a;
+    a.doc     = *doc;
+    a.buffers = {{buffer.data(), buffer.size()}};
+
+    const auto image = gltf::read_image(a, 1);
+    ASSERT_TRUE(image);
+    EXPECT_EQ(image->data.data, buffer.data() + 2);
+    EXPECT_EQ(image->data.size, 4u);
+
+    // no such file next to the document
+    EXPECT_FALSE(gltf::read_image(a, 0));
+}
+
+TEST(gltf_test, node_transforms_compose)
+{
+    const auto root = json::parse(R"({
+        "asset": {"version": "2.0"},
+        "nodes": [
+            {"translation": [1, 2, 3],
+             "rotation": [0, 0, 0.70710678, 0.70710678],
+             "scale": [2, 2, 2],
+             "children": [1]},
+            {"matrix": [1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 5, 0, 0, 1]}]
+    })");
+    ASSERT_TRUE(root);
+    const auto doc = gltf::parse(*root);
+    ASSERT_TRUE(doc);
+    EXPECT_THAT(doc->roots, testing::ElementsAre(0u));
+
+    // x turns into y, then scales and translates
+    const auto p = gltf::transform_point(doc->nodes[0].local, {1.f, 0.f, 0.f});
+    EXPECT_NEAR(p[0], 1.f, 1e-6f);
+    EXPECT_NEAR(p[1], 4.f, 1e-6f);
+    EXPECT_NEAR(p[2], 3.f, 1e-6f);
+
+    const auto world =
+        gltf::multiply(doc->nodes[0].local, doc->nodes[1].local);
+    const auto q = gltf::transform_point(world, {0.f, 0.f, 0.f});
+    EXPECT_NEAR(q[0], 1.f, 1e-5f);
+    EXPECT_NEAR(q[1], 12.f, 1e-5f);
+    EXPECT_NEAR(q[2], 3.f, 1e-5f);
+}
+
+TEST(gltf_test, decodes_into_the_renderers_axes)
+{
+    const std::string path = "gltf_test_triangle.gltf";
+    write_file(
+        path,
+        triangle_json(
+            R"("uri": "data:application/octet-stream;base64,)" +
+            encode_base64(triangle_buffer()) + R"(", )"));
+
+    const auto a = gltf::load(path);
+    std::remove(path.c_str());
+    ASSERT_TRUE(a);
+
+    const auto p = gltf::place(a->doc);
+    ASSERT_EQ(p.items.size(), 1u);
+    EXPECT_NEAR(p.items[0].radius, 1.f, 1e-5f);
+
+    const auto m = gltf::decode(*a, p, p.items[0]);
+    ASSERT_TRUE(m);
+    ASSERT_EQ(m->vertices.size(), 3u);
+    EXPECT_NEAR(m->radius, 1.f, 1e-5f);
+
+    // centered, scaled into the unit sphere, y and z flipped
+    const auto h = std::sqrt(.5f);
+    EXPECT_NEAR(position(*m, 0)[0], -h, 1e-4f);
+    EXPECT_NEAR(position(*m, 0)[1], h, 1e-4f);
+    EXPECT_NEAR(position(*m, 2)[1], -h, 1e-4f);
+
+    // facing the viewer at -z, clockwise
+    EXPECT_THAT(m->indices, testing::ElementsAre(0u, 2u, 1u));
+    for (size_t i = 0; i != 3; ++i) {
+        EXPECT_NEAR(normal(*m, i)[2], -1.f, 1e-3f);
+    }
+}
+
+TEST(gltf_test, mirrored_nodes_keep_their_front_faces)
+{
+    const std::string path = "gltf_test_mirrored.gltf";
+    write_file(
+        path,
+        triangle_json(
+            R"("uri": "data:application/octet-stream;base64,)" +
+                encode_base64(triangle_buffer()) + R"(", )",
+            R"(, "scale": [-1, 1, 1])"));
+
+    const auto a = gltf::load(path);
+    std::remove(path.c_str());
+    ASSERT_TRUE(a);
+
+    const auto p = gltf::place(a->doc);
+    const auto m = gltf::decode(*a, p, p.items[0]);
+    ASSERT_TRUE(m);
+
+    EXPECT_THAT(m->indices, testing::ElementsAre(0u, 1u, 2u));
+    for (size_t i = 0; i != 3; ++i) {
+        EXPECT_NEAR(normal(*m, i)[2], -1.f, 1e-3f);
+    }
+}
+
+TEST(gltf_test, decode_rejects_attributes_shorter_than_the_positions)
+{
+    // a normal or uv accessor of 2 elements next to the 3 positions
+    const auto decodes = [](const std::string& attribute,
+                            const std::string& type) {
+        auto json = triangle_json(
+            R"("uri": "data:application/octet-stream;base64,)" +
+            encode_base64(triangle_buffer()) + R"(", )");
+        const auto replace = [&json](std::string_view from, std::string to) {
+            json.replace(json.find(from), from.size(), to);
+        };
+        replace(
+            R"("type": "SCALAR"}])",
+            R"("type": "SCALAR"}, {"bufferView": 0, "componentType": 5126,
+                "count": 2, "type": ")" +
+                type + R"("}])");
+        replace(
+            R"("POSITION": 0})",
+            R"("POSITION": 0, ")" + attribute + R"(": 2})");
+
+        const std::string path = "gltf_test_short_attribute.gltf";
+        write_file(path, json);
+        const auto a = gltf::load(path);
+        std::remove(path.c_str());
+        if (!a) { return false; }
+
+        const auto p = gltf::place(a->doc);
+        return p.items.size() == 1 && gltf::decode(*a, p, p.items[0]);
+    };
+
+    EXPECT_FALSE(decodes("NORMAL", "VEC3"));
+    EXPECT_FALSE(decodes("TEXCOORD_0", "VEC2"));
+}
+
+TEST(gltf_test, loads_binary_containers)
+{
+    auto json = triangle_json("");
+    json.resize((json.size() + 3) / 4 * 4, ' ');
+    auto binary = triangle_buffer();
+    binary.resize((binary.size() + 3) / 4 * 4);
+
+    std::string glb;
+    const auto  append = [&](const void* data, size_t size) {
+        glb.append(static_cast<const char*>(data), size);
+    };
+    const std::array<uint32_t, 3> header = {
+        gltf::GLB_MAGIC,
+        2,
+        uint32_t(12 + 8 + json.size() + 8 + binary.size())};
+    const std::array<uint32_t, 2> json_chunk = {
+        uint32_t(json.size()), gltf::GLB_JSON_CHUNK};
+    const std::array<uint32_t, 2> binary_chunk = {
+        uint32_t(binary.size()), gltf::GLB_BIN_CHUNK};
+    append(header.data(), sizeof(header));
+    append(json_chunk.data(), sizeof(json_chunk));
+    append(json.data(), json.size());
+    append(binary_chunk.data(), sizeof(binary_chunk));
+    append(binary.data(), binary.size());
+
+    const std::string path = "gltf_test_triangle.glb";
+    write_file(path, glb);
+
+    {
+        const auto a = gltf::load(path);
+        ASSERT_TRUE(a);
+
+        const auto p = gltf::place(a->doc);
+        const auto m = gltf::decode(*a, p, p.items[0]);
+        ASSERT_TRUE(m);
+        EXPECT_EQ(m->vertices.size(), 3u);
+    }
+
+    // a chunk running past the end of the file
+    write_file(path, glb.substr(0, glb.size() - 4));
+    EXPECT_FALSE(gltf::load(path));
+
+    std::remove(path.c_str());
+}
+
+} // namespace
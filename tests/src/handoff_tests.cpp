@@ -0,0 +1,48 @@
+#include <gmock/gmock.h>
+
+#include "handoff.hpp"
+
+namespace {
+
+struct fake_batch {
+    int      id;
+    bool     awaiting_consumer = true;
+    uint64_t consumer_value    = 0;
+};
+
+TEST(handoff_test, batches_finished_before_any_acquire_keep_waiting)
+{
+    // uploads flushed at startup finish their copies before a frame has
+    // recorded the acquire, when there is no consumer timeline yet
+    std::vector<fake_batch> consuming = {{0}, {1}};
+    std::vector<fake_batch> idle;
+
+    bool queried = false;
+    handoff::recycle_consumed(consuming, idle, [&queried] {
+        queried = true;
+        return uint64_t(0);
+    });
+
+    EXPECT_FALSE(queried);
+    EXPECT_EQ(consuming.size(), 2u);
+    EXPECT_TRUE(idle.empty());
+}
+
+TEST(handoff_test, batches_recycle_once_their_consumer_signaled)
+{
+    std::vector<fake_batch> consuming = {
+        {0, true, 3}, {1, true, 5}, {2, true, 0}};
+    std::vector<fake_batch> idle;
+
+    handoff::recycle_consumed(consuming, idle, [] { return uint64_t(4); });
+
+    ASSERT_EQ(idle.size(), 1u);
+    EXPECT_EQ(idle[0].id, 0);
+    EXPECT_FALSE(idle[0].awaiting_consumer);
+
+    ASSERT_EQ(consuming.size(), 2u);
+    EXPECT_EQ(consuming[0].id, 1);
+    EXPECT_EQ(consuming[1].id, 2);
+}
+
+} // namespace
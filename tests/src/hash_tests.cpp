@@ -0,0 +1,29 @@
+#include <gmock/gmock.h>
+
+#include "hash.hpp"
+
+namespace {
+
+TEST(hash_test, fnv1a_matches_reference_values)
+{
+    EXPECT_EQ(hash::fnv1a_string(""), 0xcbf29ce484222325ull);
+    EXPECT_EQ(hash::fnv1a_string("a"), 0xaf63dc4c8601ec8cull);
+    EXPECT_EQ(hash::fnv1a_string("foobar"), 0x85944171f73967e8ull);
+}
+
+TEST(hash_test, fnv1a_chains_like_concatenation)
+{
+    EXPECT_EQ(
+        hash::fnv1a_string("bar", hash::fnv1a_string("foo")),
+        hash::fnv1a_string("foobar"));
+}
+
+TEST(hash_test, fnv1a_hashes_raw_bytes)
+{
+    const unsigned char bytes[] = {'f', 'o', 'o', 'b', 'a', 'r'};
+
+    EXPECT_EQ(
+        hash::fnv1a(bytes, sizeof(bytes)), hash::fnv1a_string("foobar"));
+}
+
+} // namespace
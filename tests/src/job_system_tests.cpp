@@ -0,0 +1,66 @@
+#include <atomic>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "job_system.hpp"
+
+namespace {
+
+TEST(job_system_test, parallel_for_covers_every_element_once)
+{
+    jobs::pool pool(4);
+
+    std::vector<int> visits(1000, 0);
+    pool.parallel_for(visits.size(), 16, [&visits](size_t, jobs::range r) {
+        for (auto i = r.begin; i != r.end; ++i) { ++visits[i]; }
+    });
+
+    EXPECT_THAT(visits, testing::Each(1));
+}
+
+TEST(job_system_test, parallel_for_never_inverts_a_chunk)
+{
+    // neither count is a multiple of the step the pool size gives
+    const std::vector<std::pair<size_t, size_t>> cases = {{4, 5}, {16, 24}};
+    for (const auto& [threads, count] : cases) {
+        jobs::pool pool(threads);
+
+        std::vector<int> visits(count, 0);
+        std::vector<int> chunks(pool.chunk_count(count, 1), 0);
+        pool.parallel_for(count, 1, [&](size_t, jobs::range r) {
+            ASSERT_LT(r.begin, r.end);
+            ASSERT_LE(r.end, count);
+            ++chunks[r.chunk];
+            for (auto i = r.begin; i != r.end; ++i) { ++visits[i]; }
+        });
+
+        EXPECT_THAT(visits, testing::Each(1));
+        EXPECT_THAT(chunks, testing::Each(1));
+    }
+}
+
+TEST(job_system_test, chunk_count_respects_grain_and_pool_size)
+{
+    jobs::pool pool(4);
+
+    EXPECT_EQ(pool.chunk_count(10, 256), 1u);
+    EXPECT_EQ(pool.chunk_count(512, 256), 2u);
+    EXPECT_EQ(pool.chunk_count(100000, 256), 4u);
+    EXPECT_EQ(pool.chunk_count(5, 1), 3u);
+}
+
+TEST(job_system_test, wait_drains_submitted_tasks)
+{
+    jobs::pool pool(2);
+
+    std::atomic<int> counter{0};
+    for (int i = 0; i != 100; ++i) {
+        pool.submit([&counter](size_t) { ++counter; });
+    }
+    pool.wait();
+
+    EXPECT_EQ(counter, 100);
+}
+
+} // namespace
@@ -0,0 +1,81 @@
+#include <gmock/gmock.h>
+
+#include "json.hpp"
+
+namespace {
+
+TEST(json_test, parses_nested_documents)
+{
+    const auto v = json::parse(
+        R"({"a": [1, -2.5e1, true, null], "b": {"c": "d"}, "e": false})");
+    ASSERT_TRUE(v);
+
+    EXPECT_EQ(v->kind(), json::type::object);
+    EXPECT_EQ(v->size(), 3u);
+    EXPECT_THAT(v->keys(), testing::ElementsAre("a", "b", "e"));
+
+    const auto& a = (*v)["a"];
+    EXPECT_EQ(a.size(), 4u);
+    EXPECT_EQ(a[0].number(), 1.);
+    EXPECT_EQ(a[1].number(), -25.);
+    EXPECT_TRUE(a[2].boolean());
+    EXPECT_TRUE(a[3].is_null());
+    EXPECT_EQ((*v)["b"]["c"].string(), "d");
+    EXPECT_FALSE((*v)["e"].boolean(true));
+}
+
+TEST(json_test, missing_members_fall_back)
+{
+    const auto v = json::parse(R"({"n": 3, "s": "x"})");
+    ASSERT_TRUE(v);
+
+    EXPECT_TRUE((*v)["missing"]["deeper"][4].is_null());
+    EXPECT_EQ((*v)["missing"].number(7.), 7.);
+    EXPECT_EQ((*v)["s"].number(7.), 7.);
+    EXPECT_EQ((*v)["n"].string("y"), "y");
+    EXPECT_EQ((*v)["n"][0].kind(), json::type::null);
+}
+
+TEST(json_test, indices_are_nonnegative_integers)
+{
+    const auto v = json::parse("[0, 7, 4294967295, -1, 1.5, 4294967296]");
+    ASSERT_TRUE(v);
+
+    EXPECT_EQ((*v)[0].index(9), 0u);
+    EXPECT_EQ((*v)[1].index(9), 7u);
+    EXPECT_EQ((*v)[2].index(9), 4294967295u);
+    EXPECT_EQ((*v)[3].index(9), 9u);
+    EXPECT_EQ((*v)[4].index(9), 9u);
+    EXPECT_EQ((*v)[5].index(9), 9u);
+}
+
+TEST(json_test, decodes_string_escapes)
+{
+    const auto v = json::parse(R"("a\"\\\/\né€😀")");
+    ASSERT_TRUE(v);
+
+    EXPECT_EQ(v->string(), "a\"\\/\n\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+}
+
+TEST(json_test, rejects_malformed_documents)
+{
+    for (const char* text :
+         {"",
+          "{",
+          "[1,]",
+          R"({"a" 1})",
+          R"({"a": 1} x)",
+          "tru",
+          R"("unterminated)",
+          R"("\x")",
+          R"("\ud83dA")",
+          "1e",
+          "-"}) {
+        EXPECT_FALSE(json::parse(text)) << text;
+    }
+
+    EXPECT_FALSE(json::parse(std::string(1000, '[') + std::string(1000, ']')));
+    EXPECT_TRUE(json::parse(std::string(100, '[') + std::string(100, ']')));
+}
+
+} // namespace
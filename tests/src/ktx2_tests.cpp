@@ -0,0 +1,112 @@
+#include <gmock/gmock.h>
+
+#include "ktx2.hpp"
+
+namespace {
+
+// a BC7 mip chain of `width` x `height`, each level filled with its index
+std::vector<std::vector<std::byte>>
+bc7_levels(uint32_t width, uint32_t height)
+{
+    const auto block = *ktx2::shape(ktx2::BC7_UNORM);
+
+    std::vector<std::vector<std::byte>> levels;
+    for (size_t i = 0; (std::max(width, height) >> i) != 0; ++i) {
+        levels.emplace_back(
+            ktx2::level_size(
+                block, ktx2::mip_extent(width, i), ktx2::mip_extent(height, i)),
+            std::byte(i));
+    }
+    return levels;
+}
+
+template <typename T>
+void
+patch(std::vector<std::byte>& file, size_t offset, T value)
+{
+    std::memcpy(file.data() + offset, &value, sizeof(value));
+}
+
+TEST(ktx2_test, describes_block_formats)
+{
+    const auto bc1 = ktx2::shape(ktx2::BC1_RGBA_SRGB);
+    ASSERT_TRUE(bc1);
+    EXPECT_EQ(bc1->size, 8u);
+    EXPECT_EQ(ktx2::shape(ktx2::BC4_SNORM)->size, 8u);
+    EXPECT_EQ(ktx2::shape(ktx2::BC5_UNORM)->size, 16u);
+
+    // ASTC 6x6 SRGB
+    const auto astc = ktx2::shape(166);
+    ASSERT_TRUE(astc);
+    EXPECT_EQ(astc->width, 6u);
+    EXPECT_EQ(astc->height, 6u);
+    EXPECT_TRUE(ktx2::is_srgb(166));
+    EXPECT_FALSE(ktx2::is_srgb(165));
+
+    EXPECT_FALSE(ktx2::shape(ktx2::FORMAT_UNDEFINED));
+    EXPECT_EQ(ktx2::decodable(ktx2::BC7_SRGB), bcn::format::bc7);
+    EXPECT_EQ(ktx2::decodable(ktx2::BC1_RGB_SRGB), bcn::format::bc1_rgb);
+    EXPECT_EQ(ktx2::decodable(ktx2::BC1_RGBA_SRGB), bcn::format::bc1);
+    EXPECT_FALSE(ktx2::decodable(ktx2::BC6H_UFLOAT));
+    EXPECT_FALSE(ktx2::decodable(ktx2::ASTC_4x4_UNORM));
+
+    // 3 x 2 blocks, the edge ones partial
+    EXPECT_EQ(ktx2::level_size(*bc1, 9, 5), 6u * 8);
+}
+
+TEST(ktx2_test, round_trips_a_mip_chain)
+{
+    const auto levels = bc7_levels(20, 8);
+    ASSERT_EQ(levels.size(), 5u);
+
+    const auto file = ktx2::serialize(ktx2::BC7_SRGB, 20, 8, levels);
+    const auto t    = ktx2::parse(file.data(), file.size());
+    ASSERT_TRUE(t);
+    EXPECT_EQ(t->format, ktx2::BC7_SRGB);
+    EXPECT_EQ(t->supercompression, ktx2::SUPERCOMPRESSION_NONE);
+    ASSERT_EQ(t->levels.size(), levels.size());
+
+    for (size_t i = 0; i != levels.size(); ++i) {
+        const auto& l = t->levels[i];
+        EXPECT_EQ(l.width, ktx2::mip_extent(20, i));
+        EXPECT_EQ(l.height, ktx2::mip_extent(8, i));
+        ASSERT_EQ(l.size, levels[i].size());
+        EXPECT_EQ(std::memcmp(l.data, levels[i].data(), l.size), 0);
+
+        // aligned for the copies out of the staging ring
+        EXPECT_EQ((l.data - file.data()) % 16, 0);
+    }
+}
+
+TEST(ktx2_test, rejects_malformed_files)
+{
+    const auto file = ktx2::serialize(ktx2::BC7_UNORM, 8, 8, bc7_levels(8, 8));
+    ASSERT_TRUE(ktx2::parse(file.data(), file.size()));
+
+    const auto rejects = [&](auto change) {
+        auto copy = file;
+        change(copy);
+        return !ktx2::parse(copy.data(), copy.size());
+    };
+
+    EXPECT_TRUE(rejects([](auto& f) { f[1] = std::byte('k'); }));
+    EXPECT_TRUE(rejects([](auto& f) { f.resize(f.size() - 1); }));
+    EXPECT_TRUE(rejects([](auto& f) { f.resize(90); }));
+
+    // a cube map, an array, a volume
+    EXPECT_TRUE(rejects([](auto& f) { patch(f, 36, 6u); }));
+    EXPECT_TRUE(rejects([](auto& f) { patch(f, 32, 2u); }));
+    EXPECT_TRUE(rejects([](auto& f) { patch(f, 28, 4u); }));
+
+    // more levels than the extent has, a level too small for its extent
+    EXPECT_TRUE(rejects([](auto& f) { patch(f, 40, 5u); }));
+    EXPECT_TRUE(rejects([](auto& f) { patch(f, 88, uint64_t(32)); }));
+
+    // supercompressed levels are left to the caller to check
+    EXPECT_FALSE(rejects([](auto& f) {
+        patch(f, 44, ktx2::SUPERCOMPRESSION_ZSTD);
+        patch(f, 88, uint64_t(32));
+    }));
+}
+
+} // namespace
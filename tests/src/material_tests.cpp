@@ -0,0 +1,92 @@
+#include <gmock/gmock.h>
+
+#include "material.hpp"
+
+namespace {
+
+TEST(material_test, resolve_maps_features_to_constants)
+{
+    material::feature_set features;
+    features.clearcoat = true;
+    features.alpha     = material::alpha_mode::mask;
+
+    const auto state = material::resolve(features);
+
+    EXPECT_EQ(state.constants[material::NORMAL_MAP_CONSTANT], 0u);
+    EXPECT_EQ(state.constants[material::CLEARCOAT_CONSTANT], 1u);
+    EXPECT_EQ(state.constants[material::ALPHA_MODE_CONSTANT], 1u);
+    EXPECT_EQ(state.blend, 0u);
+    EXPECT_EQ(state.double_sided, 0u);
+}
+
+TEST(material_test, only_alpha_blend_enables_blending)
+{
+    material::feature_set features;
+    features.alpha = material::alpha_mode::blend;
+
+    EXPECT_EQ(material::resolve(features).blend, 1u);
+}
+
+TEST(material_test, identical_features_share_a_permutation)
+{
+    material::library library;
+
+    material::feature_set glossy;
+    glossy.clearcoat = true;
+
+    material::feature_set cutout;
+    cutout.alpha        = material::alpha_mode::mask;
+    cutout.double_sided = true;
+
+    const auto a = library.add("car paint", glossy);
+    const auto b = library.add("leaves", cutout);
+    const auto c = library.add("lacquer", glossy);
+
+    EXPECT_EQ(library.size(), 3u);
+    EXPECT_EQ(library.states().size(), 2u);
+    EXPECT_EQ(library.permutation(a), library.permutation(c));
+    EXPECT_NE(library.permutation(a), library.permutation(b));
+    EXPECT_EQ(library.name(b), "leaves");
+}
+
+TEST(material_test, parameters_are_kept_per_material)
+{
+    material::library library;
+
+    material::parameters red;
+    red.base_color = {1.f, 0.f, 0.f, 1.f};
+
+    material::parameters rough;
+    rough.roughness = 1.f;
+
+    const auto a = library.add("red", material::feature_set(), red);
+    const auto b = library.add("rough", material::feature_set(), rough);
+
+    EXPECT_EQ(library.permutation(a), library.permutation(b));
+    EXPECT_EQ(library.parameters(a).base_color[1], 0.f);
+    EXPECT_EQ(library.parameters(b).roughness, 1.f);
+    EXPECT_EQ(library.parameters(b).base_color_texture, material::NO_TEXTURE);
+}
+
+TEST(material_test, every_feature_combination_is_distinct)
+{
+    material::library library;
+
+    for (int bits = 0; bits != 8; ++bits) {
+        for (auto alpha : {material::alpha_mode::opaque,
+                           material::alpha_mode::mask,
+                           material::alpha_mode::blend}) {
+            material::feature_set features;
+            features.normal_map   = bits & 1;
+            features.clearcoat    = bits & 2;
+            features.double_sided = bits & 4;
+            features.alpha        = alpha;
+            library.add("material", features);
+        }
+    }
+
+    EXPECT_EQ(library.size(), 24u);
+    EXPECT_EQ(library.states().size(), 24u);
+}
+
+} // namespace
@@ -0,0 +1,154 @@
+#include <cstdio>
+
+#include <gmock/gmock.h>
+
+#include "mesh_file.hpp"
+
+namespace {
+
+// a grid of `size` x `size` quads in the z = 0 plane
+void
+make_grid(
+    uint32_t                      size,
+    std::vector<mesh_file::vertex>& vertices,
+    std::vector<uint32_t>&          indices)
+{
+    for (uint32_t y = 0; y <= size; ++y) {
+        for (uint32_t x = 0; x <= size; ++x) {
+            const auto u = float(x) / float(size);
+            const auto v = float(y) / float(size);
+            vertices.push_back(mesh_file::pack(
+                {u * 2.f - 1.f, v * 2.f - 1.f, 0.f}, {0.f, 0.f, -1.f}, {u, v}));
+        }
+    }
+
+    for (uint32_t y = 0; y != size; ++y) {
+        for (uint32_t x = 0; x != size; ++x) {
+            const auto corner = y * (size + 1) + x;
+            indices.insert(
+                end(indices),
+                {corner,
+                 corner + 1,
+                 corner + size + 2,
+                 corner,
+                 corner + size + 2,
+                 corner + size + 1});
+        }
+    }
+}
+
+TEST(mesh_file_test, half_round_trips)
+{
+    for (float value : {0.f, -0.f, 1.f, -2.5f, .1f, 65504.f, 6e-8f, 1e-5f}) {
+        EXPECT_NEAR(
+            mesh_file::from_half(mesh_file::to_half(value)),
+            value,
+            std::fabs(value) * 1e-3f + 6e-8f);
+    }
+
+    EXPECT_EQ(mesh_file::to_half(1.f), 0x3c00);
+    EXPECT_EQ(mesh_file::to_half(1e6f), 0x7c00);
+    EXPECT_TRUE(std::isnan(mesh_file::from_half(mesh_file::to_half(NAN))));
+}
+
+TEST(mesh_file_test, octahedral_normals_round_trip)
+{
+    for (int i = 0; i != 1'000; ++i) {
+        const auto theta = float(i) * .7f;
+        const auto phi   = float(i) * .013f;
+
+        const std::array<float, 3> normal = {
+            std::sin(phi) * std::cos(theta),
+            std::sin(phi) * std::sin(theta),
+            std::cos(phi)};
+        const auto decoded =
+            mesh_file::decode_octahedral(mesh_file::encode_octahedral(normal));
+
+        for (size_t axis = 0; axis != 3; ++axis) {
+            EXPECT_NEAR(decoded[axis], normal[axis], 1e-3f);
+        }
+    }
+}
+
+TEST(mesh_file_test, meshlets_cover_every_triangle_within_limits)
+{
+    std::vector<mesh_file::vertex> vertices;
+    std::vector<uint32_t>          indices;
+    make_grid(40, vertices, indices);
+
+    const auto meshlets = mesh_file::build_meshlets(vertices, indices);
+
+    uint32_t next = 0;
+    for (const auto& m : meshlets) {
+        EXPECT_EQ(m.first_index, next);
+        EXPECT_LE(m.triangle_count, mesh_file::MAX_MESHLET_TRIANGLES);
+        EXPECT_LE(m.vertex_count, mesh_file::MAX_MESHLET_VERTICES);
+
+        for (auto i = m.first_index; i != next + 3 * m.triangle_count; ++i) {
+            const auto p  = mesh_file::unpack_position(vertices[indices[i]]);
+            const auto dx = p[0] - m.center[0];
+            const auto dy = p[1] - m.center[1];
+            EXPECT_LE(std::sqrt(dx * dx + dy * dy), m.radius + 1e-5f);
+        }
+
+        next += 3 * m.triangle_count;
+    }
+    EXPECT_EQ(next, indices.size());
+}
+
+TEST(mesh_file_test, written_files_map_back)
+{
+    std::vector<mesh_file::vertex> vertices;
+    std::vector<uint32_t>          indices;
+    make_grid(8, vertices, indices);
+    const auto meshlets = mesh_file::build_meshlets(vertices, indices);
+
+    const std::string path = "mesh_file_test.mesh";
+    ASSERT_TRUE(mesh_file::write(path, vertices, indices, meshlets));
+
+    {
+        const auto file = mesh_file::mapped_file::open(path);
+        ASSERT_TRUE(file);
+
+        const auto c = mesh_file::parse(file->data(), file->size());
+        ASSERT_TRUE(c);
+        EXPECT_FLOAT_EQ(c->radius, std::sqrt(2.f));
+        ASSERT_EQ(c->vertex_count, vertices.size());
+        ASSERT_EQ(c->index_count, indices.size());
+        ASSERT_EQ(c->meshlet_count, meshlets.size());
+        EXPECT_EQ(
+            std::memcmp(
+                c->vertices,
+                vertices.data(),
+                sizeof(mesh_file::vertex) * vertices.size()),
+            0);
+        EXPECT_TRUE(std::equal(begin(indices), end(indices), c->indices));
+        EXPECT_EQ(c->meshlets[0].triangle_count, meshlets[0].triangle_count);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(mesh_file_test, parse_rejects_foreign_and_truncated_data)
+{
+    std::vector<mesh_file::vertex> vertices;
+    std::vector<uint32_t>          indices;
+    make_grid(2, vertices, indices);
+
+    mesh_file::header h;
+    h.vertex_count  = uint32_t(vertices.size());
+    h.vertex_offset = mesh_file::align_section(sizeof(h));
+
+    std::vector<std::byte> data(
+        h.vertex_offset + sizeof(mesh_file::vertex) * vertices.size());
+    std::memcpy(data.data(), &h, sizeof(h));
+    EXPECT_TRUE(mesh_file::parse(data.data(), data.size()));
+
+    EXPECT_FALSE(mesh_file::parse(data.data(), data.size() - 1));
+    EXPECT_FALSE(mesh_file::parse(data.data(), sizeof(h) - 1));
+
+    data[0] = std::byte{'X'};
+    EXPECT_FALSE(mesh_file::parse(data.data(), data.size()));
+}
+
+} // namespace
@@ -0,0 +1,58 @@
+#include <sstream>
+
+#include <gmock/gmock.h>
+
+#include "obj.hpp"
+
+namespace {
+
+std::optional<obj::mesh>
+parse(const std::string& text)
+{
+    std::istringstream in(text);
+    return obj::parse(in);
+}
+
+// three positions, uvs and normals, so every index resolves
+constexpr std::string_view VERTICES = "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+                                      "vt 0 0\nvt 1 0\nvt 0 1\n"
+                                      "vn 0 0 1\nvn 0 1 0\nvn 1 0 0\n";
+
+TEST(obj_test, parses_every_corner_form)
+{
+    const auto m = parse(std::string(VERTICES) + "f 1 2/3 3//2\n");
+    ASSERT_TRUE(m);
+    ASSERT_EQ(m->corners.size(), 3u);
+
+    EXPECT_EQ(m->corners[0], (obj::corner{0, -1, -1}));
+    EXPECT_EQ(m->corners[1], (obj::corner{1, 2, -1}));
+    EXPECT_EQ(m->corners[2], (obj::corner{2, -1, 1}));
+
+    const auto full = parse(std::string(VERTICES) + "f 1/3/2 2/1/3 -1/-2/-3\n");
+    ASSERT_TRUE(full);
+    EXPECT_EQ(full->corners[0], (obj::corner{0, 2, 1}));
+    EXPECT_EQ(full->corners[2], (obj::corner{2, 1, 0}));
+}
+
+TEST(obj_test, triangulates_polygons_as_fans)
+{
+    const auto m =
+        parse("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 .25\nf 1 2 3 4\n");
+    ASSERT_TRUE(m);
+    ASSERT_EQ(m->corners.size(), 6u);
+    EXPECT_EQ(m->corners[3].position, 0);
+    EXPECT_EQ(m->corners[4].position, 2);
+    EXPECT_EQ(m->corners[5].position, 3);
+
+    // flipped for Vulkan
+    EXPECT_FLOAT_EQ(m->uvs[0][1], .75f);
+}
+
+TEST(obj_test, rejects_missing_vertices)
+{
+    EXPECT_FALSE(parse(std::string(VERTICES) + "f 1 2 4\n"));
+    EXPECT_FALSE(parse(std::string(VERTICES) + "f 1//4 2 3\n"));
+    EXPECT_FALSE(parse(std::string(VERTICES) + "f 1/4 2 3\n"));
+}
+
+} // namespace
@@ -0,0 +1,40 @@
+#include <gmock/gmock.h>
+
+#include "sample_window.hpp"
+
+namespace {
+
+TEST(sample_window_test, summarizes_samples)
+{
+    sample_window window(100);
+    for (int i = 1; i <= 100; ++i) { window.add(i); }
+
+    EXPECT_EQ(window.size(), 100u);
+    EXPECT_DOUBLE_EQ(window.min(), 1.0);
+    EXPECT_DOUBLE_EQ(window.max(), 100.0);
+    EXPECT_DOUBLE_EQ(window.average(), 50.5);
+    EXPECT_DOUBLE_EQ(window.percentile(50), 50.0);
+    EXPECT_DOUBLE_EQ(window.percentile(99), 99.0);
+    EXPECT_DOUBLE_EQ(window.percentile(100), 100.0);
+}
+
+TEST(sample_window_test, keeps_only_the_most_recent_samples)
+{
+    sample_window window(4);
+    for (int i = 1; i <= 10; ++i) { window.add(i); }
+
+    EXPECT_EQ(window.size(), 4u);
+    EXPECT_DOUBLE_EQ(window.min(), 7.0);
+    EXPECT_DOUBLE_EQ(window.max(), 10.0);
+}
+
+TEST(sample_window_test, empty_window_reports_zero)
+{
+    sample_window window;
+
+    EXPECT_TRUE(window.empty());
+    EXPECT_DOUBLE_EQ(window.average(), 0.0);
+    EXPECT_DOUBLE_EQ(window.percentile(99), 0.0);
+}
+
+} // namespace
@@ -0,0 +1,128 @@
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "scene_graph.hpp"
+
+namespace {
+
+scene::affine
+translation(float x, float y, float z)
+{
+    return {1.f, 0.f, 0.f, x, 0.f, 1.f, 0.f, y, 0.f, 0.f, 1.f, z};
+}
+
+// quarter turn around z, scaled by `s`
+scene::affine
+quarter_turn(float s)
+{
+    return {0.f, -s, 0.f, 0.f, s, 0.f, 0.f, 0.f, 0.f, 0.f, s, 0.f};
+}
+
+scene::affine
+multiply(const scene::affine& a, const scene::affine& b)
+{
+    scene::affine m;
+    for (size_t r = 0; r != 3; ++r) {
+        for (size_t c = 0; c != 4; ++c) {
+            m[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c] +
+                           a[r * 4 + 2] * b[8 + c] +
+                           (c == 3 ? a[r * 4 + 3] : 0.f);
+        }
+    }
+    return m;
+}
+
+const scene::aabb UNIT_BOX = {{-1.f, -1.f, -1.f}, {1.f, 1.f, 1.f}};
+
+TEST(scene_graph_test, children_inherit_their_parents_transform)
+{
+    scene::hierarchy h;
+    const auto root       = h.add(scene::NO_PARENT, translation(1, 0, 0), {});
+    const auto child      = h.add(root, translation(0, 2, 0), {});
+    const auto grandchild = h.add(child, translation(0, 0, 3), {});
+    h.update();
+
+    EXPECT_THAT(h.world(root), testing::ElementsAreArray(translation(1, 0, 0)));
+    EXPECT_THAT(
+        h.world(grandchild), testing::ElementsAreArray(translation(1, 2, 3)));
+    EXPECT_EQ(h.parent(grandchild), child);
+    EXPECT_EQ(h.parent(root), scene::NO_PARENT);
+}
+
+TEST(scene_graph_test, world_bounds_enclose_the_transformed_box)
+{
+    scene::hierarchy h;
+    const auto root = h.add(scene::NO_PARENT, quarter_turn(2), {});
+    const auto node = h.add(
+        root, translation(1, 0, 0), {{0.f, 0.f, 0.f}, {1.f, 2.f, 3.f}});
+    h.update();
+
+    // x in [1, 2], y in [0, 2] turned and scaled to x in [-4, 0], y in
+    // [2, 4]
+    const auto bounds = h.world_bounds(node);
+    EXPECT_THAT(bounds.min, testing::ElementsAre(-4.f, 2.f, 0.f));
+    EXPECT_THAT(bounds.max, testing::ElementsAre(0.f, 4.f, 6.f));
+}
+
+TEST(scene_graph_test, update_touches_dirty_subtrees_only)
+{
+    scene::hierarchy h;
+    const auto root = h.add(scene::NO_PARENT, scene::IDENTITY, UNIT_BOX);
+    const auto a    = h.add(root, translation(1, 0, 0), UNIT_BOX);
+    for (int i = 0; i != 10; ++i) { h.add(a, scene::IDENTITY, UNIT_BOX); }
+    const auto b = h.add(root, translation(2, 0, 0), UNIT_BOX);
+    for (int i = 0; i != 20; ++i) { h.add(b, scene::IDENTITY, UNIT_BOX); }
+    h.update();
+    EXPECT_EQ(h.updated_count(), h.size());
+
+    h.update();
+    EXPECT_EQ(h.updated_count(), 0u);
+
+    h.set_local(a, translation(5, 0, 0));
+    h.set_local(a + 3, translation(0, 1, 0));
+    h.update();
+    EXPECT_EQ(h.updated_count(), 11u);
+    EXPECT_EQ(h.subtree_end(a), b);
+    EXPECT_FLOAT_EQ(h.world(a + 3)[3], 5.f);
+    EXPECT_FLOAT_EQ(h.world(a + 3)[7], 1.f);
+    EXPECT_FLOAT_EQ(h.world(b + 1)[3], 2.f);
+}
+
+// wide batches and the scalar fallback against a plain recursive product
+TEST(scene_graph_test, update_matches_reference_on_mixed_trees)
+{
+    scene::hierarchy h;
+    std::vector<scene::affine> reference;
+
+    // chains (scalar) alternating with wide fans (batched)
+    for (uint32_t tree = 0; tree != 8; ++tree) {
+        auto node = h.add(scene::NO_PARENT, quarter_turn(1.5f), UNIT_BOX);
+        reference.push_back(quarter_turn(1.5f));
+
+        for (uint32_t depth = 0; depth != 5; ++depth) {
+            const auto local = translation(float(depth), 1.f, float(tree));
+            const auto child = h.add(node, local, UNIT_BOX);
+            reference.push_back(multiply(reference[node], local));
+            node = child;
+        }
+
+        for (uint32_t leaf = 0; leaf != 37; ++leaf) {
+            const auto local = multiply(
+                quarter_turn(.5f), translation(float(leaf), 0.f, 1.f));
+            h.add(node, local, UNIT_BOX);
+            reference.push_back(multiply(reference[node], local));
+        }
+    }
+    h.update();
+
+    ASSERT_EQ(h.size(), reference.size());
+    for (uint32_t node = 0; node != h.size(); ++node) {
+        const auto world = h.world(node);
+        for (size_t k = 0; k != 12; ++k) {
+            EXPECT_NEAR(world[k], reference[node][k], 1e-4f) << node;
+        }
+    }
+}
+
+} // namespace
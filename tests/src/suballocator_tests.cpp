@@ -0,0 +1,93 @@
+#include <gmock/gmock.h>
+
+#include "suballocator.hpp"
+
+namespace {
+
+TEST(suballocator_test, buddy_allocations_are_aligned_and_disjoint)
+{
+    memory::buddy_allocator buddy(1 << 20);
+
+    auto a = buddy.allocate(1000, 256);
+    auto b = buddy.allocate(4096, 4096);
+    auto c = buddy.allocate(300, 1);
+
+    ASSERT_TRUE(a && b && c);
+    EXPECT_EQ(*b % 4096, 0u);
+    EXPECT_NE(*a, *c);
+    EXPECT_EQ(buddy.used(), 1024u + 4096u + 512u);
+}
+
+TEST(suballocator_test, buddy_merges_freed_blocks)
+{
+    memory::buddy_allocator buddy(1 << 16);
+
+    auto a = buddy.allocate(1 << 14);
+    auto b = buddy.allocate(1 << 14);
+    ASSERT_TRUE(a && b);
+    EXPECT_EQ(buddy.largest_free(), 1u << 15);
+
+    buddy.free(*a, 1 << 14);
+    buddy.free(*b, 1 << 14);
+    EXPECT_EQ(buddy.largest_free(), 1u << 16);
+    EXPECT_EQ(buddy.used(), 0u);
+}
+
+TEST(suballocator_test, buddy_rejects_oversized_requests)
+{
+    memory::buddy_allocator buddy(1 << 12);
+
+    EXPECT_FALSE(buddy.allocate(1 << 13));
+    EXPECT_TRUE(buddy.allocate(1 << 12));
+    EXPECT_FALSE(buddy.allocate(1));
+}
+
+TEST(suballocator_test, linear_reclaims_after_last_free)
+{
+    memory::linear_allocator linear(1024);
+
+    auto a = linear.allocate(100, 1);
+    auto b = linear.allocate(100, 256);
+    ASSERT_TRUE(a && b);
+    EXPECT_EQ(*b, 256u);
+    EXPECT_FALSE(linear.allocate(1024));
+
+    linear.free(*a, 100);
+    linear.free(*b, 100);
+    EXPECT_EQ(linear.largest_free(), 1024u);
+}
+
+TEST(suballocator_test, free_list_reuses_and_merges_freed_ranges)
+{
+    memory::free_list_allocator list(1000);
+
+    auto a = list.allocate(300);
+    auto b = list.allocate(500);
+    auto c = list.allocate(200);
+    ASSERT_TRUE(a && b && c);
+    EXPECT_EQ(*b, 300u);
+    EXPECT_FALSE(list.allocate(1));
+
+    // the freed middle is reused first fit, with its tail left free
+    list.free(*b, 500);
+    auto d = list.allocate(100, 64);
+    ASSERT_TRUE(d);
+    EXPECT_EQ(*d, 320u);
+    EXPECT_EQ(list.largest_free(), 380u);
+
+    list.free(*a, 300);
+    list.free(*d, 100);
+    list.free(*c, 200);
+    EXPECT_EQ(list.largest_free(), 1000u);
+    EXPECT_EQ(list.used(), 0u);
+    EXPECT_EQ(list.allocation_count(), 0u);
+}
+
+TEST(suballocator_test, fragmentation_of_contiguous_space_is_zero)
+{
+    EXPECT_DOUBLE_EQ(memory::fragmentation(0, 0), 0.0);
+    EXPECT_DOUBLE_EQ(memory::fragmentation(1024, 1024), 0.0);
+    EXPECT_DOUBLE_EQ(memory::fragmentation(1024, 256), 0.75);
+}
+
+} // namespace
@@ -0,0 +1,48 @@
+#include <gmock/gmock.h>
+
+#include "swatch.hpp"
+
+namespace {
+
+TEST(swatch_test, grid_fits_every_swatch)
+{
+    for (uint32_t count : {1u, 7u, 100u, 1'000u, 50'000u}) {
+        const swatch::grid grid(count, 1920, 1080);
+
+        EXPECT_GE(grid.columns() * grid.rows(), count);
+        EXPECT_LT((grid.rows() - 1) * grid.columns(), count);
+    }
+}
+
+TEST(swatch_test, grid_is_square_on_square_targets)
+{
+    const swatch::grid grid(100, 512, 512);
+
+    EXPECT_EQ(grid.columns(), 10u);
+    EXPECT_EQ(grid.rows(), 10u);
+}
+
+TEST(swatch_test, place_centers_swatches_in_their_cells)
+{
+    const swatch::grid grid(4, 100, 100);
+
+    const auto first = grid.place(0, 7);
+    EXPECT_FLOAT_EQ(first.offset_scale[0], -.5f);
+    EXPECT_FLOAT_EQ(first.offset_scale[1], -.5f);
+    EXPECT_EQ(first.material, 7u);
+
+    const auto last = grid.place(3, 9);
+    EXPECT_FLOAT_EQ(last.offset_scale[0], .5f);
+    EXPECT_FLOAT_EQ(last.offset_scale[1], .5f);
+    EXPECT_FLOAT_EQ(last.offset_scale[2], swatch::FILL / 2);
+}
+
+TEST(swatch_test, place_keeps_swatches_round)
+{
+    const swatch::grid grid(10, 1920, 1080);
+
+    const auto i = grid.place(0, 0);
+    EXPECT_FLOAT_EQ(i.offset_scale[2] * 1920, i.offset_scale[3] * 1080);
+}
+
+} // namespace
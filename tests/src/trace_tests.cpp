@@ -0,0 +1,93 @@
+#define MATERIALIST_TRACE 1
+
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <thread>
+
+#include "trace.hpp"
+
+namespace {
+
+using ::testing::HasSubstr;
+
+size_t
+count(const std::string& text, std::string_view needle)
+{
+    size_t n = 0;
+    for (auto pos = text.find(needle); pos != std::string::npos;
+         pos      = text.find(needle, pos + needle.size())) {
+        ++n;
+    }
+    return n;
+}
+
+TEST(trace_test, records_nested_zones)
+{
+    trace::clear();
+
+    {
+        TRACE_ZONE("outer");
+        TRACE_ZONE("inner");
+    }
+
+    std::ostringstream out;
+    trace::write_json(out);
+
+    EXPECT_THAT(out.str(), HasSubstr("\"name\":\"outer\""));
+    EXPECT_THAT(out.str(), HasSubstr("\"name\":\"inner\""));
+    EXPECT_EQ(count(out.str(), "\"ph\":\"X\""), 2u);
+}
+
+TEST(trace_test, keeps_events_of_finished_threads)
+{
+    trace::clear();
+
+    std::thread worker([] {
+        for (int i = 0; i != 100; ++i) { TRACE_ZONE("worker"); }
+    });
+    worker.join();
+
+    std::ostringstream out;
+    trace::write_json(out);
+
+    EXPECT_EQ(count(out.str(), "\"name\":\"worker\""), 100u);
+}
+
+TEST(trace_test, ring_keeps_the_most_recent_events)
+{
+    trace::thread_buffer buffer(4, 0);
+    for (int64_t i = 0; i != 10; ++i) { buffer.record("zone", i, i + 1); }
+
+    std::vector<int64_t> begins;
+    buffer.for_each([&begins](const char*, int64_t begin, int64_t) {
+        begins.push_back(begin);
+    });
+
+    // slot 6 is the next one written, a reader can't tell it complete
+    EXPECT_THAT(begins, ::testing::ElementsAre(7, 8, 9));
+
+    // a ring that hasn't wrapped yet keeps all of its events
+    trace::thread_buffer partial(4, 0);
+    for (int64_t i = 0; i != 3; ++i) { partial.record("zone", i, i + 1); }
+
+    begins.clear();
+    partial.for_each([&begins](const char*, int64_t begin, int64_t) {
+        begins.push_back(begin);
+    });
+    EXPECT_THAT(begins, ::testing::ElementsAre(0, 1, 2));
+}
+
+TEST(trace_test, escapes_names)
+{
+    trace::clear();
+
+    { TRACE_ZONE("say \"hi\""); }
+
+    std::ostringstream out;
+    trace::write_json(out);
+
+    EXPECT_THAT(out.str(), HasSubstr("say \\\"hi\\\""));
+}
+
+} // namespace
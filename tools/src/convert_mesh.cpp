@@ -0,0 +1,222 @@
+#include <array>
+#include <cstdlib> // EXIT_SUCCESS
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "gltf.hpp"
+#include "mesh_file.hpp"
+#include "obj.hpp"
+#include "spdlog_all.hpp"
+
+// converts Wavefront OBJ meshes and glTF 2.0 scenes into mesh files:
+//
+//   materialist_convert_mesh input.obj output.mesh
+//   materialist_convert_mesh input.gltf output.mesh
+//
+// polygons are triangulated as fans, missing normals are computed from the
+// faces, and the mesh is centered and scaled into the unit sphere. A glTF
+// scene is flattened into one mesh with its node transforms applied
+
+namespace /* anonymous */ {
+
+using vec3 = std::array<float, 3>;
+
+vec3
+subtract(const vec3& a, const vec3& b) noexcept
+{
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+vec3
+cross(const vec3& a, const vec3& b) noexcept
+{
+    return {
+        a[1] * b[2] - a[2] * b[1],
+        a[2] * b[0] - a[0] * b[2],
+        a[0] * b[1] - a[1] * b[0]};
+}
+
+// OBJ is y-up with counter-clockwise front faces, viewed from +z; the
+// renderer draws y-down with clockwise front faces, viewed from -z. Half a
+// turn around x keeps the mesh upright and facing the viewer, and the
+// winding is reversed as well
+vec3
+to_materialist_axes(const vec3& v) noexcept
+{
+    return {v[0], -v[1], -v[2]};
+}
+
+bool
+read_obj(const std::string& path, obj::mesh& o) noexcept
+{
+    std::ifstream file(path);
+    if (!file) { return false; }
+
+    auto m = obj::parse(file);
+    if (!m) {
+        spdlog::error("{} references a missing vertex", path);
+        return false;
+    }
+
+    o = std::move(*m);
+    return true;
+}
+
+// area-weighted face normals summed per position, for corners without one
+std::vector<vec3>
+position_normals(const obj::mesh& o) noexcept
+{
+    std::vector<vec3> normals(o.positions.size(), vec3{0.f, 0.f, 0.f});
+    for (size_t i = 0; i + 3 <= o.corners.size(); i += 3) {
+        const auto& a = o.positions[size_t(o.corners[i].position)];
+        const auto& b = o.positions[size_t(o.corners[i + 1].position)];
+        const auto& c = o.positions[size_t(o.corners[i + 2].position)];
+
+        // counter-clockwise front faces, as OBJ defines them
+        const auto face = cross(subtract(b, a), subtract(c, a));
+        for (size_t k = i; k != i + 3; ++k) {
+            auto& n = normals[size_t(o.corners[k].position)];
+            for (size_t axis = 0; axis != 3; ++axis) { n[axis] += face[axis]; }
+        }
+    }
+    return normals;
+}
+
+bool
+pack_obj(
+    const std::string&              input,
+    std::vector<mesh_file::vertex>& vertices,
+    std::vector<uint32_t>&          indices) noexcept
+{
+    obj::mesh o;
+    if (!read_obj(input, o)) { return false; }
+    if (o.corners.empty()) { return true; }
+
+    vec3 min = o.positions[size_t(o.corners.front().position)];
+    vec3 max = min;
+    for (const auto& c : o.corners) {
+        const auto& p = o.positions[size_t(c.position)];
+        for (size_t axis = 0; axis != 3; ++axis) {
+            min[axis] = std::min(min[axis], p[axis]);
+            max[axis] = std::max(max[axis], p[axis]);
+        }
+    }
+
+    const vec3 center = {
+        (min[0] + max[0]) * .5f,
+        (min[1] + max[1]) * .5f,
+        (min[2] + max[2]) * .5f};
+    float radius = 0.f;
+    for (const auto& c : o.corners) {
+        radius = std::max(
+            radius,
+            mesh_file::length(
+                subtract(o.positions[size_t(c.position)], center)));
+    }
+    const auto scale = radius != 0.f ? 1.f / radius : 1.f;
+
+    const auto computed_normals = position_normals(o);
+
+    std::unordered_map<obj::corner, uint32_t, obj::corner_hash> unique;
+    indices.reserve(o.corners.size());
+    for (size_t i = 0; i != o.corners.size(); ++i) {
+        // reversed winding, see to_materialist_axes()
+        const auto& c = o.corners[i - i % 3 + (3 - i % 3) % 3];
+
+        auto [it, inserted] = unique.try_emplace(c, uint32_t(vertices.size()));
+        if (inserted) {
+            const auto p = subtract(o.positions[size_t(c.position)], center);
+            vertices.push_back(mesh_file::pack(
+                to_materialist_axes({p[0] * scale, p[1] * scale, p[2] * scale}),
+                to_materialist_axes(
+                    c.normal >= 0 ? o.normals[size_t(c.normal)] :
+                                    computed_normals[size_t(c.position)]),
+                c.uv >= 0 ? o.uvs[size_t(c.uv)] : std::array{0.f, 0.f}));
+        }
+        indices.push_back(it->second);
+    }
+
+    return true;
+}
+
+// every primitive of the displayed scene, already in the renderer's axes
+// and unit sphere, see gltf::place()
+bool
+pack_gltf(
+    const std::string&              input,
+    std::vector<mesh_file::vertex>& vertices,
+    std::vector<uint32_t>&          indices) noexcept
+{
+    const auto a = gltf::load(input);
+    if (!a) { return false; }
+
+    const auto p = gltf::place(a->doc);
+    for (const auto& item : p.items) {
+        const auto m = gltf::decode(*a, p, item);
+        if (!m) {
+            spdlog::warn(
+                "skipping primitive {} of mesh {}", item.primitive, item.mesh);
+            continue;
+        }
+
+        const auto base = uint32_t(vertices.size());
+        vertices.insert(end(vertices), begin(m->vertices), end(m->vertices));
+        for (auto index : m->indices) { indices.push_back(base + index); }
+    }
+
+    return true;
+}
+
+bool
+ends_with(std::string_view text, std::string_view suffix) noexcept
+{
+    return text.size() >= suffix.size() &&
+           text.substr(text.size() - suffix.size()) == suffix;
+}
+
+bool
+convert(const std::string& input, const std::string& output) noexcept
+{
+    std::vector<mesh_file::vertex> vertices;
+    std::vector<uint32_t>          indices;
+
+    const bool is_gltf = ends_with(input, ".gltf") || ends_with(input, ".glb");
+    if (!(is_gltf ? pack_gltf : pack_obj)(input, vertices, indices)) {
+        spdlog::error("failed to read {}", input);
+        return false;
+    }
+    if (indices.empty()) {
+        spdlog::error("{} has no faces", input);
+        return false;
+    }
+
+    const auto meshlets = mesh_file::build_meshlets(vertices, indices);
+    if (!mesh_file::write(output, vertices, indices, meshlets)) {
+        spdlog::error("failed to write {}", output);
+        return false;
+    }
+
+    spdlog::info(
+        "{}: {} vertices, {} triangles, {} meshlets",
+        output,
+        vertices.size(),
+        indices.size() / 3,
+        meshlets.size());
+    return true;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    if (argc != 3) {
+        spdlog::error("usage: {} input.obj|gltf|glb output.mesh", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    return convert(argv[1], argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+}